@@ -18,17 +18,51 @@
 ///
 /// If the above requirements are fulfilled, you can use the allocator with any
 /// container in this library.
+///
+/// ## Reallocation
+///
+/// An allocator may optionally provide a method
+/// `T* reallocate(T* ptr, zen::size_t old_sz, zen::size_t new_sz)` that
+/// resizes a block that was returned by `allocate(old_sz)`. It works like
+/// `realloc`: the first `min(old_sz, new_sz)` elements are preserved
+/// bytewise, the returned block may live at a different address, and a
+/// `nullptr` result means that the block could not be resized and that `ptr`
+/// is still valid.
+///
+/// Containers only use this method for element types that are
+/// IsTriviallyRelocatable, and fall back to allocate-copy-free when it fails.
+/// Use CanReallocate to check whether a container may call it.
 
 #ifndef ZEN_ALLOCATOR_HPP
 #define ZEN_ALLOCATOR_HPP
 
 #include <stddef.h>
 #include <malloc.h>
+#include <string.h>
+
+#include <new>
+#include <type_traits>
+#include <utility>
 
 #include "zen/config.h"
+#include "zen/meta.hpp"
+
+#if !defined(ZEN_HUGE_PAGES) && defined(__linux__)
+# define ZEN_HUGE_PAGES 1
+#endif
 
 ZEN_NAMESPACE_START
 
+/// \brief Whether moving a `T` to a new address and ending the lifetime of the
+/// old object is equivalent to copying its bytes.
+///
+/// Containers use this trait to relocate their elements with a single
+/// `memcpy` instead of a move-construct/destroy pair per element. It defaults
+/// to trivially copyable types, but may be specialized for types that are
+/// safe to move bitwise, such as most smart pointers.
+template<typename T, typename Enabler = void>
+struct IsTriviallyRelocatable : Bool<std::is_trivially_copyable<T>::value> {};
+
 template<typename T>
 class SystemAllocator {
 public:
@@ -38,14 +72,148 @@ public:
   }
 
   inline void free(T* ptr, size_t sz) {
-    free(ptr);
+    ::free(ptr);
+  }
+
+  inline T* reallocate(T* ptr, size_t old_sz, size_t new_sz) {
+    static_assert(IsTriviallyRelocatable<T>::value, "reallocate() can only move trivially relocatable elements");
+    return static_cast<T*>(realloc(ptr, new_sz * sizeof(T)));
   }
 
 };
 
+#if ZEN_THREAD_CACHING_ALLOCATOR
+
+template<typename T>
+class ThreadCachingAllocator;
+
 template<typename T>
-using DefaultAllocator = SystemAllocator<T>;
+using _SmallDefaultAllocator = ThreadCachingAllocator<T>;
+
+#else
+
+template<typename T>
+using _SmallDefaultAllocator = SystemAllocator<T>;
+
+#endif
+
+#if ZEN_HUGE_PAGES
+
+template<typename T, template<typename> class SmallAllocatorT>
+class HugePageAwareAllocator;
+
+/// \brief The allocator that containers use unless they are given another
+/// one.
+///
+/// Large buffers are mapped with huge pages. \see huge_page_allocator.hpp
+///
+/// Everything else goes to `malloc`, or to ThreadCachingAllocator if the
+/// library was built with `ZEN_THREAD_CACHING_ALLOCATOR`.
+template<typename T>
+using DefaultAllocator = HugePageAwareAllocator<T, _SmallDefaultAllocator>;
+
+#else
+
+template<typename T>
+using DefaultAllocator = _SmallDefaultAllocator<T>;
+
+#endif
+
+/// \brief Get an allocator of the same kind as `AllocatorT` that allocates
+/// objects of type `U`.
+///
+/// Node-based containers use this to allocate their nodes with the allocator
+/// that was given for their elements. It works out of the box for allocators
+/// that are templates over their element type.
+template<typename AllocatorT, typename U>
+struct RebindAllocator;
+
+template<template<typename> class AllocatorT, typename T, typename U>
+struct RebindAllocator<AllocatorT<T>, U> {
+  using Type = AllocatorT<U>;
+};
+
+template<typename AllocatorT, typename U>
+using RebindAllocatorT = typename RebindAllocator<AllocatorT, U>::Type;
+
+/// \brief Get an allocator for objects of type `U` that allocates from the
+/// same place as `allocator`.
+///
+/// Stateful allocators such as ArenaAllocator are expected to be
+/// constructible from an allocator of another element type. Allocators that
+/// are not are assumed to be stateless and are default-constructed.
+template<typename U, typename AllocatorT>
+inline RebindAllocatorT<AllocatorT, U> rebind_allocator(const AllocatorT& allocator) {
+  using ResultT = RebindAllocatorT<AllocatorT, U>;
+  if constexpr (std::is_constructible_v<ResultT, const AllocatorT&>) {
+    return ResultT(allocator);
+  } else {
+    return ResultT();
+  }
+}
+
+/// \brief Whether `AllocatorT` provides the optional `reallocate()` method.
+template<typename AllocatorT, typename Enabler = void>
+struct HasReallocate : False {};
+
+template<typename AllocatorT>
+struct HasReallocate<
+  AllocatorT,
+  VoidT<decltype(declval<AllocatorT&>().reallocate(nullptr, size_t(0), size_t(0)))>
+> : True {};
+
+/// \brief Whether a container holding elements of type `T` may grow its
+/// buffer with `AllocatorT::reallocate()`.
+template<typename AllocatorT, typename T>
+struct CanReallocate : Bool<HasReallocate<AllocatorT>::value && IsTriviallyRelocatable<T>::value> {};
+
+/// \brief Move `count` objects from `src` to the uninitialized memory at `dst`.
+///
+/// After this call the objects in `src` no longer exist and the memory may
+/// be released without running any destructors. The two regions may not
+/// overlap.
+template<typename T, typename SizeT>
+inline void relocate_n(T* src, SizeT count, T* dst) {
+  if constexpr (IsTriviallyRelocatable<T>::value) {
+    if (count > 0) {
+      memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(T));
+    }
+  } else {
+    for (SizeT i = 0; i < count; i++) {
+      new (dst + i) T(std::move(src[i]));
+      src[i].~T();
+    }
+  }
+}
+
+/// \brief Move the `count` objects at `ptr` `offset` slots towards the end
+/// of the same buffer.
+///
+/// This opens a gap of `offset` uninitialized slots at `ptr`, which is how
+/// containers make room for elements that are inserted in the middle. The
+/// buffer must have room for `count + offset` objects.
+template<typename T, typename SizeT>
+inline void shift_back_n(T* ptr, SizeT count, SizeT offset) {
+  if constexpr (IsTriviallyRelocatable<T>::value) {
+    if (count > 0) {
+      memmove(static_cast<void*>(ptr + offset), static_cast<const void*>(ptr), count * sizeof(T));
+    }
+  } else {
+    for (SizeT i = count; i > 0; i--) {
+      new (ptr + i - 1 + offset) T(std::move(ptr[i-1]));
+      ptr[i-1].~T();
+    }
+  }
+}
 
 ZEN_NAMESPACE_END
 
+#if ZEN_THREAD_CACHING_ALLOCATOR
+# include "zen/thread_caching_allocator.hpp"
+#endif
+
+#if ZEN_HUGE_PAGES
+# include "zen/huge_page_allocator.hpp"
+#endif
+
 #endif // of #ifndef ZEN_ALLOCATOR_HPP
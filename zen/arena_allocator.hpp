@@ -0,0 +1,288 @@
+/// \file arena_allocator.hpp
+/// \brief An allocator for objects that are all released at the same time.
+
+#ifndef ZEN_ARENA_ALLOCATOR_HPP
+#define ZEN_ARENA_ALLOCATOR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+#include "zen/macros.h"
+
+ZEN_NAMESPACE_START
+
+struct ArenaChunk {
+
+  ArenaChunk* next;
+
+  /// The amount of bytes that can be allocated from this chunk.
+  size_t size;
+
+  inline char* data() {
+    return reinterpret_cast<char*>(this + 1);
+  }
+
+};
+
+/// \brief A region of memory that is handed out by bumping a pointer.
+///
+/// Memory is taken from large chunks. Individual allocations are never
+/// returned to the system; instead, the whole arena is rolled back at once
+/// with reset() or rewind(). Chunks are kept after a rollback, so an arena
+/// that is reused for similar work, such as one request or one parse, stops
+/// allocating from the system after the first round.
+///
+/// An arena does not run destructors. Objects that own resources outside of
+/// the arena must be destroyed before the arena is rolled back.
+class Arena {
+
+  ArenaChunk* _first = nullptr;
+  ArenaChunk* _current = nullptr;
+  size_t _offset = 0;
+  size_t _chunk_size;
+
+  static inline Arena*& current_slot() {
+    static thread_local Arena* arena = nullptr;
+    return arena;
+  }
+
+  /// Make the chunk after the current one active, inserting a new chunk if
+  /// there is none or if it cannot hold `min_size` bytes.
+  inline void next_chunk(size_t min_size) {
+    auto next = _current == nullptr ? _first : _current->next;
+    if (next == nullptr || next->size < min_size) {
+      auto size = min_size > _chunk_size ? min_size : _chunk_size;
+      auto chunk = static_cast<ArenaChunk*>(malloc(sizeof(ArenaChunk) + size));
+      ZEN_ASSERT(chunk != nullptr);
+      chunk->size = size;
+      chunk->next = next;
+      if (_current == nullptr) {
+        _first = chunk;
+      } else {
+        _current->next = chunk;
+      }
+      next = chunk;
+    }
+    _current = next;
+    _offset = 0;
+  }
+
+  /// Whether the block of `size` bytes at `ptr` is the last one that was
+  /// allocated from the current chunk.
+  inline bool is_last(void* ptr, size_t size) const {
+    if (_current == nullptr) {
+      return false;
+    }
+    auto start = _current->data();
+    auto p = static_cast<char*>(ptr);
+    return p >= start && p + size == start + _offset;
+  }
+
+public:
+
+  static constexpr size_t default_chunk_size = 64 * 1024;
+
+  /// \brief A position in an arena that it can be rolled back to.
+  struct Mark {
+    ArenaChunk* chunk;
+    size_t offset;
+  };
+
+  inline Arena(size_t chunk_size = default_chunk_size):
+    _chunk_size(chunk_size) {}
+
+  Arena(const Arena& other) = delete;
+  Arena& operator=(const Arena& other) = delete;
+
+  inline ~Arena() {
+    release();
+  }
+
+  /// \brief Get the arena of the innermost ArenaScope of this thread, or
+  /// `nullptr` if there is none.
+  static inline Arena* current() {
+    return current_slot();
+  }
+
+  /// \brief Allocate `size` bytes that are aligned to `alignment`, which
+  /// must be a power of two.
+  inline void* allocate(size_t size, size_t alignment = alignof(max_align_t)) {
+    for (;;) {
+      if (_current != nullptr) {
+        auto start = reinterpret_cast<uintptr_t>(_current->data());
+        auto ptr = (start + _offset + alignment - 1) & ~uintptr_t(alignment - 1);
+        if (ptr + size <= start + _current->size) {
+          _offset = ptr + size - start;
+          return reinterpret_cast<void*>(ptr);
+        }
+      }
+      next_chunk(size + alignment - 1);
+    }
+  }
+
+  /// \brief Give back a block if it was the last one that was allocated.
+  ///
+  /// Other blocks are only reclaimed when the arena is rolled back.
+  inline void free(void* ptr, size_t size) {
+    if (is_last(ptr, size)) {
+      _offset = static_cast<char*>(ptr) - _current->data();
+    }
+  }
+
+  /// \brief Resize the block at `ptr` without moving it.
+  ///
+  /// This succeeds when the block becomes smaller, or when it is the last
+  /// block of its chunk and the chunk has enough room left.
+  inline bool resize(void* ptr, size_t old_size, size_t new_size) {
+    if (is_last(ptr, old_size)) {
+      auto end = static_cast<char*>(ptr) - _current->data() + new_size;
+      if (end > _current->size) {
+        return false;
+      }
+      _offset = end;
+      return true;
+    }
+    return new_size <= old_size;
+  }
+
+  /// \brief Get the current position of this arena.
+  inline Mark mark() const {
+    return Mark { _current, _offset };
+  }
+
+  /// \brief Release everything that was allocated after `mark` was taken.
+  inline void rewind(Mark mark) {
+    _current = mark.chunk;
+    _offset = mark.offset;
+  }
+
+  /// \brief Release everything that was allocated from this arena.
+  ///
+  /// This takes constant time. The chunks stay around for later
+  /// allocations; use release() to give them back to the system.
+  inline void reset() {
+    _current = nullptr;
+    _offset = 0;
+  }
+
+  /// \brief Release everything and give all chunks back to the system.
+  inline void release() {
+    auto chunk = _first;
+    while (chunk != nullptr) {
+      auto next = chunk->next;
+      ::free(chunk);
+      chunk = next;
+    }
+    _first = nullptr;
+    reset();
+  }
+
+  /// \brief Get the amount of bytes that this arena took from the system.
+  inline size_t bytes_reserved() const {
+    size_t total = 0;
+    for (auto chunk = _first; chunk != nullptr; chunk = chunk->next) {
+      total += chunk->size;
+    }
+    return total;
+  }
+
+  friend class ArenaScope;
+
+};
+
+/// \brief Roll an arena back to where it was when the scope started.
+///
+/// While the scope is alive, its arena is also the current arena of this
+/// thread, which is what default-constructed ArenaAllocators use. Scopes can
+/// be nested.
+///
+/// ```
+/// Arena arena;
+/// for (auto& request: requests) {
+///   ArenaScope scope(arena);
+///   Vector<Token, size_t, ArenaAllocator<Token>> tokens;
+///   // ...
+/// }
+/// ```
+///
+/// Containers that allocate from the arena must be destroyed before the
+/// scope ends, which is easiest to get right by declaring them after it.
+class ArenaScope {
+
+  Arena& _arena;
+  Arena::Mark _mark;
+  Arena* _previous;
+
+public:
+
+  inline ArenaScope(Arena& arena):
+    _arena(arena), _mark(arena.mark()), _previous(Arena::current_slot()) {
+      Arena::current_slot() = &arena;
+    }
+
+  ArenaScope(const ArenaScope& other) = delete;
+  ArenaScope& operator=(const ArenaScope& other) = delete;
+
+  inline ~ArenaScope() {
+    _arena.rewind(_mark);
+    Arena::current_slot() = _previous;
+  }
+
+};
+
+/// \brief An allocator that takes its memory from an Arena.
+///
+/// A default-constructed allocator uses the arena of the innermost
+/// ArenaScope of the thread that created it, so that containers that rebind
+/// their allocator end up in the same arena.
+///
+/// free() is almost free: memory only comes back when the arena is rolled
+/// back. reallocate() grows the last allocation of an arena in place, which
+/// makes a Vector that is filled while nothing else is allocated as cheap as
+/// a bump of a pointer per growth step.
+template<typename T>
+class ArenaAllocator {
+
+  template<typename U>
+  friend class ArenaAllocator;
+
+  Arena* _arena;
+
+public:
+
+  inline ArenaAllocator():
+    _arena(Arena::current()) {}
+
+  inline ArenaAllocator(Arena& arena):
+    _arena(&arena) {}
+
+  template<typename U>
+  inline ArenaAllocator(const ArenaAllocator<U>& other):
+    _arena(other._arena) {}
+
+  inline Arena* arena() const {
+    return _arena;
+  }
+
+  inline T* allocate(size_t sz) {
+    ZEN_ASSERT(_arena != nullptr);
+    return static_cast<T*>(_arena->allocate(sz * sizeof(T), alignof(T)));
+  }
+
+  inline void free(T* ptr, size_t sz) {
+    _arena->free(ptr, sz * sizeof(T));
+  }
+
+  inline T* reallocate(T* ptr, size_t old_sz, size_t new_sz) {
+    static_assert(IsTriviallyRelocatable<T>::value, "reallocate() can only move trivially relocatable elements");
+    return _arena->resize(ptr, old_sz * sizeof(T), new_sz * sizeof(T)) ? ptr : nullptr;
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_ARENA_ALLOCATOR_HPP
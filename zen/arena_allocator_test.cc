@@ -0,0 +1,66 @@
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+
+#include "zen/arena_allocator.hpp"
+#include "zen/dllist.hpp"
+#include "zen/vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(ArenaAllocatorTest, RewindsToMarkAndReusesChunks) {
+  Arena arena(1024);
+  auto a = static_cast<char*>(arena.allocate(100));
+  auto mark = arena.mark();
+  auto b = static_cast<char*>(arena.allocate(800));
+  auto c = static_cast<char*>(arena.allocate(800));
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(max_align_t), 0);
+  ASSERT_NE(b, c);
+  auto reserved = arena.bytes_reserved();
+  arena.rewind(mark);
+  ASSERT_EQ(arena.allocate(800), b);
+  ASSERT_EQ(arena.allocate(800), c);
+  arena.reset();
+  ASSERT_EQ(arena.allocate(100), a);
+  ASSERT_EQ(arena.bytes_reserved(), reserved);
+  auto big = arena.allocate(100000);
+  ASSERT_NE(big, nullptr);
+  arena.release();
+  ASSERT_EQ(arena.bytes_reserved(), 0);
+}
+
+TEST(ArenaAllocatorTest, GrowsLastAllocationInPlace) {
+  Arena arena;
+  ArenaAllocator<uint32_t> allocator(arena);
+  auto ptr = allocator.allocate(10);
+  ASSERT_EQ(allocator.reallocate(ptr, 10, 1000), ptr);
+  auto other = allocator.allocate(1);
+  ASSERT_EQ(other, ptr + 1000);
+  ASSERT_EQ(allocator.reallocate(ptr, 1000, 2000), nullptr);
+  ASSERT_EQ(allocator.reallocate(ptr, 1000, 500), ptr);
+  allocator.free(other, 1);
+  ASSERT_EQ(allocator.allocate(1), other);
+}
+
+TEST(ArenaAllocatorTest, ScopesProvideAllocatorsForContainers) {
+  Arena arena;
+  ASSERT_EQ(Arena::current(), nullptr);
+  auto fill = [&]() {
+    ArenaScope scope(arena);
+    ASSERT_EQ(Arena::current(), &arena);
+    Vector<uint64_t, size_t, ArenaAllocator<uint64_t>> v1;
+    DLList<int, size_t, ArenaAllocator<int>> l1;
+    for (uint64_t i = 0; i < 10000; i++) {
+      v1.append(i);
+      l1.append(int(i));
+    }
+    ASSERT_EQ(v1[9999], 9999);
+    ASSERT_EQ(l1.last(), 9999);
+  };
+  fill();
+  ASSERT_EQ(Arena::current(), nullptr);
+  auto reserved = arena.bytes_reserved();
+  fill();
+  ASSERT_EQ(arena.bytes_reserved(), reserved);
+}
@@ -0,0 +1,339 @@
+/// \file bit_vector.hpp
+/// \brief A compact sequence of booleans with fast bulk operations.
+
+#ifndef ZEN_BIT_VECTOR_HPP
+#define ZEN_BIT_VECTOR_HPP
+
+#include <stdint.h>
+
+#include <utility>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+#include "zen/macros.h"
+#include "zen/range.hpp"
+#include "zen/simd.hpp"
+#include "zen/vector.hpp"
+
+ZEN_NAMESPACE_START
+
+/// \brief Iterates over the indices of the bits that are set in a sequence of
+/// words.
+class SetBitIter {
+
+  const uint64_t* words;
+  size_t word_count;
+  size_t word_index;
+  uint64_t remaining;
+
+  inline void skip_empty() {
+    while (remaining == 0 && word_index < word_count) {
+      if (++word_index < word_count) {
+        remaining = words[word_index];
+      }
+    }
+  }
+
+public:
+
+  using Value = size_t;
+  using Size = size_t;
+  using Diff = ptrdiff_t;
+
+  using value_type = Value;
+
+  inline SetBitIter(const uint64_t* words, size_t word_count, size_t word_index):
+    words(words),
+    word_count(word_count),
+    word_index(word_index),
+    remaining(word_index < word_count ? words[word_index] : 0) {
+      skip_empty();
+    }
+
+  bool operator==(const SetBitIter& other) const {
+    return other.word_index == word_index && other.remaining == remaining;
+  }
+
+  bool operator!=(const SetBitIter& other) const {
+    return !(*this == other);
+  }
+
+  size_t operator*() const {
+    return word_index * 64 + __builtin_ctzll(remaining);
+  }
+
+  SetBitIter& operator++() {
+    remaining &= remaining - 1;
+    skip_empty();
+    return *this;
+  }
+
+};
+
+/// \brief A sequence of bits that is stored 64 to a word.
+///
+/// Besides reading and writing individual bits, a BitVector supports
+/// operations that work on whole words at once:
+///
+///  - count(), rank() and select() use the POPCNT instruction when it is
+///    available
+///  - the bulk operators `&=`, `|=`, `^=` and and_not() combine two vectors
+///    of equal size using SIMD instructions
+///  - find_first_set() skips over empty words in chunks
+///
+/// Use set_bits() to iterate over the indices of all bits that are set:
+///
+/// ```
+/// BitVector reachable(state_count);
+/// reachable.set(start);
+/// for (auto state: reachable.set_bits()) {
+///   // ...
+/// }
+/// ```
+///
+/// All bits past size() in the last word are kept at zero, so that the word
+/// operations never have to mask them out.
+template<typename AllocatorT = DefaultAllocator<uint64_t>>
+class BitVector {
+public:
+
+  using Word = uint64_t;
+  using Value = bool;
+  using Size = size_t;
+  using SetBitRange = IterRange<SetBitIter>;
+
+  using value_type = Value;
+  using size_type = Size;
+
+  static constexpr size_t word_bits = 64;
+
+private:
+
+  Vector<Word, size_t, AllocatorT> _words;
+  size_t _sz;
+
+  static inline size_t word_count(size_t sz) {
+    return (sz + word_bits - 1) / word_bits;
+  }
+
+  /// Zero the bits of the last word that are not part of this vector.
+  inline void clear_padding() {
+    auto used = _sz % word_bits;
+    if (used > 0) {
+      _words[_words.size() - 1] &= (Word(1) << used) - 1;
+    }
+  }
+
+public:
+
+  /// \brief Create a vector of `sz` bits that are all set to `value`.
+  inline BitVector(size_t sz = 0, bool value = false):
+    _words(0), _sz(0) {
+      resize(sz, value);
+    }
+
+  inline bool operator[](size_t index) const {
+    ZEN_ASSERT(index < _sz);
+    return (_words.data()[index / word_bits] >> (index % word_bits)) & 1;
+  }
+
+  inline void set(size_t index, bool value = true) {
+    ZEN_ASSERT(index < _sz);
+    auto& word = _words[index / word_bits];
+    auto bit = Word(1) << (index % word_bits);
+    word = value ? word | bit : word & ~bit;
+  }
+
+  inline void reset(size_t index) {
+    set(index, false);
+  }
+
+  inline void flip(size_t index) {
+    ZEN_ASSERT(index < _sz);
+    _words[index / word_bits] ^= Word(1) << (index % word_bits);
+  }
+
+  /// \brief Set all bits to `value`.
+  inline void fill(bool value) {
+    for (auto& word: _words) {
+      word = value ? ~Word(0) : 0;
+    }
+    clear_padding();
+  }
+
+  inline void append(bool value) {
+    if (_sz % word_bits == 0) {
+      _words.append(0);
+    }
+    _sz++;
+    if (value) {
+      set(_sz - 1);
+    }
+  }
+
+  /// \brief Change the amount of bits in this vector, setting new bits to
+  /// `value`.
+  inline void resize(size_t new_sz, bool value = false) {
+    if (new_sz > _sz && value) {
+      auto used = _sz % word_bits;
+      if (used > 0) {
+        _words[_words.size() - 1] |= ~Word(0) << used;
+      }
+    }
+    _words.resize(word_count(new_sz), value ? ~Word(0) : 0);
+    _sz = new_sz;
+    clear_padding();
+  }
+
+  /// \brief Count the bits that are set.
+  inline size_t count() const {
+    return simd_popcount(_words.data(), word_count(_sz));
+  }
+
+  /// \brief Count the bits that are set before `index`.
+  inline size_t rank(size_t index) const {
+    ZEN_ASSERT(index <= _sz);
+    auto words = _words.data();
+    auto result = simd_popcount(words, index / word_bits);
+    auto used = index % word_bits;
+    if (used > 0) {
+      result += __builtin_popcountll(words[index / word_bits] & ((Word(1) << used) - 1));
+    }
+    return result;
+  }
+
+  /// \brief Get the index of the set bit that has `rank` set bits before it.
+  ///
+  /// Returns size() if fewer than `rank + 1` bits are set.
+  inline size_t select(size_t rank) const {
+    // Skip over blocks of words using the bulk popcount before narrowing the
+    // search down to a single word.
+    constexpr size_t block_words = 8;
+    auto words = _words.data();
+    auto count = word_count(_sz);
+    size_t i = 0;
+    for (; i + block_words <= count; i += block_words) {
+      auto block_count = simd_popcount(words + i, block_words);
+      if (rank < block_count) {
+        break;
+      }
+      rank -= block_count;
+    }
+    for (; i < count; i++) {
+      size_t ones = __builtin_popcountll(words[i]);
+      if (rank < ones) {
+        auto word = words[i];
+        for (; rank > 0; rank--) {
+          word &= word - 1;
+        }
+        return i * word_bits + __builtin_ctzll(word);
+      }
+      rank -= ones;
+    }
+    return _sz;
+  }
+
+  /// \brief Get the index of the first set bit at or after `start`, or
+  /// size() if there is none.
+  inline size_t find_first_set(size_t start = 0) const {
+    if (start >= _sz) {
+      return _sz;
+    }
+    auto words = _words.data();
+    auto count = word_count(_sz);
+    auto i = start / word_bits;
+    auto word = words[i] & (~Word(0) << (start % word_bits));
+    if (word == 0) {
+      i++;
+      i += simd_find_not(words + i, count - i, Word(0));
+      if (i == count) {
+        return _sz;
+      }
+      word = words[i];
+    }
+    return i * word_bits + __builtin_ctzll(word);
+  }
+
+  /// \brief Check whether at least one bit is set.
+  inline bool any() const {
+    return find_first_set() < _sz;
+  }
+
+  inline BitVector& operator&=(const BitVector& other) {
+    ZEN_ASSERT(other._sz == _sz);
+    simd_and(_words.data(), other._words.data(), word_count(_sz));
+    return *this;
+  }
+
+  inline BitVector& operator|=(const BitVector& other) {
+    ZEN_ASSERT(other._sz == _sz);
+    simd_or(_words.data(), other._words.data(), word_count(_sz));
+    return *this;
+  }
+
+  inline BitVector& operator^=(const BitVector& other) {
+    ZEN_ASSERT(other._sz == _sz);
+    simd_xor(_words.data(), other._words.data(), word_count(_sz));
+    return *this;
+  }
+
+  /// \brief Clear every bit that is set in `other`.
+  inline BitVector& and_not(const BitVector& other) {
+    ZEN_ASSERT(other._sz == _sz);
+    simd_and_not(_words.data(), other._words.data(), word_count(_sz));
+    return *this;
+  }
+
+  inline BitVector operator&(const BitVector& other) const {
+    BitVector result(*this);
+    result &= other;
+    return result;
+  }
+
+  inline BitVector operator|(const BitVector& other) const {
+    BitVector result(*this);
+    result |= other;
+    return result;
+  }
+
+  inline BitVector operator^(const BitVector& other) const {
+    BitVector result(*this);
+    result ^= other;
+    return result;
+  }
+
+  inline bool operator==(const BitVector& other) const {
+    return other._sz == _sz && simd_equal(_words.data(), other._words.data(), word_count(_sz));
+  }
+
+  inline bool operator!=(const BitVector& other) const {
+    return !(*this == other);
+  }
+
+  /// \brief Get the indices of all bits that are set, in ascending order.
+  inline SetBitRange set_bits() const {
+    auto words = _words.data();
+    auto count = word_count(_sz);
+    return make_iter_range(SetBitIter(words, count, 0), SetBitIter(words, count, count));
+  }
+
+  /// \brief Get the words that hold the bits of this vector.
+  ///
+  /// Bit `i` is stored in word `i / 64` at position `i % 64`.
+  inline const Word* data() const {
+    return _words.data();
+  }
+
+  inline bool is_empty() const {
+    return _sz == 0;
+  }
+
+  inline size_t size() const {
+    return _sz;
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_BIT_VECTOR_HPP
@@ -0,0 +1,114 @@
+
+#include "gtest/gtest.h"
+
+#include "zen/bit_vector.hpp"
+#include "zen/vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(BitVectorTest, CanSetAndGetBits) {
+  BitVector<> b1(130);
+  ASSERT_EQ(b1.size(), 130);
+  ASSERT_FALSE(b1.any());
+  b1.set(0);
+  b1.set(64);
+  b1.set(129);
+  b1.flip(3);
+  b1.flip(64);
+  ASSERT_TRUE(b1[0]);
+  ASSERT_TRUE(b1[3]);
+  ASSERT_FALSE(b1[64]);
+  ASSERT_TRUE(b1[129]);
+  b1.reset(0);
+  ASSERT_FALSE(b1[0]);
+  ASSERT_EQ(b1.count(), 2);
+}
+
+TEST(BitVectorTest, ResizesWithValue) {
+  BitVector<> b1(10, true);
+  b1.resize(200, true);
+  ASSERT_EQ(b1.count(), 200);
+  b1.resize(70);
+  ASSERT_EQ(b1.count(), 70);
+  b1.resize(300);
+  ASSERT_EQ(b1.count(), 70);
+  ASSERT_FALSE(b1[70]);
+  b1.append(true);
+  ASSERT_EQ(b1.size(), 301);
+  ASSERT_TRUE(b1[300]);
+  b1.fill(true);
+  ASSERT_EQ(b1.count(), 301);
+}
+
+TEST(BitVectorTest, CanRankAndSelect) {
+  BitVector<> b1(5000);
+  Vector<size_t> expected;
+  for (size_t i = 0; i < 5000; i += 7) {
+    b1.set(i);
+    expected.append(i);
+  }
+  ASSERT_EQ(b1.count(), expected.size());
+  for (size_t k = 0; k < expected.size(); k++) {
+    ASSERT_EQ(b1.select(k), expected[k]);
+    ASSERT_EQ(b1.rank(expected[k]), k);
+    ASSERT_EQ(b1.rank(expected[k] + 1), k + 1);
+  }
+  ASSERT_EQ(b1.select(expected.size()), 5000);
+  ASSERT_EQ(b1.rank(5000), expected.size());
+}
+
+TEST(BitVectorTest, FindsFirstSetBit) {
+  BitVector<> b1(10000);
+  ASSERT_EQ(b1.find_first_set(), 10000);
+  b1.set(9000);
+  b1.set(9001);
+  ASSERT_EQ(b1.find_first_set(), 9000);
+  ASSERT_EQ(b1.find_first_set(9001), 9001);
+  ASSERT_EQ(b1.find_first_set(9002), 10000);
+  ASSERT_EQ(b1.find_first_set(20000), 10000);
+}
+
+TEST(BitVectorTest, CombinesVectors) {
+  BitVector<> b1(1000);
+  BitVector<> b2(1000);
+  for (size_t i = 0; i < 1000; i += 2) {
+    b1.set(i);
+  }
+  for (size_t i = 0; i < 1000; i += 3) {
+    b2.set(i);
+  }
+  auto both = b1 & b2;
+  auto either = b1 | b2;
+  auto one = b1 ^ b2;
+  auto only_first = b1;
+  only_first.and_not(b2);
+  for (size_t i = 0; i < 1000; i++) {
+    bool x = i % 2 == 0;
+    bool y = i % 3 == 0;
+    ASSERT_EQ(both[i], x && y);
+    ASSERT_EQ(either[i], x || y);
+    ASSERT_EQ(one[i], x != y);
+    ASSERT_EQ(only_first[i], x && !y);
+  }
+  ASSERT_EQ(both.count(), 167);
+  ASSERT_TRUE(b1 == b1);
+  ASSERT_TRUE(b1 != b2);
+}
+
+TEST(BitVectorTest, IteratesOverSetBits) {
+  BitVector<> b1(1000);
+  Vector<size_t> expected { 1, 63, 64, 500, 999 };
+  for (auto i: expected) {
+    b1.set(i);
+  }
+  Vector<size_t> actual;
+  for (auto i: b1.set_bits()) {
+    actual.append(i);
+  }
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); i++) {
+    ASSERT_EQ(actual[i], expected[i]);
+  }
+  BitVector<> b2(1000);
+  ASSERT_TRUE(b2.set_bits().begin() == b2.set_bits().end());
+}
@@ -0,0 +1,570 @@
+/// \file concurrent_hash_map.hpp
+/// \brief A hash map that many threads can read and write at the same time.
+
+#ifndef ZEN_CONCURRENT_HASH_MAP_HPP
+#define ZEN_CONCURRENT_HASH_MAP_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+#include "zen/hash.hpp"
+#include "zen/hash_map.hpp"
+#include "zen/macros.h"
+#include "zen/maybe.hpp"
+#include "zen/vector.hpp"
+
+ZEN_NAMESPACE_START
+
+/// Get a small number that identifies the calling thread, used to spread
+/// threads over the reader counters of a ConcurrentHashMap.
+inline size_t _concurrent_thread_slot() {
+  static std::atomic<size_t> next_slot { 0 };
+  static thread_local size_t slot = next_slot++;
+  return slot;
+}
+
+/// Get the amount of ConcurrentHashMap read guards the calling thread holds,
+/// over all maps.
+///
+/// A writer that runs inside a visit() or for_each() callback must not wait
+/// for readers to drain, because it would be waiting for itself.
+inline size_t& _concurrent_read_depth() {
+  static thread_local size_t depth = 0;
+  return depth;
+}
+
+/// \brief An unordered map that supports concurrent reads and writes.
+///
+/// Entries are kept in chains of immutable nodes that hang off an array of
+/// buckets. The design has three parts:
+///
+///  - **Reads never lock.** Lookups follow the atomic bucket and chain
+///    pointers directly. Nodes that writers unlink are not freed right away;
+///    they are retired and only reclaimed once every reader that might still
+///    see them has left the map (a simple form of epoch-based reclamation).
+///    Readers announce themselves on one of several cache-line-sized
+///    counters, so that they do not contend with each other.
+///  - **Writes are striped.** A key always maps to the same one of
+///    `stripe_count` locks, regardless of the size of the table, so writers
+///    only block each other when their keys share a stripe.
+///  - **Resizing is incremental.** When the table becomes too full, a table
+///    of twice the size is attached to it. From then on, every write first
+///    moves a small batch of buckets to the new table. Moved buckets are
+///    marked, so that readers and writers know to continue in the new table.
+///    When the last bucket has been moved, the new table takes over.
+///
+/// Because nodes may be reclaimed as soon as a reader leaves the map, values
+/// cannot be handed out by reference. find() returns a copy, and visit()
+/// runs a function on the value while it is still protected.
+///
+/// ```
+/// ConcurrentHashMap<std::string, Symbol> symbols;
+/// symbols.insert("main", main_symbol);
+/// auto symbol = symbols.find("main");
+/// ```
+template<
+  typename K,
+  typename V,
+  typename HashT = Hash<K>,
+  typename AllocatorT = DefaultAllocator<HashMapEntry<K, V>>
+>
+class ConcurrentHashMap {
+public:
+
+  using Key = K;
+  using Size = size_t;
+
+  using key_type = K;
+  using mapped_type = V;
+  using size_type = size_t;
+
+  /// The amount of locks that writers are distributed over.
+  static constexpr size_t stripe_count = 64;
+
+private:
+
+  /// The amount of buckets a writer moves to the new table on every write.
+  static constexpr size_t migrate_batch = 16;
+
+  /// The amount of retired objects after which they are reclaimed.
+  static constexpr size_t reclaim_threshold = 256;
+
+  static constexpr size_t reader_slot_count = 64;
+
+  struct Node {
+    size_t hash;
+    K key;
+    V value;
+    std::atomic<Node*> next;
+  };
+
+  using Bucket = std::atomic<Node*>;
+
+  struct Table {
+    size_t size;
+    Bucket* buckets;
+    std::atomic<Table*> next { nullptr };
+    std::atomic<size_t> migrate_cursor { 0 };
+    std::atomic<size_t> migrated { 0 };
+  };
+
+  struct alignas(64) Stripe {
+    std::mutex mutex;
+    std::atomic<size_t> count { 0 };
+  };
+
+  struct alignas(64) ReaderSlot {
+    std::atomic<size_t> active[2] = {};
+  };
+
+  struct Retired {
+    void* ptr;
+    bool is_table;
+  };
+
+  using NodeAllocator = RebindAllocatorT<AllocatorT, Node>;
+  using TableAllocator = RebindAllocatorT<AllocatorT, Table>;
+  using BucketAllocator = RebindAllocatorT<AllocatorT, Bucket>;
+
+  HashT _hash;
+  NodeAllocator _node_allocator;
+  TableAllocator _table_allocator;
+  BucketAllocator _bucket_allocator;
+  std::atomic<Table*> _table;
+  Stripe _stripes[stripe_count];
+  ReaderSlot _readers[reader_slot_count];
+  std::atomic<size_t> _epoch { 0 };
+  std::mutex _retired_mutex;
+  Vector<Retired> _retired;
+  std::mutex _reclaim_mutex;
+
+  /// Marks a bucket whose nodes have been moved to the next table.
+  static inline Node* moved() {
+    return reinterpret_cast<Node*>(uintptr_t(1));
+  }
+
+  /// Protects all nodes and tables that are reachable while it is alive.
+  class ReadGuard {
+
+    ConcurrentHashMap& map;
+    std::atomic<size_t>* counter;
+
+  public:
+
+    inline ReadGuard(ConcurrentHashMap& map):
+      map(map) {
+        auto& slot = map._readers[_concurrent_thread_slot() % reader_slot_count];
+        for (;;) {
+          auto epoch = map._epoch.load();
+          counter = &slot.active[epoch & 1];
+          counter->fetch_add(1);
+          // If the epoch moved on in the meantime, the reclaimer might
+          // already have checked our counter.
+          if (map._epoch.load() == epoch) {
+            break;
+          }
+          counter->fetch_sub(1);
+        }
+        _concurrent_read_depth()++;
+      }
+
+    ReadGuard(const ReadGuard& other) = delete;
+    ReadGuard& operator=(const ReadGuard& other) = delete;
+
+    inline ~ReadGuard() {
+      counter->fetch_sub(1, std::memory_order_release);
+      _concurrent_read_depth()--;
+    }
+
+  };
+
+  inline size_t hash(const K& key) const {
+    return hash_int(_hash(key));
+  }
+
+  inline Stripe& stripe_for(size_t hash) {
+    return _stripes[hash & (stripe_count - 1)];
+  }
+
+  inline Table* make_table(size_t size) {
+    auto table = new (_table_allocator.allocate(1)) Table;
+    table->size = size;
+    table->buckets = _bucket_allocator.allocate(size);
+    ZEN_ASSERT(table->buckets != nullptr);
+    for (size_t i = 0; i < size; i++) {
+      new (table->buckets + i) Bucket(nullptr);
+    }
+    return table;
+  }
+
+  inline void free_table(Table* table) {
+    _bucket_allocator.free(table->buckets, table->size);
+    table->~Table();
+    _table_allocator.free(table, 1);
+  }
+
+  template<typename ...ForwardArgs>
+  inline Node* make_node(size_t hash, Node* next, ForwardArgs&& ...args) {
+    auto ptr = _node_allocator.allocate(1);
+    ZEN_ASSERT(ptr != nullptr);
+    return new (ptr) Node { hash, std::forward<ForwardArgs>(args)..., { next } };
+  }
+
+  inline void free_node(Node* node) {
+    node->~Node();
+    _node_allocator.free(node, 1);
+  }
+
+  /// Schedule `ptr` to be freed once no reader can reach it anymore.
+  ///
+  /// Returns `true` if enough objects have been retired to reclaim them.
+  inline bool retire(void* ptr, bool is_table) {
+    std::lock_guard<std::mutex> lock(_retired_mutex);
+    _retired.append(Retired { ptr, is_table });
+    return _retired.size() >= reclaim_threshold;
+  }
+
+  /// Free all retired objects. Must not be called while holding a
+  /// ReadGuard, because it waits for all current readers to leave.
+  ///
+  /// Does nothing if the calling thread is inside a callback of visit() or
+  /// for_each(). The retired objects are then reclaimed by a later write.
+  inline void reclaim() {
+    if (_concurrent_read_depth() > 0) {
+      return;
+    }
+    std::lock_guard<std::mutex> reclaim_lock(_reclaim_mutex);
+    Vector<Retired> retired;
+    {
+      std::lock_guard<std::mutex> lock(_retired_mutex);
+      retired.swap(_retired);
+    }
+    // Readers that entered before the flip count on the old parity, and
+    // readers that enter after it can no longer reach retired objects.
+    auto epoch = _epoch.fetch_add(1);
+    for (auto& slot: _readers) {
+      while (slot.active[epoch & 1].load() != 0) {
+        std::this_thread::yield();
+      }
+    }
+    for (auto& entry: retired) {
+      if (entry.is_table) {
+        free_table(static_cast<Table*>(entry.ptr));
+      } else {
+        free_node(static_cast<Node*>(entry.ptr));
+      }
+    }
+  }
+
+  /// Find the bucket that `hash` lives in, following moved buckets to the
+  /// table that currently owns them.
+  static inline Bucket& bucket_for(Table* table, size_t hash) {
+    for (;;) {
+      auto& bucket = table->buckets[hash & (table->size - 1)];
+      if (bucket.load(std::memory_order_acquire) != moved()) {
+        return bucket;
+      }
+      table = table->next.load(std::memory_order_acquire);
+    }
+  }
+
+  inline Node* find_node(size_t hash, const K& key) {
+    auto& bucket = bucket_for(_table.load(std::memory_order_acquire), hash);
+    for (auto node = bucket.load(std::memory_order_acquire); node != nullptr; node = node->next.load(std::memory_order_acquire)) {
+      if (node->hash == hash && node->key == key) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  /// Copy the nodes of bucket `index` of `table` to the next table.
+  ///
+  /// Returns `true` if any retired node should be reclaimed.
+  inline bool migrate_bucket(Table* table, size_t index) {
+    auto next = table->next.load(std::memory_order_acquire);
+    std::lock_guard<std::mutex> lock(_stripes[index & (stripe_count - 1)].mutex);
+    auto& bucket = table->buckets[index];
+    auto head = bucket.load(std::memory_order_relaxed);
+    // The old chain stays intact, so that readers that are walking it can
+    // simply finish.
+    for (auto node = head; node != nullptr; node = node->next.load(std::memory_order_relaxed)) {
+      auto& target = next->buckets[node->hash & (next->size - 1)];
+      target.store(make_node(node->hash, target.load(std::memory_order_relaxed), node->key, node->value), std::memory_order_release);
+    }
+    bucket.store(moved(), std::memory_order_release);
+    bool should_reclaim = false;
+    for (auto node = head; node != nullptr;) {
+      auto next_node = node->next.load(std::memory_order_relaxed);
+      should_reclaim |= retire(node, false);
+      node = next_node;
+    }
+    return should_reclaim;
+  }
+
+  /// Move a batch of buckets to the next table if a resize is in progress,
+  /// and install the next table once all buckets have been moved.
+  inline bool help_migrate() {
+    auto table = _table.load(std::memory_order_acquire);
+    auto next = table->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    auto begin = table->migrate_cursor.fetch_add(migrate_batch);
+    if (begin >= table->size) {
+      return false;
+    }
+    auto end = begin + migrate_batch < table->size ? begin + migrate_batch : table->size;
+    bool should_reclaim = false;
+    for (auto i = begin; i < end; i++) {
+      should_reclaim |= migrate_bucket(table, i);
+    }
+    if (table->migrated.fetch_add(end - begin) + (end - begin) == table->size) {
+      _table.store(next, std::memory_order_release);
+      should_reclaim |= retire(table, true);
+    }
+    return should_reclaim;
+  }
+
+  /// Attach a bigger table if the stripe of a new entry grew too full.
+  inline void maybe_grow(size_t stripe_size) {
+    auto table = _table.load(std::memory_order_acquire);
+    // Every stripe covers an equal share of the buckets, so aim for a load
+    // factor of at most 1 within each stripe.
+    if (stripe_size <= table->size / stripe_count || table->next.load() != nullptr) {
+      return;
+    }
+    auto next = make_table(table->size * 2);
+    Table* expected = nullptr;
+    if (!table->next.compare_exchange_strong(expected, next)) {
+      free_table(next);
+    }
+  }
+
+  template<typename ...ForwardArgs>
+  inline bool insert_impl(bool assign, K key, ForwardArgs&& ...args) {
+    auto h = hash(key);
+    bool inserted = false;
+    bool should_reclaim = false;
+    size_t stripe_size = 0;
+    {
+      ReadGuard guard(*this);
+      should_reclaim = help_migrate();
+      {
+        auto& stripe = stripe_for(h);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto& bucket = bucket_for(_table.load(std::memory_order_acquire), h);
+        auto link = &bucket;
+        Node* node = link->load(std::memory_order_relaxed);
+        for (; node != nullptr; node = node->next.load(std::memory_order_relaxed)) {
+          if (node->hash == h && node->key == key) {
+            break;
+          }
+          link = &node->next;
+        }
+        if (node == nullptr) {
+          link->store(make_node(h, nullptr, std::move(key), V(std::forward<ForwardArgs>(args)...)), std::memory_order_release);
+          stripe_size = ++stripe.count;
+          inserted = true;
+        } else if (assign) {
+          // Nodes are immutable, so replace the whole node.
+          auto replacement = make_node(h, node->next.load(std::memory_order_relaxed), std::move(key), V(std::forward<ForwardArgs>(args)...));
+          link->store(replacement, std::memory_order_release);
+          should_reclaim |= retire(node, false);
+        }
+      }
+      // The table is only safe to touch while the guard is alive.
+      if (inserted) {
+        maybe_grow(stripe_size);
+      }
+    }
+    if (should_reclaim) {
+      reclaim();
+    }
+    return inserted;
+  }
+
+  template<typename Fn>
+  inline void visit_bucket(Table* table, size_t index, Fn& fn) {
+    auto head = table->buckets[index].load(std::memory_order_acquire);
+    if (head == moved()) {
+      auto next = table->next.load(std::memory_order_acquire);
+      visit_bucket(next, index, fn);
+      visit_bucket(next, index + table->size, fn);
+      return;
+    }
+    for (auto node = head; node != nullptr; node = node->next.load(std::memory_order_acquire)) {
+      fn(static_cast<const K&>(node->key), static_cast<const V&>(node->value));
+    }
+  }
+
+public:
+
+  /// \brief Create an empty map with room for about `init_capacity`
+  /// entries.
+  inline ConcurrentHashMap(size_t init_capacity = 0, HashT hash = HashT()):
+    _hash(hash) {
+      size_t size = stripe_count;
+      while (size < init_capacity) {
+        size *= 2;
+      }
+      _table.store(make_table(size));
+    }
+
+  ConcurrentHashMap(const ConcurrentHashMap& other) = delete;
+  ConcurrentHashMap& operator=(const ConcurrentHashMap& other) = delete;
+
+  /// Must not run concurrently with any other method.
+  inline ~ConcurrentHashMap() {
+    for (auto table = _table.load(); table != nullptr;) {
+      for (size_t i = 0; i < table->size; i++) {
+        auto node = table->buckets[i].load();
+        if (node == moved()) {
+          continue;
+        }
+        while (node != nullptr) {
+          auto next_node = node->next.load();
+          free_node(node);
+          node = next_node;
+        }
+      }
+      auto next = table->next.load();
+      free_table(table);
+      table = next;
+    }
+    for (auto& entry: _retired) {
+      if (entry.is_table) {
+        free_table(static_cast<Table*>(entry.ptr));
+      } else {
+        free_node(static_cast<Node*>(entry.ptr));
+      }
+    }
+  }
+
+  /// \brief Get a copy of the value of `key`, if it is present.
+  inline Maybe<V> find(const K& key) {
+    ReadGuard guard(*this);
+    auto node = find_node(hash(key), key);
+    if (node == nullptr) {
+      return {};
+    }
+    return V(node->value);
+  }
+
+  /// \brief Call `fn` with a reference to the value of `key`, if it is
+  /// present.
+  ///
+  /// The reference must not be used after `fn` returns. Returns `false` if
+  /// the key was not found.
+  ///
+  /// `fn` may write to the map, but the value it was given stays unchanged,
+  /// even if the entry is assigned to or erased.
+  template<typename Fn>
+  inline bool visit(const K& key, Fn fn) {
+    ReadGuard guard(*this);
+    auto node = find_node(hash(key), key);
+    if (node == nullptr) {
+      return false;
+    }
+    fn(static_cast<const V&>(node->value));
+    return true;
+  }
+
+  inline bool contains(const K& key) {
+    ReadGuard guard(*this);
+    return find_node(hash(key), key) != nullptr;
+  }
+
+  /// \brief Add `key` with `value`, unless the key is already present.
+  ///
+  /// Returns `true` if the entry was inserted.
+  inline bool insert(K key, V value) {
+    return insert_impl(false, std::move(key), std::move(value));
+  }
+
+  /// \brief Add `key` with a value constructed from `args`, unless the key
+  /// is already present.
+  template<typename ...ForwardArgs>
+  inline bool emplace(K key, ForwardArgs&& ...args) {
+    return insert_impl(false, std::move(key), std::forward<ForwardArgs>(args)...);
+  }
+
+  /// \brief Set the value of `key`, adding the key if needed.
+  ///
+  /// Returns `true` if the key was not present before.
+  inline bool insert_or_assign(K key, V value) {
+    return insert_impl(true, std::move(key), std::move(value));
+  }
+
+  /// \brief Remove `key` from the map.
+  ///
+  /// Returns `false` if the key was not found.
+  inline bool erase(const K& key) {
+    auto h = hash(key);
+    bool erased = false;
+    bool should_reclaim = false;
+    {
+      ReadGuard guard(*this);
+      should_reclaim = help_migrate();
+      auto& stripe = stripe_for(h);
+      std::lock_guard<std::mutex> lock(stripe.mutex);
+      auto link = &bucket_for(_table.load(std::memory_order_acquire), h);
+      for (auto node = link->load(std::memory_order_relaxed); node != nullptr; node = node->next.load(std::memory_order_relaxed)) {
+        if (node->hash == h && node->key == key) {
+          link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+          stripe.count--;
+          should_reclaim |= retire(node, false);
+          erased = true;
+          break;
+        }
+        link = &node->next;
+      }
+    }
+    if (should_reclaim) {
+      reclaim();
+    }
+    return erased;
+  }
+
+  /// \brief Call `fn(key, value)` for every entry.
+  ///
+  /// Entries that are inserted or erased while this method runs may or may
+  /// not be visited, but no entry is visited twice. This includes writes
+  /// that `fn` itself makes to the map.
+  template<typename Fn>
+  inline void for_each(Fn fn) {
+    ReadGuard guard(*this);
+    auto table = _table.load(std::memory_order_acquire);
+    for (size_t i = 0; i < table->size; i++) {
+      visit_bucket(table, i, fn);
+    }
+  }
+
+  /// \brief Get the amount of entries.
+  ///
+  /// While other threads are writing, the result is only an estimate.
+  inline size_t size() const {
+    size_t result = 0;
+    for (auto& stripe: _stripes) {
+      result += stripe.count.load(std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  inline bool is_empty() const {
+    return size() == 0;
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_CONCURRENT_HASH_MAP_HPP
@@ -0,0 +1,117 @@
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "zen/concurrent_hash_map.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(ConcurrentHashMapTest, CanInsertFindAndErase) {
+  ConcurrentHashMap<std::string, int> m1;
+  ASSERT_TRUE(m1.is_empty());
+  ASSERT_TRUE(m1.insert("one", 1));
+  ASSERT_TRUE(m1.insert("two", 2));
+  ASSERT_FALSE(m1.insert("one", 3));
+  ASSERT_EQ(m1.size(), 2);
+  ASSERT_EQ(*m1.find("one"), 1);
+  ASSERT_EQ(*m1.find("two"), 2);
+  ASSERT_FALSE(m1.find("three").is_some());
+  ASSERT_TRUE(m1.contains("two"));
+  ASSERT_FALSE(m1.insert_or_assign("two", 22));
+  ASSERT_EQ(*m1.find("two"), 22);
+  ASSERT_TRUE(m1.erase("one"));
+  ASSERT_FALSE(m1.erase("one"));
+  ASSERT_FALSE(m1.contains("one"));
+  ASSERT_EQ(m1.size(), 1);
+  int seen = 0;
+  ASSERT_TRUE(m1.visit("two", [&](const int& value) { seen = value; }));
+  ASSERT_EQ(seen, 22);
+  ASSERT_FALSE(m1.visit("one", [&](const int& value) { seen = value; }));
+}
+
+TEST(ConcurrentHashMapTest, GrowsWhileKeepingAllEntries) {
+  ConcurrentHashMap<int, int> m1;
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_TRUE(m1.insert(i, i * 2));
+  }
+  ASSERT_EQ(m1.size(), 100000);
+  for (int i = 0; i < 100000; i++) {
+    auto value = m1.find(i);
+    ASSERT_TRUE(value.is_some());
+    ASSERT_EQ(*value, i * 2);
+  }
+  size_t count = 0;
+  long sum = 0;
+  m1.for_each([&](const int& key, const int& value) {
+    count++;
+    sum += value - key;
+  });
+  ASSERT_EQ(count, 100000);
+  ASSERT_EQ(sum, 99999L * 100000 / 2);
+}
+
+TEST(ConcurrentHashMapTest, CanWriteFromInsideCallbacks) {
+  ConcurrentHashMap<int, int> m1;
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(m1.insert(i, i));
+  }
+  m1.for_each([&](const int& key, const int&) { m1.erase(key); });
+  ASSERT_TRUE(m1.is_empty());
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(m1.insert(i, i));
+  }
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(m1.visit(i, [&](const int& value) {
+      ASSERT_EQ(value, i);
+      m1.insert_or_assign(i, value + 1);
+      ASSERT_EQ(value, i);
+    }));
+  }
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(*m1.find(i), i + 1);
+  }
+}
+
+TEST(ConcurrentHashMapTest, SupportsConcurrentReadersAndWriters) {
+  constexpr int thread_count = 8;
+  constexpr int keys_per_thread = 20000;
+  ConcurrentHashMap<int, std::string> m1;
+  for (int i = 0; i < keys_per_thread; i++) {
+    m1.insert(-i - 1, "shared");
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_count; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < keys_per_thread; i++) {
+        auto key = t * keys_per_thread + i;
+        m1.insert(key, std::to_string(key));
+        auto value = m1.find(-(i % keys_per_thread) - 1);
+        EXPECT_TRUE(value.is_some() && *value == "shared");
+        if (i % 2 == 0) {
+          m1.insert_or_assign(key, "updated");
+        } else {
+          m1.erase(key);
+        }
+      }
+    });
+  }
+  for (auto& thread: threads) {
+    thread.join();
+  }
+  ASSERT_EQ(m1.size(), keys_per_thread + thread_count * keys_per_thread / 2);
+  for (int t = 0; t < thread_count; t++) {
+    for (int i = 0; i < keys_per_thread; i++) {
+      auto key = t * keys_per_thread + i;
+      auto value = m1.find(key);
+      if (i % 2 == 0) {
+        ASSERT_TRUE(value.is_some());
+        ASSERT_EQ(*value, "updated");
+      } else {
+        ASSERT_FALSE(value.is_some());
+      }
+    }
+  }
+}
@@ -0,0 +1,426 @@
+/// \file deque.hpp
+/// \brief A double-ended queue backed by a ring buffer.
+
+#ifndef ZEN_DEQUE_HPP
+#define ZEN_DEQUE_HPP
+
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+#include "zen/macros.h"
+#include "zen/range.hpp"
+
+ZEN_NAMESPACE_START
+
+template<
+  typename T,
+  typename SizeT = size_t,
+  typename AllocatorT = DefaultAllocator<T>
+>
+class Deque;
+
+template<
+  typename T,
+  typename SizeT,
+  typename AllocatorT
+>
+class DequeIter {
+
+  using Container = Deque<T, SizeT, AllocatorT>;
+
+  Container* deque;
+  SizeT index;
+
+public:
+
+  using Value = T;
+  using Size = SizeT;
+  using Diff = MakeDiffT<SizeT>;
+
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = Value;
+  using difference_type = Diff;
+  using pointer = T*;
+  using reference = T&;
+
+  inline DequeIter():
+    deque(nullptr), index(0) {}
+
+  inline DequeIter(Container* deque, SizeT index):
+    deque(deque), index(index) {}
+
+  bool operator==(const DequeIter& other) const {
+    return other.deque == deque && other.index == index;
+  }
+
+  bool operator!=(const DequeIter& other) const {
+    return !(*this == other);
+  }
+
+  bool operator<(const DequeIter& other) const {
+    return index < other.index;
+  }
+
+  bool operator>(const DequeIter& other) const {
+    return other < *this;
+  }
+
+  bool operator<=(const DequeIter& other) const {
+    return !(other < *this);
+  }
+
+  bool operator>=(const DequeIter& other) const {
+    return !(*this < other);
+  }
+
+  T& operator*() const {
+    return (*deque)[index];
+  }
+
+  T* operator->() const {
+    return &(*deque)[index];
+  }
+
+  T& operator[](Diff offset) const {
+    return (*deque)[index + offset];
+  }
+
+  DequeIter& operator++() {
+    index++;
+    return *this;
+  }
+
+  DequeIter operator++(int) {
+    auto old = *this;
+    index++;
+    return old;
+  }
+
+  DequeIter& operator--() {
+    index--;
+    return *this;
+  }
+
+  DequeIter operator--(int) {
+    auto old = *this;
+    index--;
+    return old;
+  }
+
+  DequeIter& operator+=(Diff offset) {
+    index += offset;
+    return *this;
+  }
+
+  DequeIter& operator-=(Diff offset) {
+    index -= offset;
+    return *this;
+  }
+
+  DequeIter operator+(Diff offset) const {
+    return DequeIter(deque, index + offset);
+  }
+
+  friend DequeIter operator+(Diff offset, const DequeIter& it) {
+    return it + offset;
+  }
+
+  DequeIter operator-(Diff offset) const {
+    return DequeIter(deque, index - offset);
+  }
+
+  Diff operator-(const DequeIter& other) const {
+    return Diff(index) - Diff(other.index);
+  }
+
+};
+
+/// \brief A sequence with constant-time insertion and removal at both ends.
+///
+/// The elements are stored in a single ring buffer whose capacity is always
+/// a power of two, so that finding the slot of an element only takes an
+/// addition and a mask. Random access runs in constant time as well.
+///
+/// When the buffer is full, its capacity is doubled and the elements are
+/// relocated to the start of the new buffer.
+template<
+  typename T,
+  typename SizeT,
+  typename AllocatorT
+>
+class Deque {
+public:
+
+  using Value = T;
+  using Size = SizeT;
+  using Iter = DequeIter<T, SizeT, AllocatorT>;
+  using Range = IterRange<Iter>;
+
+  using value_type = T;
+  using size_type = SizeT;
+
+  /// The capacity that is used when growing an empty deque.
+  static constexpr SizeT min_capacity = 8;
+
+private:
+
+  AllocatorT _allocator;
+  T* _ptr;
+  SizeT _capacity;
+  SizeT _head;
+  SizeT _sz;
+
+  inline SizeT slot(SizeT index) const {
+    return (_head + index) & (_capacity - 1);
+  }
+
+  static inline SizeT round_up(SizeT capacity) {
+    SizeT result = min_capacity;
+    while (result < capacity) {
+      result *= 2;
+    }
+    return result;
+  }
+
+  /// Move all elements to a new buffer of `new_capacity` elements, which must
+  /// be a power of two and at least twice the current capacity.
+  inline void relocate(SizeT new_capacity) {
+    if constexpr (CanReallocate<AllocatorT, T>::value) {
+      if (_ptr != nullptr) {
+        auto new_ptr = _allocator.reallocate(_ptr, _capacity, new_capacity);
+        if (new_ptr != nullptr) {
+          // Elements that wrapped around to the start of the old buffer now
+          // belong right after its end.
+          if (_head + _sz > _capacity) {
+            relocate_n(new_ptr, _head + _sz - _capacity, new_ptr + _capacity);
+          }
+          _ptr = new_ptr;
+          _capacity = new_capacity;
+          return;
+        }
+      }
+    }
+    auto new_ptr = _allocator.allocate(new_capacity);
+    ZEN_ASSERT(new_ptr != nullptr);
+    if (_sz > 0) {
+      auto first_count = _capacity - _head < _sz ? _capacity - _head : _sz;
+      relocate_n(_ptr + _head, first_count, new_ptr);
+      relocate_n(_ptr, _sz - first_count, new_ptr + first_count);
+    }
+    if (_ptr != nullptr) {
+      _allocator.free(_ptr, _capacity);
+    }
+    _ptr = new_ptr;
+    _capacity = new_capacity;
+    _head = 0;
+  }
+
+  inline void destroy_all() {
+    clear();
+    if (_ptr != nullptr) {
+      _allocator.free(_ptr, _capacity);
+    }
+  }
+
+public:
+
+  inline Deque(AllocatorT allocator = AllocatorT()):
+    _allocator(allocator),
+    _ptr(nullptr),
+    _capacity(0),
+    _head(0),
+    _sz(0) {}
+
+  inline Deque(std::initializer_list<T> elements, AllocatorT allocator = AllocatorT()):
+    Deque(allocator) {
+      ensure_capacity(elements.size());
+      for (auto& element: elements) {
+        append(element);
+      }
+    }
+
+  inline Deque(const Deque& other):
+    Deque(other._allocator) {
+      ensure_capacity(other._sz);
+      for (SizeT i = 0; i < other._sz; i++) {
+        new (_ptr + i) T(other[i]);
+      }
+      _sz = other._sz;
+    }
+
+  inline Deque(Deque&& other):
+    _allocator(std::move(other._allocator)),
+    _ptr(other._ptr),
+    _capacity(other._capacity),
+    _head(other._head),
+    _sz(other._sz) {
+      other._ptr = nullptr;
+      other._capacity = 0;
+      other._head = 0;
+      other._sz = 0;
+    }
+
+  inline Deque& operator=(const Deque& other) {
+    if (this != &other) {
+      Deque copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  inline Deque& operator=(Deque&& other) {
+    if (this != &other) {
+      destroy_all();
+      _allocator = std::move(other._allocator);
+      _ptr = other._ptr;
+      _capacity = other._capacity;
+      _head = other._head;
+      _sz = other._sz;
+      other._ptr = nullptr;
+      other._capacity = 0;
+      other._head = 0;
+      other._sz = 0;
+    }
+    return *this;
+  }
+
+  inline ~Deque() {
+    destroy_all();
+  }
+
+  /// \brief Make sure at least `new_capacity` elements fit in this deque
+  /// without reallocating.
+  inline void ensure_capacity(SizeT new_capacity) {
+    if (_capacity < new_capacity) {
+      relocate(round_up(_capacity * 2 < new_capacity ? new_capacity : _capacity * 2));
+    }
+  }
+
+  inline T& operator[](SizeT index) {
+    ZEN_ASSERT(index < _sz);
+    return _ptr[slot(index)];
+  }
+
+  inline const T& operator[](SizeT index) const {
+    ZEN_ASSERT(index < _sz);
+    return _ptr[slot(index)];
+  }
+
+  template<typename ...ForwardArgs>
+  inline T& emplace_back(ForwardArgs&& ...args) {
+    if (_capacity < _sz + 1) {
+      // Construct the new element before relocating, because the arguments
+      // might refer to elements in the old buffer.
+      T element(std::forward<ForwardArgs>(args)...);
+      ensure_capacity(_sz + 1);
+      return emplace_back(std::move(element));
+    }
+    auto ptr = new (_ptr + slot(_sz)) T(std::forward<ForwardArgs>(args)...);
+    _sz++;
+    return *ptr;
+  }
+
+  template<typename ...ForwardArgs>
+  inline T& emplace_front(ForwardArgs&& ...args) {
+    if (_capacity < _sz + 1) {
+      // Same as in emplace_back(): the arguments might refer to elements in
+      // the old buffer.
+      T element(std::forward<ForwardArgs>(args)...);
+      ensure_capacity(_sz + 1);
+      return emplace_front(std::move(element));
+    }
+    _head = (_head - 1) & (_capacity - 1);
+    auto ptr = new (_ptr + _head) T(std::forward<ForwardArgs>(args)...);
+    _sz++;
+    return *ptr;
+  }
+
+  inline void append(const T& element) {
+    emplace_back(element);
+  }
+
+  inline void append(T&& element) {
+    emplace_back(std::move(element));
+  }
+
+  inline void prepend(const T& element) {
+    emplace_front(element);
+  }
+
+  inline void prepend(T&& element) {
+    emplace_front(std::move(element));
+  }
+
+  /// \brief Remove the first element and return it.
+  inline T pop_first() {
+    ZEN_ASSERT(_sz > 0);
+    auto& element = _ptr[_head];
+    T result = std::move(element);
+    element.~T();
+    _head = (_head + 1) & (_capacity - 1);
+    _sz--;
+    return result;
+  }
+
+  /// \brief Remove the last element and return it.
+  inline T pop_last() {
+    ZEN_ASSERT(_sz > 0);
+    auto& element = _ptr[slot(_sz - 1)];
+    T result = std::move(element);
+    element.~T();
+    _sz--;
+    return result;
+  }
+
+  inline T& first() {
+    ZEN_ASSERT(_sz > 0);
+    return _ptr[_head];
+  }
+
+  inline T& last() {
+    ZEN_ASSERT(_sz > 0);
+    return _ptr[slot(_sz - 1)];
+  }
+
+  /// \brief Destroy all elements while keeping the buffer around.
+  inline void clear() {
+    for (SizeT i = 0; i < _sz; i++) {
+      _ptr[slot(i)].~T();
+    }
+    _head = 0;
+    _sz = 0;
+  }
+
+  inline bool is_empty() const {
+    return _sz == 0;
+  }
+
+  inline SizeT size() const {
+    return _sz;
+  }
+
+  inline SizeT capacity() const {
+    return _capacity;
+  }
+
+  inline Range range() {
+    return make_iter_range(begin(), end());
+  }
+
+  inline Iter begin() {
+    return Iter(this, 0);
+  }
+
+  inline Iter end() {
+    return Iter(this, _sz);
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_DEQUE_HPP
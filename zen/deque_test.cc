@@ -0,0 +1,107 @@
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "zen/deque.hpp"
+#include "zen/stream.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(DequeTest, CanAppendAndPrepend) {
+  Deque<int> d1;
+  d1.append(3);
+  d1.append(4);
+  d1.prepend(2);
+  d1.prepend(1);
+  ASSERT_EQ(d1.size(), 4);
+  ASSERT_EQ(d1[0], 1);
+  ASSERT_EQ(d1[1], 2);
+  ASSERT_EQ(d1[2], 3);
+  ASSERT_EQ(d1[3], 4);
+  ASSERT_EQ(d1.first(), 1);
+  ASSERT_EQ(d1.last(), 4);
+}
+
+TEST(DequeTest, KeepsOrderWhenGrowingAcrossWrapAround) {
+  Deque<std::string> d1;
+  for (int i = 0; i < 6; i++) {
+    d1.append(std::to_string(i));
+  }
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(d1.pop_first(), std::to_string(i));
+    d1.append(std::to_string(i + 6));
+  }
+  for (int i = 1; i <= 20; i++) {
+    d1.prepend(std::to_string(-i));
+  }
+  ASSERT_EQ(d1.size(), 26);
+  ASSERT_EQ(d1.capacity(), 32);
+  int k = -20;
+  for (auto& element: d1) {
+    if (k == 0) {
+      k = 5;
+    }
+    ASSERT_EQ(element, std::to_string(k++));
+  }
+  ASSERT_EQ(d1.pop_last(), "10");
+  ASSERT_EQ(d1.size(), 25);
+}
+
+TEST(DequeTest, CanAppendAndPrependOwnElementWhenFull) {
+  Deque<std::string> d1;
+  for (int i = 0; i < 8; i++) {
+    d1.append("a fairly long string that lives on the heap " + std::to_string(i));
+  }
+  ASSERT_EQ(d1.size(), d1.capacity());
+  d1.append(d1.first());
+  ASSERT_EQ(d1.size(), 9);
+  ASSERT_EQ(d1.last(), d1.first());
+  Deque<std::string> d2;
+  for (int i = 0; i < 8; i++) {
+    d2.append("a fairly long string that lives on the heap " + std::to_string(i));
+  }
+  ASSERT_EQ(d2.size(), d2.capacity());
+  d2.prepend(d2.last());
+  ASSERT_EQ(d2.size(), 9);
+  ASSERT_EQ(d2.first(), d2.last());
+  ASSERT_EQ(d2[1], "a fairly long string that lives on the heap 0");
+}
+
+TEST(DequeTest, CanCopyAndMove) {
+  Deque<std::string> d1 { "a", "b", "c" };
+  d1.prepend("z");
+  Deque<std::string> d2(d1);
+  Deque<std::string> d3(std::move(d1));
+  ASSERT_TRUE(d1.is_empty());
+  ASSERT_EQ(d2.size(), 4);
+  ASSERT_EQ(d2[0], "z");
+  ASSERT_EQ(d3[3], "c");
+}
+
+class CountingStream : public BufferedStream<int> {
+
+  int next = 0;
+
+public:
+
+  Maybe<int> read() override {
+    if (next == 5) {
+      return {};
+    }
+    return next++;
+  }
+
+};
+
+TEST(DequeTest, CanBufferStream) {
+  CountingStream s1;
+  ASSERT_EQ(*s1.peek(3), 2);
+  ASSERT_EQ(*s1.get(), 0);
+  ASSERT_EQ(*s1.peek(1), 1);
+  ASSERT_EQ(*s1.get(), 1);
+  ASSERT_EQ(*s1.get(), 2);
+  ASSERT_EQ(*s1.get(), 3);
+  ASSERT_EQ(*s1.get(), 4);
+  ASSERT_TRUE(s1.get().is_empty());
+}
@@ -2,6 +2,10 @@
 #define ZEN_DLLIST_HPP
 
 #include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 #include "zen/config.h"
 #include "zen/macros.h"
@@ -17,11 +21,23 @@ template<
 >
 class DLList;
 
+/// \brief A node of a DLList.
+///
+/// The value is kept in a union so that a node can outlive its value while
+/// it sits in the node pool of its list.
 template<typename T>
 struct DLListNode {
-  T value;
+
   DLListNode* prev_node;
   DLListNode* next_node;
+
+  union {
+    T value;
+  };
+
+  inline DLListNode() {}
+  inline ~DLListNode() {}
+
 };
 
 template<
@@ -31,7 +47,7 @@ template<
 >
 class DLIter {
 
-  friend class DLList<T, size_t,  AllocatorT>;
+  friend class DLList<T, SizeT, AllocatorT>;
 
   DLListNode<T>* current;
 
@@ -58,6 +74,10 @@ public:
     return current->value;
   }
 
+  T* operator->() {
+    return &current->value;
+  }
+
   DLIter& operator++() {
     ZEN_ASSERT(current != nullptr);
     current = current->next_node;
@@ -75,6 +95,22 @@ public:
 
 };
 
+/// \brief A doubly-linked list.
+///
+/// Nodes are allocated one at a time with a default-constructed `AllocatorT`
+/// that is rebound to the node type. A list can also keep the nodes of
+/// erased elements in a pool and hand them out again on the next insertion,
+/// so that a list that is constantly being filled and drained, such as a
+/// scheduler queue, stops calling into the allocator once it has reached
+/// its working size:
+///
+/// ```
+/// DLList<Task*> queue;
+/// queue.set_pool_limit(1024);
+/// ```
+///
+/// Moving elements between lists with splice() relinks the existing nodes
+/// and never allocates.
 template<
   typename T,
   typename SizeT,
@@ -89,50 +125,322 @@ public:
   using Iter = DLIter<T, SizeT, AllocatorT>;
   using Range = IterRange<Iter>;
 
+  using value_type = Value;
+  using size_type = Size;
+
 private:
 
-  DLListNode<T>* _first;
-  DLListNode<T>* _last;
-  std::size_t _sz;
+  using Node = DLListNode<T>;
+  using NodeAllocator = RebindAllocatorT<AllocatorT, Node>;
+
+  NodeAllocator _allocator;
+  Node* _first;
+  Node* _last;
+  SizeT _sz;
+
+  /// Spare nodes, linked through their `next_node` field.
+  Node* _pool;
+  SizeT _pool_sz;
+  SizeT _pool_limit;
+
+  template<typename ...ForwardArgs>
+  inline Node* make_node(ForwardArgs&& ...args) {
+    Node* node;
+    if (_pool != nullptr) {
+      node = _pool;
+      _pool = node->next_node;
+      _pool_sz--;
+    } else {
+      auto ptr = _allocator.allocate(1);
+      ZEN_ASSERT(ptr != nullptr);
+      node = new (ptr) Node;
+    }
+    new (&node->value) T(std::forward<ForwardArgs>(args)...);
+    return node;
+  }
+
+  inline void free_node(Node* node) {
+    node->value.~T();
+    if (_pool_sz < _pool_limit) {
+      node->next_node = _pool;
+      _pool = node;
+      _pool_sz++;
+    } else {
+      node->~Node();
+      _allocator.free(node, 1);
+    }
+  }
+
+  /// Link `node` into this list right before `next`, or at the end if
+  /// `next` is `nullptr`.
+  inline void link_before(Node* next, Node* node) {
+    auto prev = next == nullptr ? _last : next->prev_node;
+    node->prev_node = prev;
+    node->next_node = next;
+    if (prev == nullptr) {
+      _first = node;
+    } else {
+      prev->next_node = node;
+    }
+    if (next == nullptr) {
+      _last = node;
+    } else {
+      next->prev_node = node;
+    }
+    _sz++;
+  }
+
+  inline void unlink(Node* node) {
+    if (node->prev_node == nullptr) {
+      _first = node->next_node;
+    } else {
+      node->prev_node->next_node = node->next_node;
+    }
+    if (node->next_node == nullptr) {
+      _last = node->prev_node;
+    } else {
+      node->next_node->prev_node = node->prev_node;
+    }
+    _sz--;
+  }
+
+  inline void release_pool() {
+    while (_pool != nullptr) {
+      auto next = _pool->next_node;
+      _pool->~Node();
+      _allocator.free(_pool, 1);
+      _pool = next;
+    }
+    _pool_sz = 0;
+  }
 
 public:
 
   inline DLList():
-    _first(nullptr), _last(nullptr), _sz(0) {}
+    _first(nullptr),
+    _last(nullptr),
+    _sz(0),
+    _pool(nullptr),
+    _pool_sz(0),
+    _pool_limit(0) {}
 
-  void append(T element) {
-    auto new_node = new DLListNode<T> {
-      .value = element,
-      .next_node = nullptr
-    };
-    if (_first == nullptr) {
-      new_node->prev_node = nullptr;
-      _first = _last = new_node;
-    } else {
-      new_node->prev_node = _last;
-      _last->next_node = new_node;
-      _last = new_node;
+  inline DLList(std::initializer_list<T> elements):
+    DLList() {
+      for (auto& element: elements) {
+        append(element);
+      }
+    }
+
+  template<
+    typename RangeT,
+    typename = std::enable_if_t<IsRange<RangeT>::value && !std::is_same_v<std::decay_t<RangeT>, DLList>>
+  >
+  DLList(RangeT range):
+    DLList() {
+      for (auto&& element: range) {
+        append(element);
+      }
+    }
+
+  template<
+    typename IterT,
+    typename = std::enable_if_t<!IsRange<IterT>::value>
+  >
+  DLList(IterT first, IterT last):
+    DLList() {
+      for (; first != last; ++first) {
+        append(*first);
+      }
+    }
+
+  inline DLList(const DLList& other):
+    DLList() {
+      for (auto node = other._first; node != nullptr; node = node->next_node) {
+        append(node->value);
+      }
+    }
+
+  inline DLList(DLList&& other):
+    _allocator(std::move(other._allocator)),
+    _first(other._first),
+    _last(other._last),
+    _sz(other._sz),
+    _pool(other._pool),
+    _pool_sz(other._pool_sz),
+    _pool_limit(other._pool_limit) {
+      other._first = nullptr;
+      other._last = nullptr;
+      other._sz = 0;
+      other._pool = nullptr;
+      other._pool_sz = 0;
+    }
+
+  inline DLList& operator=(const DLList& other) {
+    if (this != &other) {
+      DLList copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  inline DLList& operator=(DLList&& other) {
+    if (this != &other) {
+      DLList moved(std::move(other));
+      swap(moved);
+    }
+    return *this;
+  }
+
+  inline ~DLList() {
+    clear();
+    release_pool();
+  }
+
+  inline void swap(DLList& other) {
+    std::swap(_allocator, other._allocator);
+    std::swap(_first, other._first);
+    std::swap(_last, other._last);
+    std::swap(_sz, other._sz);
+    std::swap(_pool, other._pool);
+    std::swap(_pool_sz, other._pool_sz);
+    std::swap(_pool_limit, other._pool_limit);
+  }
+
+  /// \brief Keep up to `limit` nodes of erased elements around for reuse.
+  ///
+  /// A limit of zero, which is the default, returns every node to the
+  /// allocator as soon as its element is erased.
+  inline void set_pool_limit(SizeT limit) {
+    _pool_limit = limit;
+    while (_pool_sz > _pool_limit) {
+      auto node = _pool;
+      _pool = node->next_node;
+      _pool_sz--;
+      node->~Node();
+      _allocator.free(node, 1);
+    }
+  }
+
+  /// \brief Allocate nodes up front so that the next `count` insertions do
+  /// not have to.
+  ///
+  /// Raises the pool limit if it is too small to hold the nodes.
+  inline void reserve_nodes(SizeT count) {
+    if (_pool_limit < count) {
+      _pool_limit = count;
+    }
+    while (_pool_sz < count) {
+      auto ptr = _allocator.allocate(1);
+      ZEN_ASSERT(ptr != nullptr);
+      auto node = new (ptr) Node;
+      node->next_node = _pool;
+      _pool = node;
+      _pool_sz++;
     }
-    _sz++;
+  }
+
+  /// \brief Get the amount of spare nodes that are waiting to be reused.
+  inline SizeT pool_size() const {
+    return _pool_sz;
+  }
+
+  template<typename ...ForwardArgs>
+  inline T& emplace_back(ForwardArgs&& ...args) {
+    auto node = make_node(std::forward<ForwardArgs>(args)...);
+    link_before(nullptr, node);
+    return node->value;
+  }
+
+  void append(T element) {
+    link_before(nullptr, make_node(std::move(element)));
   }
 
   void prepend(T element) {
-    auto to_prepend = new DLListNode<T> {
-      .value = element,
-      .prev_node = nullptr
-    };
-    if (_first == nullptr) {
-      to_prepend->next_node = nullptr;
-      _first = _last = to_prepend;
-    } else {
-      to_prepend->next_node = _last;
-      _first->prev_node = to_prepend;
-      _first = to_prepend;
+    link_before(_first, make_node(std::move(element)));
+  }
+
+  inline void insert_after(Iter pos, Value value) {
+    ZEN_ASSERT(pos.current != nullptr);
+    link_before(pos.current->next_node, make_node(std::move(value)));
+  }
+
+  /// \brief Insert `value` right before `pos`, or at the end if `pos` is
+  /// end().
+  inline Iter insert_before(Iter pos, Value value) {
+    auto node = make_node(std::move(value));
+    link_before(pos.current, node);
+    return Iter(node);
+  }
+
+  /// \brief Remove the element at `pos` and return an iterator to the
+  /// element after it.
+  inline Iter erase(Iter pos) {
+    ZEN_ASSERT(pos.current != nullptr);
+    auto next = pos.current->next_node;
+    unlink(pos.current);
+    free_node(pos.current);
+    return Iter(next);
+  }
+
+  /// \brief Remove all elements.
+  ///
+  /// The nodes are kept in the pool as far as the pool limit allows.
+  inline void clear() {
+    auto node = _first;
+    while (node != nullptr) {
+      auto next = node->next_node;
+      free_node(node);
+      node = next;
     }
-    _sz++;
+    _first = _last = nullptr;
+    _sz = 0;
   }
 
-  SizeT size() {
+  /// \brief Move the element at `element` from `other` to this list, right
+  /// before `pos`.
+  ///
+  /// No nodes are allocated or freed, so iterators to the moved element stay
+  /// valid and now point into this list. `other` may be this list.
+  inline void splice(Iter pos, DLList& other, Iter element) {
+    ZEN_ASSERT(element.current != nullptr);
+    if (element == pos) {
+      return;
+    }
+    other.unlink(element.current);
+    link_before(pos.current, element.current);
+  }
+
+  /// \brief Move all elements of `other` to this list, right before `pos`.
+  ///
+  /// This takes constant time.
+  inline void splice(Iter pos, DLList& other) {
+    if (&other == this || other._first == nullptr) {
+      return;
+    }
+    auto next = pos.current;
+    auto prev = next == nullptr ? _last : next->prev_node;
+    other._first->prev_node = prev;
+    other._last->next_node = next;
+    if (prev == nullptr) {
+      _first = other._first;
+    } else {
+      prev->next_node = other._first;
+    }
+    if (next == nullptr) {
+      _last = other._last;
+    } else {
+      next->prev_node = other._last;
+    }
+    _sz += other._sz;
+    other._first = other._last = nullptr;
+    other._sz = 0;
+  }
+
+  inline bool is_empty() const {
+    return _sz == 0;
+  }
+
+  SizeT size() const {
     return _sz;
   }
 
@@ -145,7 +453,7 @@ public:
   }
 
   inline Iter end() {
-    return Iter(_last);
+    return Iter(nullptr);
   }
 
   inline T& operator[](size_t index) {
@@ -153,27 +461,712 @@ public:
     return *(begin() + index);
   }
 
-  inline void insert_after(Iter pos, Value value) {
+  inline Value first() {
+    ZEN_ASSERT(_first != nullptr);
+    return _first->value;
+  }
+
+  inline Value last() {
+    ZEN_ASSERT(_last != nullptr);
+    return _last->value;
+  }
+
+};
+
+/// \brief The links that an object embeds to be part of an IntrusiveDLList.
+///
+/// An object can be on several lists at once by embedding one hook for each
+/// of them.
+template<typename T>
+struct DLListHook {
+  T* prev_node = nullptr;
+  T* next_node = nullptr;
+};
+
+template<
+  typename T,
+  DLListHook<T> T::*Hook,
+  typename SizeT = size_t
+>
+class IntrusiveDLList;
+
+template<
+  typename T,
+  DLListHook<T> T::*Hook,
+  typename SizeT = size_t
+>
+class IntrusiveDLIter {
+
+  friend class IntrusiveDLList<T, Hook, SizeT>;
+
+  T* current;
+
+public:
+
+  using Value = T;
+  using Size = SizeT;
+  using Diff = MakeDiffT<SizeT>;
+
+  using value_type = Value;
+
+  inline IntrusiveDLIter(T* current):
+    current(current) {}
+
+  bool operator==(const IntrusiveDLIter& other) const {
+    return other.current == current;
+  }
+
+  bool operator!=(const IntrusiveDLIter& other) const {
+    return other.current != current;
+  }
+
+  T& operator*() {
+    return *current;
+  }
+
+  T* operator->() {
+    return current;
+  }
+
+  IntrusiveDLIter& operator++() {
+    ZEN_ASSERT(current != nullptr);
+    current = (current->*Hook).next_node;
+    return *this;
+  }
+
+  IntrusiveDLIter operator+(SizeT count) {
+    auto result = current;
+    for (SizeT i = 0; i < count; i++) {
+      ZEN_ASSERT(result != nullptr);
+      result = (result->*Hook).next_node;
+    }
+    return IntrusiveDLIter(result);
+  }
+
+};
+
+/// \brief A doubly-linked list of objects that carry their own links.
+///
+/// The list does not own its elements and never allocates. Instead, each
+/// object embeds a DLListHook that the list uses to link it, which makes it
+/// possible to remove an object in constant time given only a reference to
+/// it:
+///
+/// ```
+/// struct Timer {
+///   uint64_t deadline;
+///   DLListHook<Timer> queue_hook;
+/// };
+///
+/// IntrusiveDLList<Timer, &Timer::queue_hook> pending;
+/// pending.append(timer);
+/// pending.remove(timer);
+/// ```
+///
+/// An object must not be destroyed or moved while it is on a list, and it
+/// can be on at most one list per hook. Iteration works like DLList.
+template<
+  typename T,
+  DLListHook<T> T::*Hook,
+  typename SizeT
+>
+class IntrusiveDLList {
+public:
+
+  using Value = T;
+  using Size = SizeT;
+  using Iter = IntrusiveDLIter<T, Hook, SizeT>;
+  using Range = IterRange<Iter>;
+
+  using value_type = Value;
+  using size_type = Size;
+
+private:
+
+  T* _first;
+  T* _last;
+  SizeT _sz;
+
+  static inline DLListHook<T>& hook(T* element) {
+    return element->*Hook;
+  }
+
+  /// Link `element` right before `next`, or at the end if `next` is
+  /// `nullptr`.
+  inline void link_before(T* next, T* element) {
+    auto prev = next == nullptr ? _last : hook(next).prev_node;
+    hook(element).prev_node = prev;
+    hook(element).next_node = next;
+    if (prev == nullptr) {
+      _first = element;
+    } else {
+      hook(prev).next_node = element;
+    }
+    if (next == nullptr) {
+      _last = element;
+    } else {
+      hook(next).prev_node = element;
+    }
+    _sz++;
+  }
+
+public:
+
+  inline IntrusiveDLList():
+    _first(nullptr), _last(nullptr), _sz(0) {}
+
+  IntrusiveDLList(const IntrusiveDLList& other) = delete;
+  IntrusiveDLList& operator=(const IntrusiveDLList& other) = delete;
+
+  inline IntrusiveDLList(IntrusiveDLList&& other):
+    _first(other._first), _last(other._last), _sz(other._sz) {
+      other._first = other._last = nullptr;
+      other._sz = 0;
+    }
+
+  inline IntrusiveDLList& operator=(IntrusiveDLList&& other) {
+    if (this != &other) {
+      clear();
+      _first = other._first;
+      _last = other._last;
+      _sz = other._sz;
+      other._first = other._last = nullptr;
+      other._sz = 0;
+    }
+    return *this;
+  }
+
+  /// Unlinks the remaining elements, so that they can be put on another
+  /// list.
+  inline ~IntrusiveDLList() {
+    clear();
+  }
+
+  void append(T& element) {
+    link_before(nullptr, &element);
+  }
+
+  void prepend(T& element) {
+    link_before(_first, &element);
+  }
+
+  inline void insert_after(Iter pos, T& element) {
+    ZEN_ASSERT(pos.current != nullptr);
+    link_before(hook(pos.current).next_node, &element);
+  }
+
+  /// \brief Insert `element` right before `pos`, or at the end if `pos` is
+  /// end().
+  inline Iter insert_before(Iter pos, T& element) {
+    link_before(pos.current, &element);
+    return Iter(&element);
+  }
+
+  /// \brief Unlink `element` from this list in constant time.
+  inline void remove(T& element) {
+    auto& links = hook(&element);
+    if (links.prev_node == nullptr) {
+      ZEN_ASSERT(_first == &element);
+      _first = links.next_node;
+    } else {
+      hook(links.prev_node).next_node = links.next_node;
+    }
+    if (links.next_node == nullptr) {
+      ZEN_ASSERT(_last == &element);
+      _last = links.prev_node;
+    } else {
+      hook(links.next_node).prev_node = links.prev_node;
+    }
+    links.prev_node = links.next_node = nullptr;
+    _sz--;
+  }
+
+  /// \brief Unlink the element at `pos` and return an iterator to the
+  /// element after it.
+  inline Iter erase(Iter pos) {
     ZEN_ASSERT(pos.current != nullptr);
-    auto to_insert_next = pos.current->next_node;
-    auto to_insert = new DLListNode<T> {
-      .value = value,
-      .prev_node = pos.current,
-      .next_node = pos.current->next_node,
-    };
-    pos.current->next_node = to_insert;
-    to_insert_next->prev_node = to_insert;
+    auto next = hook(pos.current).next_node;
+    remove(*pos.current);
+    return Iter(next);
+  }
+
+  /// \brief Unlink all elements.
+  inline void clear() {
+    auto element = _first;
+    while (element != nullptr) {
+      auto next = hook(element).next_node;
+      hook(element).prev_node = hook(element).next_node = nullptr;
+      element = next;
+    }
+    _first = _last = nullptr;
+    _sz = 0;
+  }
+
+  /// \brief Move `element` from `other` to this list, right before `pos`.
+  inline void splice(Iter pos, IntrusiveDLList& other, Iter element) {
+    ZEN_ASSERT(element.current != nullptr);
+    if (element == pos) {
+      return;
+    }
+    other.remove(*element.current);
+    link_before(pos.current, element.current);
+  }
+
+  /// \brief Move all elements of `other` to this list, right before `pos`.
+  ///
+  /// This takes constant time.
+  inline void splice(Iter pos, IntrusiveDLList& other) {
+    if (&other == this || other._first == nullptr) {
+      return;
+    }
+    auto next = pos.current;
+    auto prev = next == nullptr ? _last : hook(next).prev_node;
+    hook(other._first).prev_node = prev;
+    hook(other._last).next_node = next;
+    if (prev == nullptr) {
+      _first = other._first;
+    } else {
+      hook(prev).next_node = other._first;
+    }
+    if (next == nullptr) {
+      _last = other._last;
+    } else {
+      hook(next).prev_node = other._last;
+    }
+    _sz += other._sz;
+    other._first = other._last = nullptr;
+    other._sz = 0;
+  }
+
+  inline bool is_empty() const {
+    return _sz == 0;
+  }
+
+  SizeT size() const {
+    return _sz;
+  }
+
+  inline Range range() {
+    return make_iter_range(begin(), end());
+  }
+
+  inline Iter begin() {
+    return Iter(_first);
+  }
+
+  inline Iter end() {
+    return Iter(nullptr);
+  }
+
+  inline T& operator[](size_t index) {
+    ZEN_ASSERT(index < _sz);
+    return *(begin() + index);
+  }
+
+  inline T& first() {
+    ZEN_ASSERT(_first != nullptr);
+    return *_first;
+  }
+
+  inline T& last() {
+    ZEN_ASSERT(_last != nullptr);
+    return *_last;
+  }
+
+};
+
+/// Pick the amount of elements per node of an UnrolledDLList so that the
+/// elements of a node fill about four cache lines.
+template<typename T>
+constexpr size_t _unrolled_dllist_default_count() {
+  return sizeof(T) >= 64 ? 4 : 256 / sizeof(T);
+}
+
+template<typename T, size_t K>
+struct UnrolledDLListNode {
+
+  UnrolledDLListNode* prev_node;
+  UnrolledDLListNode* next_node;
+  size_t count;
+
+  union {
+    T values[K];
+  };
+
+  inline UnrolledDLListNode() {}
+  inline ~UnrolledDLListNode() {}
+
+};
+
+template<
+  typename T,
+  size_t K = _unrolled_dllist_default_count<T>(),
+  typename SizeT = size_t,
+  typename AllocatorT = DefaultAllocator<T>
+>
+class UnrolledDLList;
+
+template<
+  typename T,
+  size_t K,
+  typename SizeT,
+  typename AllocatorT
+>
+class UnrolledDLIter {
+
+  friend class UnrolledDLList<T, K, SizeT, AllocatorT>;
+
+  UnrolledDLListNode<T, K>* node;
+  size_t index;
+
+public:
+
+  using Value = T;
+  using Size = SizeT;
+  using Diff = MakeDiffT<SizeT>;
+
+  using value_type = Value;
+
+  inline UnrolledDLIter(UnrolledDLListNode<T, K>* node, size_t index):
+    node(node), index(index) {}
+
+  bool operator==(const UnrolledDLIter& other) const {
+    return other.node == node && other.index == index;
+  }
+
+  bool operator!=(const UnrolledDLIter& other) const {
+    return !(*this == other);
+  }
+
+  T& operator*() {
+    return node->values[index];
+  }
+
+  T* operator->() {
+    return &node->values[index];
+  }
+
+  UnrolledDLIter& operator++() {
+    ZEN_ASSERT(node != nullptr);
+    if (++index == node->count) {
+      node = node->next_node;
+      index = 0;
+    }
+    return *this;
+  }
+
+  /// Skips over whole nodes at a time.
+  UnrolledDLIter operator+(SizeT count) {
+    auto result_node = node;
+    size_t result_index = index + count;
+    while (result_node != nullptr && result_index >= result_node->count) {
+      result_index -= result_node->count;
+      result_node = result_node->next_node;
+    }
+    ZEN_ASSERT(result_node != nullptr || result_index == 0);
+    return UnrolledDLIter(result_node, result_index);
+  }
+
+};
+
+/// \brief A doubly-linked list that stores up to `K` elements per node.
+///
+/// Elements of the same node are stored next to each other, so iterating
+/// over an unrolled list touches about `K` times fewer nodes than a DLList,
+/// and indexing skips over whole nodes. Inserting in the middle still takes
+/// constant time: if the node at the insertion point is full, it is split in
+/// two halves.
+///
+/// Unlike DLList, inserting or erasing an element moves the other elements
+/// of its node, which invalidates iterators that point into that node.
+template<
+  typename T,
+  size_t K,
+  typename SizeT,
+  typename AllocatorT
+>
+class UnrolledDLList {
+
+  static_assert(K >= 2, "an unrolled list needs room for at least two elements per node");
+
+public:
+
+  using Value = T;
+  using Ref = Value;
+  using Size = SizeT;
+  using Iter = UnrolledDLIter<T, K, SizeT, AllocatorT>;
+  using Range = IterRange<Iter>;
+
+  using value_type = Value;
+  using size_type = Size;
+
+  static constexpr size_t elements_per_node = K;
+
+private:
+
+  using Node = UnrolledDLListNode<T, K>;
+  using NodeAllocator = RebindAllocatorT<AllocatorT, Node>;
+
+  NodeAllocator _allocator;
+  Node* _first;
+  Node* _last;
+  SizeT _sz;
+
+  /// Create an empty node and link it right after `prev`, or at the front
+  /// if `prev` is `nullptr`.
+  inline Node* make_node_after(Node* prev) {
+    auto ptr = _allocator.allocate(1);
+    ZEN_ASSERT(ptr != nullptr);
+    auto node = new (ptr) Node;
+    node->count = 0;
+    auto next = prev == nullptr ? _first : prev->next_node;
+    node->prev_node = prev;
+    node->next_node = next;
+    if (prev == nullptr) {
+      _first = node;
+    } else {
+      prev->next_node = node;
+    }
+    if (next == nullptr) {
+      _last = node;
+    } else {
+      next->prev_node = node;
+    }
+    return node;
+  }
+
+  /// Unlink and free a node whose elements have already been destroyed.
+  inline void free_node(Node* node) {
+    if (node->prev_node == nullptr) {
+      _first = node->next_node;
+    } else {
+      node->prev_node->next_node = node->next_node;
+    }
+    if (node->next_node == nullptr) {
+      _last = node->prev_node;
+    } else {
+      node->next_node->prev_node = node->prev_node;
+    }
+    node->~Node();
+    _allocator.free(node, 1);
+  }
+
+  /// Move `count` elements starting at `from` to the uninitialized slots
+  /// starting at `to`. The ranges may overlap.
+  static inline void relocate(T* from, T* to, size_t count) {
+    if (to < from) {
+      for (size_t i = 0; i < count; i++) {
+        new (to + i) T(std::move(from[i]));
+        from[i].~T();
+      }
+    } else {
+      for (size_t i = count; i > 0; i--) {
+        new (to + i - 1) T(std::move(from[i - 1]));
+        from[i - 1].~T();
+      }
+    }
+  }
+
+  /// Insert `value` at position `index` of `node`, where a `node` of
+  /// `nullptr` means the end of the list.
+  inline Iter insert_at(Node* node, size_t index, T&& value) {
+    if (node == nullptr) {
+      if (_last != nullptr && _last->count < K) {
+        node = _last;
+        index = _last->count;
+      } else {
+        node = make_node_after(_last);
+        index = 0;
+      }
+    } else if (node->count == K) {
+      auto half = K / 2;
+      auto upper = make_node_after(node);
+      relocate(node->values + half, upper->values, K - half);
+      upper->count = K - half;
+      node->count = half;
+      if (index > half) {
+        node = upper;
+        index -= half;
+      }
+    }
+    relocate(node->values + index, node->values + index + 1, node->count - index);
+    new (node->values + index) T(std::move(value));
+    node->count++;
     _sz++;
+    return Iter(node, index);
+  }
+
+public:
+
+  inline UnrolledDLList():
+    _first(nullptr), _last(nullptr), _sz(0) {}
+
+  inline UnrolledDLList(std::initializer_list<T> elements):
+    UnrolledDLList() {
+      for (auto& element: elements) {
+        append(element);
+      }
+    }
+
+  template<
+    typename RangeT,
+    typename = std::enable_if_t<IsRange<RangeT>::value && !std::is_same_v<std::decay_t<RangeT>, UnrolledDLList>>
+  >
+  UnrolledDLList(RangeT range):
+    UnrolledDLList() {
+      for (auto&& element: range) {
+        append(element);
+      }
+    }
+
+  template<
+    typename IterT,
+    typename = std::enable_if_t<!IsRange<IterT>::value>
+  >
+  UnrolledDLList(IterT first, IterT last):
+    UnrolledDLList() {
+      for (; first != last; ++first) {
+        append(*first);
+      }
+    }
+
+  inline UnrolledDLList(const UnrolledDLList& other):
+    UnrolledDLList() {
+      for (auto node = other._first; node != nullptr; node = node->next_node) {
+        for (size_t i = 0; i < node->count; i++) {
+          append(node->values[i]);
+        }
+      }
+    }
+
+  inline UnrolledDLList(UnrolledDLList&& other):
+    _allocator(std::move(other._allocator)),
+    _first(other._first),
+    _last(other._last),
+    _sz(other._sz) {
+      other._first = other._last = nullptr;
+      other._sz = 0;
+    }
+
+  inline UnrolledDLList& operator=(const UnrolledDLList& other) {
+    if (this != &other) {
+      UnrolledDLList copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  inline UnrolledDLList& operator=(UnrolledDLList&& other) {
+    if (this != &other) {
+      UnrolledDLList moved(std::move(other));
+      swap(moved);
+    }
+    return *this;
+  }
+
+  inline ~UnrolledDLList() {
+    clear();
+  }
+
+  inline void swap(UnrolledDLList& other) {
+    std::swap(_allocator, other._allocator);
+    std::swap(_first, other._first);
+    std::swap(_last, other._last);
+    std::swap(_sz, other._sz);
+  }
+
+  void append(T element) {
+    insert_at(nullptr, 0, std::move(element));
+  }
+
+  void prepend(T element) {
+    insert_at(_first, 0, std::move(element));
+  }
+
+  inline void insert_after(Iter pos, Value value) {
+    ZEN_ASSERT(pos.node != nullptr);
+    insert_at(pos.node, pos.index + 1, std::move(value));
+  }
+
+  /// \brief Insert `value` right before `pos`, or at the end if `pos` is
+  /// end().
+  inline Iter insert_before(Iter pos, Value value) {
+    return insert_at(pos.node, pos.index, std::move(value));
+  }
+
+  /// \brief Remove the element at `pos` and return an iterator to the
+  /// element after it.
+  ///
+  /// A node that becomes less than half full absorbs the elements of the
+  /// next node if they fit, so that nodes stay reasonably dense.
+  inline Iter erase(Iter pos) {
+    auto node = pos.node;
+    ZEN_ASSERT(node != nullptr && pos.index < node->count);
+    node->values[pos.index].~T();
+    relocate(node->values + pos.index + 1, node->values + pos.index, node->count - pos.index - 1);
+    node->count--;
+    _sz--;
+    if (node->count == 0) {
+      auto next = node->next_node;
+      free_node(node);
+      return Iter(next, 0);
+    }
+    auto next = node->next_node;
+    if (next != nullptr && node->count + next->count <= K / 2) {
+      relocate(next->values, node->values + node->count, next->count);
+      node->count += next->count;
+      free_node(next);
+    }
+    if (pos.index < node->count) {
+      return Iter(node, pos.index);
+    }
+    return Iter(node->next_node, 0);
+  }
+
+  /// \brief Remove all elements.
+  inline void clear() {
+    while (_first != nullptr) {
+      for (size_t i = 0; i < _first->count; i++) {
+        _first->values[i].~T();
+      }
+      free_node(_first);
+    }
+    _sz = 0;
+  }
+
+  inline bool is_empty() const {
+    return _sz == 0;
+  }
+
+  SizeT size() const {
+    return _sz;
+  }
+
+  inline Range range() {
+    return make_iter_range(begin(), end());
+  }
+
+  inline Iter begin() {
+    return Iter(_first, 0);
+  }
+
+  inline Iter end() {
+    return Iter(nullptr, 0);
+  }
+
+  inline T& operator[](size_t index) {
+    ZEN_ASSERT(index < _sz);
+    return *(begin() + index);
   }
 
   inline Value first() {
     ZEN_ASSERT(_first != nullptr);
-    return _first->value;
+    return _first->values[0];
   }
 
   inline Value last() {
-    ZEN_ASSERT(_last = nullptr);
-    return _last->value;
+    ZEN_ASSERT(_last != nullptr);
+    return _last->values[_last->count - 1];
   }
 
 };
@@ -1,6 +1,9 @@
 
 #include "gtest/gtest.h"
 
+#include <cstdlib>
+#include <string>
+
 #include "zen/dllist.hpp"
 
 using namespace ZEN_NAMESPACE;
@@ -43,3 +46,220 @@ TEST(DLListTest, CanInsert) {
   ASSERT_EQ(l1[3], 4);
 }
 
+
+struct CountingNodeAllocatorStats {
+  static inline size_t allocated = 0;
+  static inline size_t freed = 0;
+};
+
+template<typename T>
+struct CountingNodeAllocator {
+
+  T* allocate(size_t count) {
+    CountingNodeAllocatorStats::allocated += count;
+    return static_cast<T*>(malloc(count * sizeof(T)));
+  }
+
+  void free(T* ptr, size_t count) {
+    CountingNodeAllocatorStats::freed += count;
+    ::free(ptr);
+  }
+
+};
+
+TEST(DLListTest, IteratesOverAllElements) {
+  DLList<int> l1 { 1, 2, 3 };
+  l1.prepend(0);
+  l1.insert_after(l1.begin() + 3, 4);
+  int k = 0;
+  for (auto i: l1) {
+    ASSERT_EQ(i, k);
+    k++;
+  }
+  ASSERT_EQ(k, 5);
+  ASSERT_EQ(l1.first(), 0);
+  ASSERT_EQ(l1.last(), 4);
+}
+
+TEST(DLListTest, CanEraseAndClear) {
+  DLList<std::string> l1 { "a", "b", "c", "d" };
+  auto it = l1.erase(l1.begin() + 1);
+  ASSERT_EQ(*it, "c");
+  l1.erase(l1.begin() + 2);
+  ASSERT_EQ(l1.size(), 2);
+  ASSERT_EQ(l1.last(), "c");
+  l1.erase(l1.begin());
+  ASSERT_EQ(l1.first(), "c");
+  l1.clear();
+  ASSERT_TRUE(l1.is_empty());
+  ASSERT_TRUE(l1.begin() == l1.end());
+  l1.append("e");
+  ASSERT_EQ(l1.first(), "e");
+}
+
+TEST(DLListTest, RoutesNodesThroughAllocatorAndReusesThem) {
+  CountingNodeAllocatorStats::allocated = 0;
+  CountingNodeAllocatorStats::freed = 0;
+  {
+    DLList<std::string, size_t, CountingNodeAllocator<std::string>> l1;
+    l1.set_pool_limit(4);
+    for (int i = 0; i < 4; i++) {
+      l1.append(std::to_string(i));
+    }
+    ASSERT_EQ(CountingNodeAllocatorStats::allocated, 4);
+    for (int round = 0; round < 100; round++) {
+      l1.erase(l1.begin());
+      l1.append(std::to_string(round));
+    }
+    ASSERT_EQ(CountingNodeAllocatorStats::allocated, 4);
+    ASSERT_EQ(CountingNodeAllocatorStats::freed, 0);
+    l1.clear();
+    ASSERT_EQ(l1.pool_size(), 4);
+    l1.set_pool_limit(1);
+    ASSERT_EQ(CountingNodeAllocatorStats::freed, 3);
+  }
+  ASSERT_EQ(CountingNodeAllocatorStats::freed, CountingNodeAllocatorStats::allocated);
+}
+
+TEST(DLListTest, CanSplice) {
+  DLList<int> l1 { 1, 5 };
+  DLList<int> l2 { 2, 3, 4 };
+  l1.splice(l1.begin() + 1, l2);
+  ASSERT_TRUE(l2.is_empty());
+  ASSERT_EQ(l1.size(), 5);
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(l1[i], i + 1);
+  }
+  l2.splice(l2.end(), l1, l1.begin());
+  l2.splice(l2.begin(), l1, l1.begin() + 3);
+  ASSERT_EQ(l1.size(), 3);
+  ASSERT_EQ(l2.size(), 2);
+  ASSERT_EQ(l2.first(), 5);
+  ASSERT_EQ(l2.last(), 1);
+  ASSERT_EQ(l1.first(), 2);
+  ASSERT_EQ(l1.last(), 4);
+  DLList<int> l3 = l1;
+  l3.append(6);
+  ASSERT_EQ(l1.size(), 3);
+  ASSERT_EQ(l3.size(), 4);
+}
+
+struct Timer {
+  int deadline;
+  DLListHook<Timer> queue_hook;
+  DLListHook<Timer> lru_hook;
+};
+
+using TimerQueue = IntrusiveDLList<Timer, &Timer::queue_hook>;
+
+TEST(IntrusiveDLListTest, CanAppendIterateAndRemove) {
+  Timer timers[4] = { { 1 }, { 2 }, { 3 }, { 4 } };
+  TimerQueue q1;
+  for (auto& timer: timers) {
+    q1.append(timer);
+  }
+  ASSERT_EQ(q1.size(), 4);
+  q1.remove(timers[1]);
+  q1.remove(timers[3]);
+  int deadlines[2];
+  int k = 0;
+  for (auto& timer: q1) {
+    deadlines[k++] = timer.deadline;
+  }
+  ASSERT_EQ(k, 2);
+  ASSERT_EQ(deadlines[0], 1);
+  ASSERT_EQ(deadlines[1], 3);
+  q1.prepend(timers[3]);
+  q1.insert_after(q1.begin(), timers[1]);
+  ASSERT_EQ(q1[0].deadline, 4);
+  ASSERT_EQ(q1[1].deadline, 2);
+  ASSERT_EQ(q1.last().deadline, 3);
+  auto it = q1.erase(q1.begin());
+  ASSERT_EQ(it->deadline, 2);
+  ASSERT_EQ(q1.first().deadline, 2);
+}
+
+TEST(IntrusiveDLListTest, ObjectsCanBeOnSeveralListsAndMoveBetweenThem) {
+  Timer timers[3] = { { 1 }, { 2 }, { 3 } };
+  TimerQueue q1;
+  TimerQueue q2;
+  IntrusiveDLList<Timer, &Timer::lru_hook> lru;
+  for (auto& timer: timers) {
+    q1.append(timer);
+    lru.prepend(timer);
+  }
+  q2.splice(q2.end(), q1, q1.begin() + 1);
+  ASSERT_EQ(q1.size(), 2);
+  ASSERT_EQ(q2.first().deadline, 2);
+  q2.splice(q2.begin(), q1);
+  ASSERT_TRUE(q1.is_empty());
+  ASSERT_EQ(q2.size(), 3);
+  ASSERT_EQ(q2[0].deadline, 1);
+  ASSERT_EQ(q2[1].deadline, 3);
+  ASSERT_EQ(q2[2].deadline, 2);
+  ASSERT_EQ(lru.first().deadline, 3);
+  ASSERT_EQ(lru.last().deadline, 1);
+  lru.clear();
+  ASSERT_TRUE(timers[0].lru_hook.next_node == nullptr);
+  ASSERT_EQ(q2.size(), 3);
+}
+
+TEST(UnrolledDLListTest, CanAppendPrependAndIndex) {
+  UnrolledDLList<int, 4> l1;
+  for (int i = 0; i < 50; i++) {
+    l1.append(i);
+  }
+  l1.prepend(-1);
+  ASSERT_EQ(l1.size(), 51);
+  ASSERT_EQ(l1.first(), -1);
+  ASSERT_EQ(l1.last(), 49);
+  for (int i = 0; i < 50; i++) {
+    ASSERT_EQ(l1[i + 1], i);
+  }
+  int k = -1;
+  for (auto i: l1) {
+    ASSERT_EQ(i, k++);
+  }
+  ASSERT_EQ(k, 50);
+}
+
+TEST(UnrolledDLListTest, SplitsNodesWhenInsertingInTheMiddle) {
+  UnrolledDLList<std::string, 4> l1 { "a", "b", "c", "d", "e" };
+  l1.insert_after(l1.begin() + 1, "b2");
+  l1.insert_before(l1.begin() + 1, "a2");
+  l1.insert_before(l1.end(), "f");
+  const char* expected[] = { "a", "a2", "b", "b2", "c", "d", "e", "f" };
+  ASSERT_EQ(l1.size(), 8);
+  for (size_t i = 0; i < 8; i++) {
+    ASSERT_EQ(l1[i], expected[i]);
+  }
+  UnrolledDLList<std::string, 4> l2 = l1;
+  ASSERT_EQ(l2.size(), 8);
+  ASSERT_EQ(l2.last(), "f");
+}
+
+TEST(UnrolledDLListTest, CanEraseWhileIterating) {
+  UnrolledDLList<int, 8> l1;
+  for (int i = 0; i < 1000; i++) {
+    l1.append(i);
+  }
+  for (auto it = l1.begin(); it != l1.end();) {
+    if (*it % 3 != 0) {
+      it = l1.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ASSERT_EQ(l1.size(), 334);
+  int expected = 0;
+  for (auto i: l1) {
+    ASSERT_EQ(i, expected);
+    expected += 3;
+  }
+  for (size_t i = 0; i < l1.size(); i++) {
+    ASSERT_EQ(l1[i], int(i * 3));
+  }
+  l1.clear();
+  ASSERT_TRUE(l1.is_empty());
+  ASSERT_TRUE(l1.begin() == l1.end());
+}
@@ -0,0 +1,400 @@
+/// \file flat_map.hpp
+/// \brief Read-mostly maps and sets that are stored in a single array.
+
+#ifndef ZEN_FLAT_MAP_HPP
+#define ZEN_FLAT_MAP_HPP
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <utility>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+#include "zen/macros.h"
+#include "zen/range.hpp"
+#include "zen/vector.hpp"
+
+ZEN_NAMESPACE_START
+
+/// \brief How the elements of a FlatMap or FlatSet are ordered in memory.
+enum class FlatLayout {
+
+  /// Elements are sorted by key and looked up with a binary search.
+  /// Iteration visits the keys in order.
+  sorted,
+
+  /// Elements are stored in the breadth-first order of an implicit binary
+  /// search tree, which is known as the Eytzinger layout. The first levels
+  /// of the tree share a few cache lines, and the children of a node are
+  /// stored next to each other, so a lookup can prefetch the nodes it will
+  /// visit a few steps ahead. This is faster than a binary search when the
+  /// table does not fit in the cache, but iteration no longer visits the
+  /// keys in order.
+  eytzinger,
+
+};
+
+template<typename K, typename V>
+struct FlatMapEntry {
+  K key;
+  V value;
+};
+
+/// Prevents the generic swap() of this library and `std::swap` from being
+/// ambiguous when the standard algorithms reorder entries.
+template<typename K, typename V>
+inline void swap(FlatMapEntry<K, V>& a, FlatMapEntry<K, V>& b) {
+  std::swap(a.key, b.key);
+  std::swap(a.value, b.value);
+}
+
+/// Get the amount of elements of type `T` that fit in a cache line.
+template<typename T>
+constexpr size_t _flat_prefetch_stride() {
+  return sizeof(T) >= 64 ? 1 : 64 / sizeof(T);
+}
+
+/// Number the nodes of the implicit tree in the subtree rooted at the
+/// 1-based node `k`, so that `order[k - 1]` becomes the index of the sorted
+/// element that belongs at node `k`.
+inline void _flat_eytzinger_order(size_t* order, size_t sz, size_t& next, size_t k) {
+  if (k > sz) {
+    return;
+  }
+  _flat_eytzinger_order(order, sz, next, 2 * k);
+  order[k - 1] = next++;
+  _flat_eytzinger_order(order, sz, next, 2 * k + 1);
+}
+
+/// \brief The storage and lookup logic that FlatMap and FlatSet share.
+///
+/// A flat table has two phases. While it is being built, elements can be
+/// added in any order with insert(). A call to freeze() then sorts the
+/// elements and drops duplicate keys, keeping the element that was inserted
+/// first. Lookups are only allowed once the table is frozen. Tables that are
+/// constructed from a list of elements are frozen right away.
+template<
+  typename T,
+  typename K,
+  typename KeyOfT,
+  FlatLayout Layout,
+  typename CompareT,
+  typename AllocatorT
+>
+class _FlatTable {
+public:
+
+  using Key = K;
+  using Value = T;
+  using Size = size_t;
+  using Iter = T*;
+  using ConstIter = const T*;
+  using Range = IterRange<Iter>;
+  using ConstRange = IterRange<ConstIter>;
+
+  using key_type = K;
+  using value_type = T;
+  using size_type = size_t;
+
+protected:
+
+  Vector<T, size_t, AllocatorT> _elements;
+  CompareT _compare;
+  bool _frozen = false;
+
+  static inline const K& key_of(const T& element) {
+    return KeyOfT()(element);
+  }
+
+  inline const T* lower_bound_sorted(const K& key) const {
+    // A branchless binary search: the loop always runs log2(n) times, and
+    // the comparison compiles to a conditional move.
+    auto base = _elements.data();
+    auto n = _elements.size();
+    if (n == 0) {
+      return base;
+    }
+    while (n > 1) {
+      auto half = n / 2;
+      __builtin_prefetch(base + half / 2);
+      __builtin_prefetch(base + half + half / 2);
+      base = _compare(key_of(base[half]), key) ? base + half : base;
+      n -= half;
+    }
+    return base + _compare(key_of(*base), key);
+  }
+
+  inline const T* lower_bound_eytzinger(const K& key) const {
+    constexpr size_t stride = _flat_prefetch_stride<T>();
+    auto elements = _elements.data();
+    auto n = _elements.size();
+    size_t k = 1;
+    while (k <= n) {
+      // The descendants of `k` that are log2(stride) levels down share one
+      // cache line, so fetch it while the comparisons of the next levels
+      // run.
+      __builtin_prefetch(reinterpret_cast<const char*>(elements) + (k * stride - 1) * sizeof(T));
+      k = 2 * k + _compare(key_of(elements[k - 1]), key);
+    }
+    // Every step to the right set a 1 bit. Undo the steps that came after
+    // the last step to the left, which leads back to the first node whose
+    // key is not less than `key`.
+    k >>= __builtin_ffsll(~k);
+    return k == 0 ? elements + n : elements + k - 1;
+  }
+
+  inline const T* find_element(const K& key) const {
+    ZEN_ASSERT(_frozen);
+    const T* match;
+    if constexpr (Layout == FlatLayout::eytzinger) {
+      match = lower_bound_eytzinger(key);
+    } else {
+      match = lower_bound_sorted(key);
+    }
+    auto end = _elements.data() + _elements.size();
+    if (match == end || _compare(key, key_of(*match))) {
+      return end;
+    }
+    return match;
+  }
+
+  template<typename RangeT>
+  inline _FlatTable(RangeT&& range, CompareT compare, AllocatorT allocator):
+    _elements(0, allocator), _compare(compare) {
+      for (auto&& element: range) {
+        _elements.append(element);
+      }
+      freeze();
+    }
+
+  inline _FlatTable(CompareT compare, AllocatorT allocator):
+    _elements(0, allocator), _compare(compare) {}
+
+public:
+
+  /// \brief Add an element while the table is being built.
+  inline void insert(T element) {
+    ZEN_ASSERT(!_frozen);
+    _elements.append(std::move(element));
+  }
+
+  /// \brief Make room for `count` elements before inserting them.
+  inline void reserve(size_t count) {
+    _elements.reserve(count);
+  }
+
+  /// \brief Sort the elements and make the table ready for lookups.
+  ///
+  /// If several elements have the same key, only the one that was inserted
+  /// first is kept. No more elements may be inserted afterwards.
+  inline void freeze() {
+    ZEN_ASSERT(!_frozen);
+    _frozen = true;
+    auto first = _elements.data();
+    auto last = first + _elements.size();
+    std::stable_sort(first, last, [&](const T& a, const T& b) {
+      return _compare(key_of(a), key_of(b));
+    });
+    last = std::unique(first, last, [&](const T& a, const T& b) {
+      return !_compare(key_of(a), key_of(b));
+    });
+    size_t sz = last - first;
+    if constexpr (Layout == FlatLayout::eytzinger) {
+      Vector<size_t> order;
+      order.resize_uninitialized(sz);
+      size_t next = 0;
+      _flat_eytzinger_order(order.data(), sz, next, 1);
+      Vector<T, size_t, AllocatorT> permuted(sz, _elements.allocator());
+      for (size_t i = 0; i < sz; i++) {
+        permuted.append(std::move(first[order[i]]));
+      }
+      _elements = std::move(permuted);
+    } else if (sz < _elements.size()) {
+      Vector<T, size_t, AllocatorT> unique(sz, _elements.allocator());
+      for (size_t i = 0; i < sz; i++) {
+        unique.append(std::move(first[i]));
+      }
+      _elements = std::move(unique);
+    }
+  }
+
+  inline bool is_frozen() const {
+    return _frozen;
+  }
+
+  inline bool contains(const K& key) const {
+    return find_element(key) != _elements.data() + _elements.size();
+  }
+
+  /// \brief Get the elements in the order in which they are stored.
+  ///
+  /// This is sorted order for FlatLayout::sorted and breadth-first tree order
+  /// for FlatLayout::eytzinger.
+  inline ConstIter begin() const {
+    return _elements.data();
+  }
+
+  inline ConstIter end() const {
+    return _elements.data() + _elements.size();
+  }
+
+  inline ConstRange range() const {
+    return make_iter_range(begin(), end());
+  }
+
+  inline bool is_empty() const {
+    return _elements.size() == 0;
+  }
+
+  inline size_t size() const {
+    return _elements.size();
+  }
+
+};
+
+template<typename K, typename V>
+struct _FlatMapKey {
+  inline const K& operator()(const FlatMapEntry<K, V>& entry) const {
+    return entry.key;
+  }
+};
+
+template<typename K>
+struct _FlatSetKey {
+  inline const K& operator()(const K& key) const {
+    return key;
+  }
+};
+
+/// \brief A map that is built once and then only read.
+///
+/// The entries are kept in one contiguous array, which takes less memory
+/// than a hash table and makes lookups in small tables very cheap.
+///
+/// ```
+/// FlatMap<std::string_view, TokenType> keywords {
+///   { "if", TokenType::if_keyword },
+///   { "while", TokenType::while_keyword },
+/// };
+/// auto match = keywords.find("while");
+/// if (match != keywords.end()) {
+///   // ...
+/// }
+/// ```
+///
+/// \see FlatLayout for choosing between a sorted array and the Eytzinger
+/// layout.
+template<
+  typename K,
+  typename V,
+  FlatLayout Layout = FlatLayout::sorted,
+  typename CompareT = std::less<K>,
+  typename AllocatorT = DefaultAllocator<FlatMapEntry<K, V>>
+>
+class FlatMap : public _FlatTable<FlatMapEntry<K, V>, K, _FlatMapKey<K, V>, Layout, CompareT, AllocatorT> {
+
+  using Base = _FlatTable<FlatMapEntry<K, V>, K, _FlatMapKey<K, V>, Layout, CompareT, AllocatorT>;
+
+public:
+
+  using Entry = FlatMapEntry<K, V>;
+  using Iter = typename Base::Iter;
+  using ConstIter = typename Base::ConstIter;
+
+  using mapped_type = V;
+
+  /// \brief Create an empty map that can be filled with insert() before it
+  /// is frozen.
+  inline FlatMap(CompareT compare = CompareT(), AllocatorT allocator = AllocatorT()):
+    Base(compare, allocator) {}
+
+  /// \brief Create a frozen map from a list of entries.
+  inline FlatMap(std::initializer_list<Entry> entries, CompareT compare = CompareT(), AllocatorT allocator = AllocatorT()):
+    Base(entries, compare, allocator) {}
+
+  /// \brief Create a frozen map from a range of entries.
+  template<typename RangeT>
+  static inline FlatMap from_range(RangeT&& range, CompareT compare = CompareT(), AllocatorT allocator = AllocatorT()) {
+    FlatMap result(compare, allocator);
+    for (auto&& entry: range) {
+      result._elements.append(entry);
+    }
+    result.freeze();
+    return result;
+  }
+
+  using Base::insert;
+
+  inline void insert(K key, V value) {
+    Base::insert(Entry { std::move(key), std::move(value) });
+  }
+
+  /// \brief Find the entry of `key`, or return end() if there is none.
+  inline ConstIter find(const K& key) const {
+    return this->find_element(key);
+  }
+
+  /// \brief Find the entry of `key`, so that its value can be changed.
+  inline Iter find(const K& key) {
+    return const_cast<Iter>(this->find_element(key));
+  }
+
+  /// \brief Get the value of a key that must be present.
+  inline const V& operator[](const K& key) const {
+    auto match = find(key);
+    ZEN_ASSERT(match != this->end());
+    return match->value;
+  }
+
+};
+
+/// \brief A set that is built once and then only read.
+///
+/// \see FlatMap
+template<
+  typename K,
+  FlatLayout Layout = FlatLayout::sorted,
+  typename CompareT = std::less<K>,
+  typename AllocatorT = DefaultAllocator<K>
+>
+class FlatSet : public _FlatTable<K, K, _FlatSetKey<K>, Layout, CompareT, AllocatorT> {
+
+  using Base = _FlatTable<K, K, _FlatSetKey<K>, Layout, CompareT, AllocatorT>;
+
+public:
+
+  using ConstIter = typename Base::ConstIter;
+
+  /// \brief Create an empty set that can be filled with insert() before it
+  /// is frozen.
+  inline FlatSet(CompareT compare = CompareT(), AllocatorT allocator = AllocatorT()):
+    Base(compare, allocator) {}
+
+  /// \brief Create a frozen set from a list of keys.
+  inline FlatSet(std::initializer_list<K> keys, CompareT compare = CompareT(), AllocatorT allocator = AllocatorT()):
+    Base(keys, compare, allocator) {}
+
+  /// \brief Create a frozen set from a range of keys.
+  template<typename RangeT>
+  static inline FlatSet from_range(RangeT&& range, CompareT compare = CompareT(), AllocatorT allocator = AllocatorT()) {
+    FlatSet result(compare, allocator);
+    for (auto&& key: range) {
+      result._elements.append(key);
+    }
+    result.freeze();
+    return result;
+  }
+
+  /// \brief Find `key`, or return end() if it is not in this set.
+  inline ConstIter find(const K& key) const {
+    return this->find_element(key);
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_FLAT_MAP_HPP
@@ -0,0 +1,108 @@
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "zen/arena_allocator.hpp"
+#include "zen/flat_map.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(FlatMapTest, CanFindKeysInSortedLayout) {
+  FlatMap<std::string_view, int> m1 {
+    { "while", 1 },
+    { "if", 2 },
+    { "else", 3 },
+    { "return", 4 },
+  };
+  ASSERT_TRUE(m1.is_frozen());
+  ASSERT_EQ(m1.size(), 4);
+  ASSERT_EQ(m1["while"], 1);
+  ASSERT_EQ(m1["if"], 2);
+  ASSERT_EQ(m1["else"], 3);
+  ASSERT_EQ(m1["return"], 4);
+  ASSERT_TRUE(m1.find("for") == m1.end());
+  ASSERT_FALSE(m1.contains("a"));
+  ASSERT_FALSE(m1.contains("zzz"));
+  std::vector<std::string_view> keys;
+  for (auto& entry: m1) {
+    keys.push_back(entry.key);
+  }
+  ASSERT_EQ(keys, (std::vector<std::string_view> { "else", "if", "return", "while" }));
+}
+
+TEST(FlatMapTest, KeepsFirstOfDuplicateKeys) {
+  FlatMap<std::string, int> m1;
+  m1.insert("b", 1);
+  m1.insert("a", 2);
+  m1.insert("b", 3);
+  ASSERT_FALSE(m1.is_frozen());
+  m1.freeze();
+  ASSERT_EQ(m1.size(), 2);
+  ASSERT_EQ(m1["b"], 1);
+  m1.find("a")->value = 5;
+  ASSERT_EQ(m1["a"], 5);
+}
+
+template<FlatLayout Layout>
+static void test_all_sizes() {
+  for (int n = 0; n < 300; n++) {
+    FlatMap<int, int, Layout> m1;
+    for (int i = n - 1; i >= 0; i--) {
+      m1.insert(i * 2, i);
+    }
+    m1.freeze();
+    ASSERT_EQ(m1.size(), n);
+    for (int i = -1; i < n * 2 + 1; i++) {
+      auto match = m1.find(i);
+      if (i >= 0 && i < n * 2 && i % 2 == 0) {
+        ASSERT_TRUE(match != m1.end());
+        ASSERT_EQ(match->value, i / 2);
+      } else {
+        ASSERT_TRUE(match == m1.end());
+      }
+    }
+  }
+}
+
+TEST(FlatMapTest, FindsEveryKeyForAllSizes) {
+  test_all_sizes<FlatLayout::sorted>();
+  test_all_sizes<FlatLayout::eytzinger>();
+}
+
+TEST(FlatMapTest, StoresEytzingerLayoutInBreadthFirstOrder) {
+  FlatSet<int, FlatLayout::eytzinger> s1 { 1, 2, 3, 4, 5, 6, 7 };
+  std::vector<int> keys(s1.begin(), s1.end());
+  ASSERT_EQ(keys, (std::vector<int> { 4, 2, 6, 1, 3, 5, 7 }));
+}
+
+TEST(FlatSetTest, CanBuildFromRange) {
+  std::vector<std::string> words { "b", "c", "a", "c" };
+  auto s1 = FlatSet<std::string>::from_range(words);
+  ASSERT_EQ(s1.size(), 3);
+  ASSERT_TRUE(s1.contains("a"));
+  ASSERT_TRUE(s1.contains("c"));
+  ASSERT_FALSE(s1.contains("d"));
+  ASSERT_EQ(*s1.find("b"), "b");
+  ASSERT_TRUE(s1.find("d") == s1.end());
+}
+
+TEST(FlatMapTest, KeepsAllocatorWhenFreezing) {
+  using Entry = FlatMapEntry<int, int>;
+  Arena arena;
+  std::less<int> compare;
+  FlatMap<int, int, FlatLayout::sorted, std::less<int>, ArenaAllocator<Entry>> m1(compare, ArenaAllocator<Entry>(arena));
+  FlatMap<int, int, FlatLayout::eytzinger, std::less<int>, ArenaAllocator<Entry>> m2(compare, ArenaAllocator<Entry>(arena));
+  for (int i = 0; i < 100; i++) {
+    m1.insert(i % 50, i);
+    m2.insert(i % 50, i);
+  }
+  m1.freeze();
+  m2.freeze();
+  ASSERT_EQ(m1.size(), 50);
+  ASSERT_EQ(m2.size(), 50);
+  ASSERT_EQ(m1[7], 7);
+  ASSERT_EQ(m2[7], 7);
+}
@@ -0,0 +1,246 @@
+/// \file hash.hpp
+/// \brief Fast non-cryptographic hash functions and the Hash customization
+/// point.
+///
+/// hash_bytes() is a port of [wyhash](https://github.com/wangyi-fudan/wyhash)
+/// (final version 4, released into the public domain by Wang Yi). It hashes
+/// long inputs at several bytes per cycle and short inputs in a handful of
+/// multiplications. All functions in this file are `constexpr`, so keys can
+/// be hashed at compile time and will match the hashes computed at run-time:
+///
+/// ```
+/// constexpr auto keyword_hash = hash_literal("while");
+/// static_assert(keyword_hash == Hash<std::string_view>()("while"));
+/// ```
+///
+/// None of these functions are suitable for security purposes. The hashes
+/// are not guaranteed to be stable across versions of this library, so do
+/// not persist them.
+
+#ifndef ZEN_HASH_HPP
+#define ZEN_HASH_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "zen/config.h"
+
+ZEN_NAMESPACE_START
+
+/// Multiply `a` and `b` into a 128-bit product and store its low half in `a`
+/// and its high half in `b`.
+constexpr void _hash_multiply(uint64_t& a, uint64_t& b) {
+#ifdef __SIZEOF_INT128__
+  __uint128_t product = __uint128_t(a) * b;
+  a = uint64_t(product);
+  b = uint64_t(product >> 64);
+#else
+  uint64_t a_hi = a >> 32, a_lo = uint32_t(a);
+  uint64_t b_hi = b >> 32, b_lo = uint32_t(b);
+  uint64_t hh = a_hi * b_hi, hl = a_hi * b_lo, lh = a_lo * b_hi, ll = a_lo * b_lo;
+  uint64_t mid = (ll >> 32) + uint32_t(hl) + uint32_t(lh);
+  a = (mid << 32) | uint32_t(ll);
+  b = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+#endif
+}
+
+constexpr uint64_t _hash_mix(uint64_t a, uint64_t b) {
+  _hash_multiply(a, b);
+  return a ^ b;
+}
+
+inline constexpr uint64_t _hash_secret[4] = {
+  0x2d358dccaa6c78a5ull,
+  0x8bb84b93962eacc9ull,
+  0x4b33a62ed433d4a3ull,
+  0x4d5a2da51de1aa47ull,
+};
+
+// The readers assemble little-endian words from single bytes so that they
+// work in constant expressions. Compilers turn them into plain loads.
+
+template<typename ByteT>
+constexpr uint64_t _hash_read4(const ByteT* p) {
+  return uint64_t(uint8_t(p[0]))
+       | uint64_t(uint8_t(p[1])) << 8
+       | uint64_t(uint8_t(p[2])) << 16
+       | uint64_t(uint8_t(p[3])) << 24;
+}
+
+template<typename ByteT>
+constexpr uint64_t _hash_read8(const ByteT* p) {
+  return uint64_t(uint8_t(p[0]))
+       | uint64_t(uint8_t(p[1])) << 8
+       | uint64_t(uint8_t(p[2])) << 16
+       | uint64_t(uint8_t(p[3])) << 24
+       | uint64_t(uint8_t(p[4])) << 32
+       | uint64_t(uint8_t(p[5])) << 40
+       | uint64_t(uint8_t(p[6])) << 48
+       | uint64_t(uint8_t(p[7])) << 56;
+}
+
+/// Read 1 to 3 bytes.
+template<typename ByteT>
+constexpr uint64_t _hash_read3(const ByteT* p, size_t len) {
+  return (uint64_t(uint8_t(p[0])) << 16) | (uint64_t(uint8_t(p[len >> 1])) << 8) | uint8_t(p[len - 1]);
+}
+
+/// \brief Hash the `len` bytes at `data`.
+///
+/// `ByteT` must be a byte-sized type such as `char` or `unsigned char`. Use
+/// the overload that accepts a `void` pointer for arbitrary memory.
+template<typename ByteT>
+constexpr uint64_t hash_bytes(const ByteT* data, size_t len, uint64_t seed = 0) {
+  static_assert(sizeof(ByteT) == 1, "hash_bytes() reads data one byte at a time");
+  auto p = data;
+  seed ^= _hash_mix(seed ^ _hash_secret[0], _hash_secret[1]);
+  uint64_t a = 0;
+  uint64_t b = 0;
+  if (len <= 16) {
+    if (len >= 4) {
+      auto offset = (len >> 3) << 2;
+      a = (_hash_read4(p) << 32) | _hash_read4(p + offset);
+      b = (_hash_read4(p + len - 4) << 32) | _hash_read4(p + len - 4 - offset);
+    } else if (len > 0) {
+      a = _hash_read3(p, len);
+    }
+  } else {
+    auto i = len;
+    if (i >= 48) {
+      // Three independent lanes keep the multipliers busy.
+      auto see1 = seed;
+      auto see2 = seed;
+      do {
+        seed = _hash_mix(_hash_read8(p) ^ _hash_secret[1], _hash_read8(p + 8) ^ seed);
+        see1 = _hash_mix(_hash_read8(p + 16) ^ _hash_secret[2], _hash_read8(p + 24) ^ see1);
+        see2 = _hash_mix(_hash_read8(p + 32) ^ _hash_secret[3], _hash_read8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i >= 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = _hash_mix(_hash_read8(p) ^ _hash_secret[1], _hash_read8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = _hash_read8(p + i - 16);
+    b = _hash_read8(p + i - 8);
+  }
+  a ^= _hash_secret[1];
+  b ^= seed;
+  _hash_multiply(a, b);
+  return _hash_mix(a ^ _hash_secret[0] ^ len, b ^ _hash_secret[1]);
+}
+
+inline uint64_t hash_bytes(const void* data, size_t len, uint64_t seed = 0) {
+  return hash_bytes(static_cast<const unsigned char*>(data), len, seed);
+}
+
+/// \brief Hash a string literal, excluding its terminating null character.
+template<size_t N>
+constexpr uint64_t hash_literal(const char (&literal)[N], uint64_t seed = 0) {
+  return hash_bytes(literal, N - 1, seed);
+}
+
+/// \brief Scramble the bits of an integer.
+///
+/// Every bit of the input affects every bit of the output, so keys that only
+/// differ in their high bits, or that are multiples of a power of two, still
+/// end up far apart in a hash table.
+constexpr uint64_t hash_int(uint64_t value) {
+  // A single round leaves the output bits slightly biased.
+  auto mixed = _hash_mix(value ^ _hash_secret[0], _hash_secret[1]);
+  return _hash_mix(mixed ^ _hash_secret[2], _hash_secret[3]);
+}
+
+/// \brief Combine the hash of another value into `seed`.
+///
+/// The result depends on the order in which hashes are combined.
+constexpr uint64_t hash_combine(uint64_t seed, uint64_t value) {
+  return _hash_mix(seed ^ _hash_secret[2], value ^ _hash_secret[3]);
+}
+
+/// \brief Computes the hash of a `T`.
+///
+/// Hash is specialized for integers, enumerations, pointers, floating-point
+/// numbers and all standard strings and string views, including ByteString
+/// and String. Other types fall back to `std::hash`, whose result is
+/// scrambled with hash_int().
+///
+/// To make your own type hashable, specialize this template:
+///
+/// ```
+/// template<>
+/// struct zen::Hash<Point> {
+///   size_t operator()(const Point& p) const {
+///     return hash_combine(hash_int(p.x), hash_int(p.y));
+///   }
+/// };
+/// ```
+template<typename T, typename Enabler = void>
+struct Hash {
+  inline size_t operator()(const T& value) const {
+    return hash_int(std::hash<T>()(value));
+  }
+};
+
+template<typename T>
+struct Hash<T, std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>>> {
+  constexpr size_t operator()(T value) const {
+    return hash_int(uint64_t(value));
+  }
+};
+
+template<typename T>
+struct Hash<T*> {
+  inline size_t operator()(T* value) const {
+    return hash_int(reinterpret_cast<uintptr_t>(value));
+  }
+};
+
+template<typename T>
+struct Hash<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+  inline size_t operator()(T value) const {
+    // 0.0 and -0.0 compare equal, so they must hash the same.
+    if (value == 0) {
+      return hash_int(0);
+    }
+    if constexpr (sizeof(T) <= sizeof(uint64_t)) {
+      uint64_t bits = 0;
+      memcpy(&bits, &value, sizeof(T));
+      return hash_int(bits);
+    } else {
+      // Wider types may contain padding bytes with arbitrary contents.
+      return Hash<double>()(double(value));
+    }
+  }
+};
+
+template<typename CharT, typename TraitsT>
+struct Hash<std::basic_string_view<CharT, TraitsT>> {
+  constexpr size_t operator()(std::basic_string_view<CharT, TraitsT> str) const {
+    if constexpr (sizeof(CharT) == 1) {
+      return hash_bytes(str.data(), str.size());
+    } else {
+      return hash_bytes(static_cast<const void*>(str.data()), str.size() * sizeof(CharT));
+    }
+  }
+};
+
+template<typename CharT, typename TraitsT, typename AllocatorT>
+struct Hash<std::basic_string<CharT, TraitsT, AllocatorT>> {
+  inline size_t operator()(const std::basic_string<CharT, TraitsT, AllocatorT>& str) const {
+    return Hash<std::basic_string_view<CharT, TraitsT>>()(str);
+  }
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_HASH_HPP
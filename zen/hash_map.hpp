@@ -1,21 +1,643 @@
+/// \file hash_map.hpp
+/// \brief An unordered map that uses open addressing with SIMD probing.
+
 #ifndef ZEN_HASH_MAP_HPP
 #define ZEN_HASH_MAP_HPP
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <functional>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
+#include "zen/config.h"
 #include "zen/allocator.hpp"
+#include "zen/hash.hpp"
+#include "zen/macros.h"
+#include "zen/range.hpp"
 
 ZEN_NAMESPACE_START
 
+/// \brief A key/value pair that is stored in a HashMap.
+///
+/// Entries are plain aggregates, so they can be unpacked with a structured
+/// binding:
+///
+/// ```
+/// for (auto& [name, age]: ages) {
+///   // ...
+/// }
+/// ```
+template<typename K, typename V>
+struct HashMapEntry {
+  K key;
+  V value;
+};
+
+/// Control bytes that do not hold the low hash bits of a full slot.
+enum : int8_t {
+  _hash_map_empty = -128,
+  _hash_map_deleted = -2,
+};
+
+/// \brief A block of 16 control bytes that is matched against a value in a
+/// single step.
+///
+/// Every match returns a bitmask where bit `i` is set if control byte `i`
+/// matched.
+struct _HashMapGroup {
+
+  static constexpr size_t width = 16;
+
+#ifdef __SSE2__
+
+  __m128i ctrl;
+
+  inline explicit _HashMapGroup(const int8_t* pos):
+    ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+  inline uint32_t match(int8_t h2) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+  }
+
+  inline uint32_t match_empty() const {
+    return match(_hash_map_empty);
+  }
+
+  inline uint32_t match_empty_or_deleted() const {
+    // Full slots hold a non-negative value, so only the special values are
+    // less than -1.
+    return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl));
+  }
+
+#else
+
+  int8_t ctrl[width];
+
+  inline explicit _HashMapGroup(const int8_t* pos) {
+    memcpy(ctrl, pos, width);
+  }
+
+  inline uint32_t match(int8_t h2) const {
+    uint32_t result = 0;
+    for (size_t i = 0; i < width; i++) {
+      result |= uint32_t(ctrl[i] == h2) << i;
+    }
+    return result;
+  }
+
+  inline uint32_t match_empty() const {
+    return match(_hash_map_empty);
+  }
+
+  inline uint32_t match_empty_or_deleted() const {
+    uint32_t result = 0;
+    for (size_t i = 0; i < width; i++) {
+      result |= uint32_t(ctrl[i] < -1) << i;
+    }
+    return result;
+  }
+
+#endif
+
+};
+
 template<
-  typename T,
+  typename K,
+  typename V,
+  typename HashT = Hash<K>,
   typename SizeT = size_t,
-  typename AllocatorT = DefaultAllocator<T>
+  typename AllocatorT = DefaultAllocator<HashMapEntry<K, V>>
+>
+class HashMap;
+
+/// `IsConst` selects between an iterator that can change the values of the
+/// entries and one that cannot.
+template<
+  typename K,
+  typename V,
+  typename HashT,
+  typename SizeT,
+  typename AllocatorT,
+  bool IsConst = false
+>
+class HashMapIter {
+
+  friend class HashMap<K, V, HashT, SizeT, AllocatorT>;
+  friend class HashMapIter<K, V, HashT, SizeT, AllocatorT, !IsConst>;
+
+  using Entry = std::conditional_t<IsConst, const HashMapEntry<K, V>, HashMapEntry<K, V>>;
+
+  const int8_t* ctrl;
+  Entry* slots;
+  SizeT index;
+  SizeT capacity;
+
+  inline void skip_free() {
+    while (index < capacity && ctrl[index] < 0) {
+      index++;
+    }
+  }
+
+public:
+
+  using Value = Entry;
+  using Size = SizeT;
+  using Diff = MakeDiffT<SizeT>;
+
+  using value_type = Value;
+
+  inline HashMapIter(const int8_t* ctrl, Entry* slots, SizeT index, SizeT capacity):
+    ctrl(ctrl), slots(slots), index(index), capacity(capacity) {
+      skip_free();
+    }
+
+  /// Allows an iterator to be converted into a const iterator.
+  template<bool OtherIsConst, typename = std::enable_if_t<IsConst && !OtherIsConst>>
+  inline HashMapIter(const HashMapIter<K, V, HashT, SizeT, AllocatorT, OtherIsConst>& other):
+    ctrl(other.ctrl), slots(other.slots), index(other.index), capacity(other.capacity) {}
+
+  template<bool OtherIsConst>
+  bool operator==(const HashMapIter<K, V, HashT, SizeT, AllocatorT, OtherIsConst>& other) const {
+    return other.slots == slots && other.index == index;
+  }
+
+  template<bool OtherIsConst>
+  bool operator!=(const HashMapIter<K, V, HashT, SizeT, AllocatorT, OtherIsConst>& other) const {
+    return !(*this == other);
+  }
+
+  Entry& operator*() const {
+    return slots[index];
+  }
+
+  Entry* operator->() const {
+    return &slots[index];
+  }
+
+  HashMapIter& operator++() {
+    index++;
+    skip_free();
+    return *this;
+  }
+
+};
+
+/// \brief An unordered map from keys of type `K` to values of type `V`.
+///
+/// The map is a so-called Swiss table. Entries are stored inline in a
+/// single array of slots, without any nodes or pointers in between. Next to
+/// the slots, every slot has a control byte that either marks it as empty,
+/// as deleted, or as full, in which case it holds 7 bits of the key's hash.
+///
+/// A lookup compares a whole group of 16 control bytes against the hash bits
+/// of the key at once, using SSE2 when it is available. Only the slots whose
+/// control byte matched are compared with the key itself, which almost
+/// always means a single key comparison per lookup. Groups are probed
+/// quadratically until a group with an empty slot is found.
+///
+/// The table is kept at most 7/8 full. When it runs out of room, the entries
+/// are moved to a table of twice the capacity, which invalidates all
+/// iterators and references to entries.
+///
+/// `HashT` is called with a key and must return a `size_t`. It defaults to
+/// Hash. Its result is mixed once more by the map, so that weak hash
+/// functions such as the identity on integers still spread keys evenly.
+template<
+  typename K,
+  typename V,
+  typename HashT,
+  typename SizeT,
+  typename AllocatorT
 >
 class HashMap {
+public:
+
+  using Key = K;
+  using Entry = HashMapEntry<K, V>;
+  using Value = Entry;
+  using Size = SizeT;
+  using Iter = HashMapIter<K, V, HashT, SizeT, AllocatorT>;
+  using ConstIter = HashMapIter<K, V, HashT, SizeT, AllocatorT, true>;
+  using Range = IterRange<Iter>;
+  using ConstRange = IterRange<ConstIter>;
+
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = Entry;
+  using size_type = SizeT;
+
+private:
+
+  using Group = _HashMapGroup;
+  using CtrlAllocator = RebindAllocatorT<AllocatorT, int8_t>;
+
+  static constexpr SizeT min_capacity = Group::width;
+
+  HashT _hash;
+  AllocatorT _allocator;
+  CtrlAllocator _ctrl_allocator;
+  int8_t* _ctrl;
+  Entry* _slots;
+  SizeT _capacity;
+  SizeT _sz;
+  SizeT _growth_left;
+
+  static inline SizeT max_load(SizeT capacity) {
+    return capacity - capacity / 8;
+  }
+
+  inline size_t hash(const K& key) const {
+    // Spread the hash so that all of its bits influence both the group index
+    // and the 7 bits stored in the control byte.
+    uint64_t value = _hash(key);
+#ifdef __SIZEOF_INT128__
+    __uint128_t product = __uint128_t(value) * 0x9e3779b97f4a7c15ull;
+    return size_t(uint64_t(product) ^ uint64_t(product >> 64));
+#else
+    value *= 0x9e3779b97f4a7c15ull;
+    return size_t(value ^ (value >> 32));
+#endif
+  }
+
+  static inline int8_t h2(size_t hash) {
+    return int8_t(hash & 0x7f);
+  }
+
+  inline SizeT group_mask() const {
+    return _capacity / Group::width - 1;
+  }
+
+  /// Get the index of the slot that holds `key`, or `_capacity` if the key
+  /// is not in the map.
+  inline SizeT find_index(const K& key, size_t hash) const {
+    if (_capacity == 0) {
+      return _capacity;
+    }
+    auto mask = group_mask();
+    auto group = SizeT(hash >> 7) & mask;
+    for (SizeT step = 1;; step++) {
+      auto offset = group * Group::width;
+      Group g(_ctrl + offset);
+      for (auto bits = g.match(h2(hash)); bits != 0; bits &= bits - 1) {
+        auto index = offset + __builtin_ctz(bits);
+        if (_slots[index].key == key) {
+          return index;
+        }
+      }
+      if (g.match_empty() != 0) {
+        return _capacity;
+      }
+      group = (group + step) & mask;
+    }
+  }
+
+  /// Get the index of the first slot on the probe sequence of `hash` that
+  /// is free to take a new entry.
+  inline SizeT find_free(size_t hash) const {
+    auto mask = group_mask();
+    auto group = SizeT(hash >> 7) & mask;
+    for (SizeT step = 1;; step++) {
+      auto offset = group * Group::width;
+      auto bits = Group(_ctrl + offset).match_empty_or_deleted();
+      if (bits != 0) {
+        return offset + __builtin_ctz(bits);
+      }
+      group = (group + step) & mask;
+    }
+  }
+
+  inline void destroy_all() {
+    for (SizeT i = 0; i < _capacity; i++) {
+      if (_ctrl[i] >= 0) {
+        _slots[i].~Entry();
+      }
+    }
+    if (_capacity > 0) {
+      _ctrl_allocator.free(_ctrl, _capacity);
+      _allocator.free(_slots, _capacity);
+    }
+  }
+
+  /// Move all entries to a new table with `new_capacity` slots, which must
+  /// be a power of two that is at least min_capacity.
+  inline void rehash(SizeT new_capacity) {
+    auto old_ctrl = _ctrl;
+    auto old_slots = _slots;
+    auto old_capacity = _capacity;
+    _ctrl = _ctrl_allocator.allocate(new_capacity);
+    _slots = _allocator.allocate(new_capacity);
+    ZEN_ASSERT(_ctrl != nullptr && _slots != nullptr);
+    memset(_ctrl, _hash_map_empty, new_capacity);
+    _capacity = new_capacity;
+    _growth_left = max_load(new_capacity) - _sz;
+    for (SizeT i = 0; i < old_capacity; i++) {
+      if (old_ctrl[i] >= 0) {
+        auto h = hash(old_slots[i].key);
+        auto index = find_free(h);
+        _ctrl[index] = h2(h);
+        relocate_n(old_slots + i, 1, _slots + index);
+      }
+    }
+    if (old_capacity > 0) {
+      _ctrl_allocator.free(old_ctrl, old_capacity);
+      _allocator.free(old_slots, old_capacity);
+    }
+  }
+
+  /// Make room for one more entry, either by growing the table or, if it is
+  /// mostly filled with deleted slots, by rehashing it at the same size.
+  inline void grow() {
+    if (_capacity == 0) {
+      rehash(min_capacity);
+    } else if (_sz < max_load(_capacity) / 2) {
+      rehash(_capacity);
+    } else {
+      rehash(_capacity * 2);
+    }
+  }
+
+  /// Claim a free slot for a key with the given hash, growing the table if
+  /// needed. The caller must construct the entry in the returned slot.
+  inline SizeT prepare_insert(size_t hash) {
+    if (_capacity == 0) {
+      grow();
+    }
+    auto index = find_free(hash);
+    if (_growth_left == 0 && _ctrl[index] == _hash_map_empty) {
+      grow();
+      index = find_free(hash);
+    }
+    if (_ctrl[index] == _hash_map_empty) {
+      _growth_left--;
+    }
+    _ctrl[index] = h2(hash);
+    _sz++;
+    return index;
+  }
+
+  inline Iter make_iter(SizeT index) {
+    return Iter(_ctrl, _slots, index, _capacity);
+  }
+
+  inline ConstIter make_iter(SizeT index) const {
+    return ConstIter(_ctrl, _slots, index, _capacity);
+  }
+
+  /// `KeyT` is either `const K&` or `K`, so that a copy of the key is only
+  /// made when a new entry is constructed.
+  template<typename KeyT, typename ...ForwardArgs>
+  inline std::pair<Iter, bool> emplace_impl(KeyT&& key, ForwardArgs&& ...args) {
+    auto h = hash(key);
+    auto index = find_index(key, h);
+    if (index != _capacity) {
+      return { make_iter(index), false };
+    }
+    if (_growth_left == 0) {
+      // Construct the entry before growing the table, because the arguments
+      // might refer to values in the old slots.
+      Entry entry { K(std::forward<KeyT>(key)), V(std::forward<ForwardArgs>(args)...) };
+      index = prepare_insert(h);
+      new (_slots + index) Entry(std::move(entry));
+      return { make_iter(index), true };
+    }
+    index = prepare_insert(h);
+    new (_slots + index) Entry { K(std::forward<KeyT>(key)), V(std::forward<ForwardArgs>(args)...) };
+    return { make_iter(index), true };
+  }
 
 public:
 
+  inline HashMap(HashT hash = HashT(), AllocatorT allocator = AllocatorT()):
+    _hash(hash),
+    _allocator(allocator),
+    _ctrl_allocator(rebind_allocator<int8_t>(allocator)),
+    _ctrl(nullptr),
+    _slots(nullptr),
+    _capacity(0),
+    _sz(0),
+    _growth_left(0) {}
+
+  inline HashMap(std::initializer_list<Entry> entries, HashT hash = HashT(), AllocatorT allocator = AllocatorT()):
+    HashMap(hash, allocator) {
+      reserve(entries.size());
+      for (auto& entry: entries) {
+        insert(entry.key, entry.value);
+      }
+    }
+
+  inline HashMap(const HashMap& other):
+    HashMap(other._hash, other._allocator) {
+      reserve(other._sz);
+      for (SizeT i = 0; i < other._capacity; i++) {
+        if (other._ctrl[i] >= 0) {
+          auto& entry = other._slots[i];
+          new (_slots + prepare_insert(hash(entry.key))) Entry(entry);
+        }
+      }
+    }
+
+  inline HashMap(HashMap&& other):
+    _hash(std::move(other._hash)),
+    _allocator(std::move(other._allocator)),
+    _ctrl_allocator(std::move(other._ctrl_allocator)),
+    _ctrl(other._ctrl),
+    _slots(other._slots),
+    _capacity(other._capacity),
+    _sz(other._sz),
+    _growth_left(other._growth_left) {
+      other._ctrl = nullptr;
+      other._slots = nullptr;
+      other._capacity = 0;
+      other._sz = 0;
+      other._growth_left = 0;
+    }
+
+  inline HashMap& operator=(const HashMap& other) {
+    if (this != &other) {
+      HashMap copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  inline HashMap& operator=(HashMap&& other) {
+    if (this != &other) {
+      destroy_all();
+      _hash = std::move(other._hash);
+      _allocator = std::move(other._allocator);
+      _ctrl_allocator = std::move(other._ctrl_allocator);
+      _ctrl = other._ctrl;
+      _slots = other._slots;
+      _capacity = other._capacity;
+      _sz = other._sz;
+      _growth_left = other._growth_left;
+      other._ctrl = nullptr;
+      other._slots = nullptr;
+      other._capacity = 0;
+      other._sz = 0;
+      other._growth_left = 0;
+    }
+    return *this;
+  }
+
+  inline ~HashMap() {
+    destroy_all();
+  }
+
+  /// \brief Get an iterator to the entry of `key`, or end() if the key is
+  /// not in this map.
+  inline ConstIter find(const K& key) const {
+    return make_iter(find_index(key, hash(key)));
+  }
+
+  /// \brief Find the entry of `key`, so that its value can be changed.
+  inline Iter find(const K& key) {
+    return make_iter(find_index(key, hash(key)));
+  }
+
+  inline bool contains(const K& key) const {
+    return find_index(key, hash(key)) != _capacity;
+  }
+
+  /// \brief Add `key` to the map, constructing its value from `args` if the
+  /// key was not present yet.
+  ///
+  /// Returns an iterator to the entry of `key` and whether it was inserted.
+  /// An existing value is left untouched.
+  template<typename ...ForwardArgs>
+  inline std::pair<Iter, bool> emplace(const K& key, ForwardArgs&& ...args) {
+    return emplace_impl(key, std::forward<ForwardArgs>(args)...);
+  }
+
+  template<typename ...ForwardArgs>
+  inline std::pair<Iter, bool> emplace(K&& key, ForwardArgs&& ...args) {
+    return emplace_impl(std::move(key), std::forward<ForwardArgs>(args)...);
+  }
+
+  /// \brief Add `key` with `value` to the map, unless the key was already
+  /// present.
+  inline std::pair<Iter, bool> insert(const K& key, V value) {
+    return emplace_impl(key, std::move(value));
+  }
+
+  inline std::pair<Iter, bool> insert(K&& key, V value) {
+    return emplace_impl(std::move(key), std::move(value));
+  }
+
+  /// \brief Get the value of `key`, inserting a value-initialized one if the
+  /// key is not in this map.
+  ///
+  /// The key is only copied if it has to be inserted.
+  inline V& operator[](const K& key) {
+    return emplace_impl(key).first->value;
+  }
+
+  inline V& operator[](K&& key) {
+    return emplace_impl(std::move(key)).first->value;
+  }
+
+  /// \brief Remove `key` from the map.
+  ///
+  /// Returns `false` if the key was not found.
+  inline bool erase(const K& key) {
+    auto index = find_index(key, hash(key));
+    if (index == _capacity) {
+      return false;
+    }
+    erase(make_iter(index));
+    return true;
+  }
+
+  /// \brief Remove the entry `pos` points to.
+  ///
+  /// Iterators to other entries remain valid.
+  inline void erase(ConstIter pos) {
+    auto index = pos.index;
+    ZEN_ASSERT(index < _capacity && _ctrl[index] >= 0);
+    _slots[index].~Entry();
+    _sz--;
+    // Probes only continue past a group that has no empty slots, so if
+    // this group already has one, no probe sequence can go through this slot.
+    auto offset = index - index % Group::width;
+    if (Group(_ctrl + offset).match_empty() != 0) {
+      _ctrl[index] = _hash_map_empty;
+      _growth_left++;
+    } else {
+      _ctrl[index] = _hash_map_deleted;
+    }
+  }
+
+  /// \brief Make sure that at least `count` entries fit without growing
+  /// the table.
+  inline void reserve(SizeT count) {
+    auto new_capacity = _capacity > 0 ? _capacity : min_capacity;
+    while (max_load(new_capacity) < count) {
+      new_capacity *= 2;
+    }
+    if (new_capacity != _capacity) {
+      rehash(new_capacity);
+    }
+  }
+
+  /// \brief Remove all entries while keeping the table around.
+  inline void clear() {
+    for (SizeT i = 0; i < _capacity; i++) {
+      if (_ctrl[i] >= 0) {
+        _slots[i].~Entry();
+      }
+    }
+    if (_capacity > 0) {
+      memset(_ctrl, _hash_map_empty, _capacity);
+    }
+    _sz = 0;
+    _growth_left = max_load(_capacity);
+  }
+
+  inline bool is_empty() const {
+    return _sz == 0;
+  }
+
+  inline SizeT size() const {
+    return _sz;
+  }
+
+  inline SizeT capacity() const {
+    return _capacity;
+  }
+
+  inline Range range() {
+    return make_iter_range(begin(), end());
+  }
+
+  inline ConstRange range() const {
+    return make_iter_range(begin(), end());
+  }
+
+  inline Iter begin() {
+    return make_iter(0);
+  }
+
+  inline ConstIter begin() const {
+    return make_iter(0);
+  }
+
+  inline Iter end() {
+    return make_iter(_capacity);
+  }
+
+  inline ConstIter end() const {
+    return make_iter(_capacity);
+  }
+
 };
 
 ZEN_NAMESPACE_END
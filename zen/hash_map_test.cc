@@ -0,0 +1,240 @@
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+#include "zen/arena_allocator.hpp"
+#include "zen/hash_map.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(HashMapTest, CanInsertAndFind) {
+  HashMap<std::string, int> m1;
+  ASSERT_TRUE(m1.insert("one", 1).second);
+  ASSERT_TRUE(m1.insert("two", 2).second);
+  ASSERT_FALSE(m1.insert("one", 3).second);
+  ASSERT_EQ(m1.size(), 2);
+  ASSERT_EQ(m1.find("one")->value, 1);
+  ASSERT_EQ(m1.find("two")->value, 2);
+  ASSERT_TRUE(m1.find("three") == m1.end());
+  ASSERT_TRUE(m1.contains("two"));
+  ASSERT_FALSE(m1.contains("three"));
+}
+
+TEST(HashMapTest, GrowsWhenInsertingManyKeys) {
+  HashMap<int, int> m1;
+  for (int i = 0; i < 100000; i++) {
+    m1.insert(i, i * 2);
+  }
+  ASSERT_EQ(m1.size(), 100000);
+  ASSERT_LE(m1.size(), m1.capacity() - m1.capacity() / 8);
+  for (int i = 0; i < 100000; i++) {
+    auto it = m1.find(i);
+    ASSERT_TRUE(it != m1.end());
+    ASSERT_EQ(it->value, i * 2);
+  }
+  ASSERT_FALSE(m1.contains(100000));
+}
+
+TEST(HashMapTest, CanEmplaceAndIndex) {
+  HashMap<int, std::string> m1;
+  auto [it, inserted] = m1.emplace(1, 3, 'a');
+  ASSERT_TRUE(inserted);
+  ASSERT_EQ(it->value, "aaa");
+  m1[2] = "b";
+  m1[1] += "c";
+  ASSERT_EQ(m1[1], "aaac");
+  ASSERT_EQ(m1[2], "b");
+  ASSERT_EQ(m1[3], "");
+  ASSERT_EQ(m1.size(), 3);
+}
+
+namespace {
+
+struct CopyCountingKey {
+
+  static inline int copies = 0;
+
+  int id;
+
+  CopyCountingKey(int id):
+    id(id) {}
+
+  CopyCountingKey(const CopyCountingKey& other):
+    id(other.id) {
+      copies++;
+    }
+
+  CopyCountingKey(CopyCountingKey&& other) = default;
+
+  CopyCountingKey& operator=(const CopyCountingKey& other) = default;
+  CopyCountingKey& operator=(CopyCountingKey&& other) = default;
+
+  bool operator==(const CopyCountingKey& other) const {
+    return id == other.id;
+  }
+
+};
+
+struct CopyCountingKeyHash {
+  size_t operator()(const CopyCountingKey& key) const {
+    return size_t(key.id);
+  }
+};
+
+} // of anonymous namespace
+
+TEST(HashMapTest, OnlyCopiesKeysOnInsert) {
+  HashMap<CopyCountingKey, int, CopyCountingKeyHash> m1;
+  CopyCountingKey k1(1);
+  CopyCountingKey::copies = 0;
+  m1[k1] = 10;
+  ASSERT_EQ(CopyCountingKey::copies, 1);
+  m1[k1] += 1;
+  ASSERT_FALSE(m1.emplace(k1, 12).second);
+  ASSERT_FALSE(m1.insert(k1, 13).second);
+  ASSERT_EQ(CopyCountingKey::copies, 1);
+  m1[CopyCountingKey(2)] = 20;
+  m1.emplace(CopyCountingKey(3), 30);
+  ASSERT_EQ(CopyCountingKey::copies, 1);
+  ASSERT_EQ(m1[k1], 11);
+  ASSERT_EQ(m1.size(), 3);
+}
+
+TEST(HashMapTest, CanEraseKeys) {
+  HashMap<int, std::string> m1;
+  for (int i = 0; i < 1000; i++) {
+    m1.insert(i, std::to_string(i));
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    ASSERT_TRUE(m1.erase(i));
+  }
+  ASSERT_FALSE(m1.erase(0));
+  ASSERT_EQ(m1.size(), 500);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(m1.contains(i), i % 2 == 1);
+  }
+  m1.erase(m1.find(1));
+  ASSERT_FALSE(m1.contains(1));
+  ASSERT_EQ(m1.size(), 499);
+}
+
+TEST(HashMapTest, KeepsCapacityWhenChurning) {
+  HashMap<int, int> m1;
+  m1.reserve(100);
+  auto capacity = m1.capacity();
+  for (int i = 0; i < 100000; i++) {
+    m1.insert(i, i);
+    if (i >= 50) {
+      ASSERT_TRUE(m1.erase(i - 50));
+    }
+  }
+  ASSERT_EQ(m1.size(), 50);
+  ASSERT_EQ(m1.capacity(), capacity);
+  for (int i = 100000 - 50; i < 100000; i++) {
+    ASSERT_TRUE(m1.contains(i));
+  }
+}
+
+TEST(HashMapTest, IteratesOverAllEntries) {
+  HashMap<int, int> m1 { { 1, 10 }, { 2, 20 }, { 3, 30 } };
+  int key_sum = 0;
+  int value_sum = 0;
+  for (auto& [key, value]: m1) {
+    key_sum += key;
+    value_sum += value;
+  }
+  ASSERT_EQ(key_sum, 6);
+  ASSERT_EQ(value_sum, 60);
+}
+
+TEST(HashMapTest, CanFindInConstMap) {
+  HashMap<int, int> m1 { { 1, 10 }, { 2, 20 } };
+  const auto& m2 = m1;
+  static_assert(std::is_same_v<decltype(m2.find(1)), HashMap<int, int>::ConstIter>);
+  static_assert(std::is_same_v<decltype(*m2.begin()), const HashMapEntry<int, int>&>);
+  auto it = m2.find(1);
+  ASSERT_TRUE(it != m2.end());
+  ASSERT_EQ(it->value, 10);
+  ASSERT_TRUE(m2.find(3) == m2.end());
+  ASSERT_TRUE(m1.find(2) != m2.end());
+  HashMap<int, int>::ConstIter it2 = m1.find(2);
+  ASSERT_EQ(it2->value, 20);
+  int value_sum = 0;
+  for (auto& [key, value]: m2) {
+    value_sum += value;
+  }
+  ASSERT_EQ(value_sum, 30);
+  m1.erase(it2);
+  ASSERT_FALSE(m1.contains(2));
+}
+
+TEST(HashMapTest, CanCopyAndMove) {
+  HashMap<std::string, std::string> m1;
+  for (int i = 0; i < 100; i++) {
+    m1.insert(std::to_string(i), std::to_string(i * i));
+  }
+  auto m2 = m1;
+  m1.clear();
+  ASSERT_TRUE(m1.is_empty());
+  ASSERT_EQ(m2.size(), 100);
+  ASSERT_EQ(m2["9"], "81");
+  auto m3 = std::move(m2);
+  ASSERT_EQ(m3.size(), 100);
+  ASSERT_EQ(m2.size(), 0);
+  m1 = m3;
+  ASSERT_EQ(m1["10"], "100");
+}
+
+TEST(HashMapTest, AgreesWithUnorderedMap) {
+  HashMap<uint32_t, uint32_t> m1;
+  std::unordered_map<uint32_t, uint32_t> m2;
+  uint32_t state = 12345;
+  for (int i = 0; i < 200000; i++) {
+    state = state * 1103515245 + 12345;
+    auto key = (state >> 8) % 5000;
+    if (state & 1) {
+      m1[key] = i;
+      m2[key] = i;
+    } else {
+      ASSERT_EQ(m1.erase(key), m2.erase(key) == 1);
+    }
+  }
+  ASSERT_EQ(m1.size(), m2.size());
+  for (auto& [key, value]: m2) {
+    ASSERT_EQ(m1[key], value);
+  }
+}
+
+TEST(HashMapTest, AllocatesFromGivenAllocator) {
+  using Map = HashMap<int, int, Hash<int>, size_t, ArenaAllocator<HashMapEntry<int, int>>>;
+  Arena arena;
+  Hash<int> hash;
+  Map m1(hash, ArenaAllocator<HashMapEntry<int, int>>(arena));
+  for (int i = 0; i < 1000; i++) {
+    m1.insert(i, i * 2);
+  }
+  ASSERT_EQ(m1.size(), 1000);
+  ASSERT_EQ(m1.find(500)->value, 1000);
+  auto m2 = m1;
+  ASSERT_EQ(m2.find(999)->value, 1998);
+}
+
+TEST(HashMapTest, CanEmplaceValueOfItself) {
+  HashMap<int, std::string> m1;
+  m1[0] = "a fairly long string that lives on the heap";
+  for (int i = 1; i < 1000; i++) {
+    m1.emplace(i, m1[i - 1]);
+  }
+  ASSERT_EQ(m1.size(), 1000);
+  ASSERT_EQ(m1[999], m1[0]);
+  Arena arena;
+  HashMap<int, int, Hash<int>, size_t, ArenaAllocator<HashMapEntry<int, int>>> m2 {
+    { { 1, 10 }, { 2, 20 } },
+    Hash<int>(),
+    ArenaAllocator<HashMapEntry<int, int>>(arena)
+  };
+  ASSERT_EQ(m2[2], 20);
+}
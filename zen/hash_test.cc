@@ -0,0 +1,76 @@
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <string_view>
+
+#include "zen/byte.hpp"
+#include "zen/hash.hpp"
+#include "zen/hash_map.hpp"
+#include "zen/string.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+static_assert(hash_literal("while") == Hash<std::string_view>()("while"));
+static_assert(hash_literal("") != hash_literal("a"));
+static_assert(Hash<int>()(1) != Hash<int>()(2));
+
+TEST(HashTest, StringsAndViewsHashTheSame) {
+  std::string s1 = "the quick brown fox jumps over the lazy dog";
+  std::string_view v1 = s1;
+  ASSERT_EQ(Hash<std::string>()(s1), Hash<std::string_view>()(v1));
+  ASSERT_EQ(Hash<std::string>()(s1), hash_bytes(s1.data(), s1.size()));
+  ByteString b1(reinterpret_cast<const Byte*>(s1.data()), s1.size());
+  ASSERT_EQ(Hash<ByteString>()(b1), Hash<std::string>()(s1));
+  String u1 = U"snowman ☃";
+  ASSERT_EQ(Hash<String>()(u1), Hash<string_view>()(u1));
+}
+
+TEST(HashTest, DistinguishesSimilarInputs) {
+  // Cover every code path: short, medium and longer than one 48-byte block
+  for (size_t len = 0; len < 200; len++) {
+    std::string s1(len, 'x');
+    auto h1 = Hash<std::string>()(s1);
+    for (size_t i = 0; i < len; i++) {
+      auto s2 = s1;
+      s2[i] = 'y';
+      ASSERT_NE(Hash<std::string>()(s2), h1);
+    }
+    ASSERT_NE(Hash<std::string>()(s1 + 'x'), h1);
+  }
+}
+
+TEST(HashTest, SpreadsIntegerBits) {
+  // Flipping a single input bit should flip about half of the output bits.
+  size_t total = 0;
+  size_t samples = 0;
+  for (uint64_t value = 0; value < 1000; value++) {
+    for (int bit = 0; bit < 64; bit++) {
+      auto diff = hash_int(value) ^ hash_int(value ^ (uint64_t(1) << bit));
+      total += __builtin_popcountll(diff);
+      samples++;
+    }
+  }
+  auto average = double(total) / samples;
+  ASSERT_GT(average, 30);
+  ASSERT_LT(average, 34);
+}
+
+TEST(HashTest, HashesFloatingPointZeroesTheSame) {
+  ASSERT_EQ(Hash<double>()(0.0), Hash<double>()(-0.0));
+  ASSERT_NE(Hash<double>()(1.0), Hash<double>()(2.0));
+}
+
+TEST(HashTest, OrderMattersWhenCombining) {
+  auto a = hash_int(1);
+  auto b = hash_int(2);
+  ASSERT_NE(hash_combine(a, b), hash_combine(b, a));
+}
+
+TEST(HashTest, WorksAsHashMapDefault) {
+  HashMap<std::string, int> m1;
+  m1.insert("hello", 1);
+  m1.insert("world", 2);
+  ASSERT_EQ(m1["hello"], 1);
+  ASSERT_EQ(m1["world"], 2);
+}
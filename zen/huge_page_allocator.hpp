@@ -0,0 +1,266 @@
+/// \file huge_page_allocator.hpp
+/// \brief Allocators that back large buffers with transparent huge pages.
+///
+/// A buffer of several gigabytes that is mapped with regular 4 KiB pages
+/// needs hundreds of thousands of TLB entries, so random accesses into it
+/// miss the TLB almost every time. Mapping it with 2 MiB pages cuts that by a
+/// factor of 512.
+///
+/// On Linux, DefaultAllocator is a HugePageAwareAllocator, so containers
+/// switch to huge pages on their own once their buffer reaches
+/// `ZEN_HUGE_PAGE_THRESHOLD` bytes. Define `ZEN_HUGE_PAGES` to `0` to keep
+/// using plain `malloc` for everything.
+
+#ifndef ZEN_HUGE_PAGE_ALLOCATOR_HPP
+#define ZEN_HUGE_PAGE_ALLOCATOR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include <mutex>
+#include <type_traits>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+
+#ifndef ZEN_HUGE_PAGE_THRESHOLD
+# define ZEN_HUGE_PAGE_THRESHOLD (4 * 1024 * 1024)
+#endif
+
+ZEN_NAMESPACE_START
+
+inline constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+/// \brief Buffers that are served by HugePageAllocator instead of the
+/// small-object allocator of a HugePageAwareAllocator, in bytes.
+inline constexpr size_t huge_page_threshold = ZEN_HUGE_PAGE_THRESHOLD;
+
+/// Mappings that were freed, kept so that a buffer of the same size can be
+/// handed out again without asking the kernel for a new mapping.
+///
+/// Their pages are released with `MADV_DONTNEED` before they go into the
+/// cache, so a cached mapping only takes address space.
+class _HugePageCache {
+
+  static constexpr size_t capacity = 8;
+
+  struct Entry {
+    void* ptr;
+    size_t size;
+  };
+
+  std::mutex _mutex;
+  Entry _entries[capacity] = {};
+
+public:
+
+  static inline _HugePageCache& instance() {
+    static _HugePageCache cache;
+    return cache;
+  }
+
+  inline void* take(size_t size) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& entry: _entries) {
+      if (entry.ptr != nullptr && entry.size == size) {
+        auto ptr = entry.ptr;
+        entry.ptr = nullptr;
+        return ptr;
+      }
+    }
+    return nullptr;
+  }
+
+  inline bool put(void* ptr, size_t size) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& entry: _entries) {
+      if (entry.ptr == nullptr) {
+        entry = Entry { ptr, size };
+        return true;
+      }
+    }
+    return false;
+  }
+
+};
+
+/// Map `size` bytes at an address that is aligned to huge_page_size, or
+/// return `nullptr`.
+inline void* _huge_page_map(size_t size) {
+  auto raw = mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+  auto start = reinterpret_cast<uintptr_t>(raw);
+  auto aligned = (start + huge_page_size - 1) & ~uintptr_t(huge_page_size - 1);
+  if (aligned > start) {
+    munmap(raw, aligned - start);
+  }
+  auto tail = huge_page_size - (aligned - start);
+  if (tail > 0) {
+    munmap(reinterpret_cast<void*>(aligned + size), tail);
+  }
+  return reinterpret_cast<void*>(aligned);
+}
+
+inline void _huge_page_advise(void* ptr, size_t size, bool populate) {
+#ifdef MADV_HUGEPAGE
+  madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+  if (populate) {
+    // Fault the pages in after the advice, so that they are huge pages from
+    // the start.
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(ptr, size, MADV_POPULATE_WRITE) == 0) {
+      return;
+    }
+#endif
+    auto bytes = static_cast<volatile char*>(ptr);
+    for (size_t i = 0; i < size; i += 4096) {
+      bytes[i] = 0;
+    }
+  }
+}
+
+/// \brief An allocator that maps every buffer on its own, aligned to 2 MiB
+/// and advised to use transparent huge pages.
+///
+/// Sizes are rounded up to whole huge pages, so this allocator is only meant
+/// for large buffers. If `Populate` is set, all pages are faulted in by
+/// allocate(), which moves the cost of page faults out of the code that
+/// first touches the buffer.
+///
+/// Freed buffers give their pages back to the kernel right away with
+/// `MADV_DONTNEED`. A few of them keep their address range, so that a
+/// container that repeatedly allocates buffers of the same size does not
+/// need a new mapping each time.
+template<typename T, bool Populate = false>
+class HugePageAllocator {
+
+  static inline size_t mapping_size(size_t sz) {
+    return (sz * sizeof(T) + huge_page_size - 1) & ~(huge_page_size - 1);
+  }
+
+public:
+
+  inline T* allocate(size_t sz) {
+    if (sz == 0) {
+      return nullptr;
+    }
+    auto size = mapping_size(sz);
+    auto ptr = _HugePageCache::instance().take(size);
+    if (ptr == nullptr) {
+      ptr = _huge_page_map(size);
+      if (ptr == nullptr) {
+        return nullptr;
+      }
+    }
+    _huge_page_advise(ptr, size, Populate);
+    return static_cast<T*>(ptr);
+  }
+
+  inline void free(T* ptr, size_t sz) {
+    if (ptr == nullptr) {
+      return;
+    }
+    auto size = mapping_size(sz);
+    madvise(ptr, size, MADV_DONTNEED);
+    if (!_HugePageCache::instance().put(ptr, size)) {
+      munmap(ptr, size);
+    }
+  }
+
+  inline T* reallocate(T* ptr, size_t old_sz, size_t new_sz) {
+    static_assert(IsTriviallyRelocatable<T>::value, "reallocate() can only move trivially relocatable elements");
+    auto old_size = mapping_size(old_sz);
+    auto new_size = mapping_size(new_sz);
+    if (old_size == new_size) {
+      return ptr;
+    }
+    if (new_size < old_size && new_size > 0) {
+      munmap(reinterpret_cast<char*>(ptr) + new_size, old_size - new_size);
+      return ptr;
+    }
+#if defined(MREMAP_MAYMOVE) && defined(MREMAP_FIXED)
+    // Try to extend the mapping where it is, and otherwise let the kernel
+    // move its pages to a new range that is aligned to a huge page.
+    auto new_ptr = mremap(ptr, old_size, new_size, 0);
+    if (new_ptr == MAP_FAILED) {
+      auto target = _huge_page_map(new_size);
+      if (target == nullptr) {
+        return nullptr;
+      }
+      new_ptr = mremap(ptr, old_size, new_size, MREMAP_MAYMOVE | MREMAP_FIXED, target);
+      if (new_ptr == MAP_FAILED) {
+        munmap(target, new_size);
+        return nullptr;
+      }
+    }
+    _huge_page_advise(static_cast<char*>(new_ptr) + old_size, new_size - old_size, Populate);
+    return static_cast<T*>(new_ptr);
+#else
+    return nullptr;
+#endif
+  }
+
+};
+
+template<typename T, bool Populate, typename U>
+struct RebindAllocator<HugePageAllocator<T, Populate>, U> {
+  using Type = HugePageAllocator<U, Populate>;
+};
+
+/// \brief An allocator that serves buffers of at least huge_page_threshold
+/// bytes from HugePageAllocator and everything else from
+/// `SmallAllocatorT`.
+///
+/// The size that is passed to free() decides which allocator the buffer is
+/// returned to, so it must be the size that the buffer was allocated with.
+/// reallocate() fails when a buffer crosses the threshold, which makes
+/// containers move their elements to a buffer of the other kind.
+template<typename T, template<typename> class SmallAllocatorT>
+class HugePageAwareAllocator {
+
+  SmallAllocatorT<T> _small;
+  HugePageAllocator<T> _large;
+
+  static inline bool is_large(size_t sz) {
+    return sz * sizeof(T) >= huge_page_threshold;
+  }
+
+public:
+
+  inline T* allocate(size_t sz) {
+    return is_large(sz) ? _large.allocate(sz) : _small.allocate(sz);
+  }
+
+  inline void free(T* ptr, size_t sz) {
+    if (is_large(sz)) {
+      _large.free(ptr, sz);
+    } else {
+      _small.free(ptr, sz);
+    }
+  }
+
+  template<
+    typename S = SmallAllocatorT<T>,
+    typename = std::enable_if_t<HasReallocate<S>::value>
+  >
+  inline T* reallocate(T* ptr, size_t old_sz, size_t new_sz) {
+    if (is_large(old_sz) != is_large(new_sz)) {
+      return nullptr;
+    }
+    return is_large(new_sz) ? _large.reallocate(ptr, old_sz, new_sz) : _small.reallocate(ptr, old_sz, new_sz);
+  }
+
+};
+
+template<typename T, template<typename> class SmallAllocatorT, typename U>
+struct RebindAllocator<HugePageAwareAllocator<T, SmallAllocatorT>, U> {
+  using Type = HugePageAwareAllocator<U, SmallAllocatorT>;
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_HUGE_PAGE_ALLOCATOR_HPP
@@ -0,0 +1,65 @@
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+
+#include "zen/huge_page_allocator.hpp"
+#include "zen/vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+static bool is_huge_page_aligned(const void* ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % huge_page_size == 0;
+}
+
+TEST(HugePageAllocatorTest, AlignsMappingsAndReusesThem) {
+  HugePageAllocator<char> allocator;
+  auto ptr = allocator.allocate(13 * 1024 * 1024);
+  ASSERT_NE(ptr, nullptr);
+  ASSERT_TRUE(is_huge_page_aligned(ptr));
+  ptr[0] = 'a';
+  ptr[13 * 1024 * 1024 - 1] = 'b';
+  allocator.free(ptr, 13 * 1024 * 1024);
+  auto other = allocator.allocate(14 * 1024 * 1024);
+  ASSERT_EQ(other, ptr);
+  ASSERT_EQ(other[0], 0);
+  allocator.free(other, 14 * 1024 * 1024);
+}
+
+TEST(HugePageAllocatorTest, KeepsContentsAndAlignmentWhenGrowing) {
+  HugePageAllocator<uint64_t, true> allocator;
+  size_t count = huge_page_size / sizeof(uint64_t);
+  auto ptr = allocator.allocate(count);
+  ASSERT_NE(ptr, nullptr);
+  for (size_t i = 0; i < count; i++) {
+    ptr[i] = i;
+  }
+  ptr = allocator.reallocate(ptr, count, count * 5);
+  ASSERT_NE(ptr, nullptr);
+  ASSERT_TRUE(is_huge_page_aligned(ptr));
+  for (size_t i = 0; i < count; i++) {
+    ASSERT_EQ(ptr[i], i);
+  }
+  ptr[count * 5 - 1] = 1;
+  ptr = allocator.reallocate(ptr, count * 5, count);
+  ASSERT_EQ(ptr[count - 1], count - 1);
+  allocator.free(ptr, count);
+}
+
+TEST(HugePageAllocatorTest, ContainersSwitchToHugePagesAboveTheThreshold) {
+  HugePageAwareAllocator<uint64_t, SystemAllocator> allocator;
+  auto small = allocator.allocate(16);
+  auto large = allocator.allocate(huge_page_threshold / sizeof(uint64_t));
+  ASSERT_TRUE(is_huge_page_aligned(large));
+  ASSERT_EQ(allocator.reallocate(small, 16, huge_page_threshold / sizeof(uint64_t)), nullptr);
+  allocator.free(small, 16);
+  allocator.free(large, huge_page_threshold / sizeof(uint64_t));
+  Vector<uint64_t, size_t, HugePageAwareAllocator<uint64_t, SystemAllocator>> v1;
+  for (uint64_t i = 0; i < 2 * huge_page_threshold / sizeof(uint64_t); i++) {
+    v1.append(i);
+  }
+  ASSERT_TRUE(is_huge_page_aligned(v1.data()));
+  for (uint64_t i = 0; i < v1.size(); i++) {
+    ASSERT_EQ(v1[i], i);
+  }
+}
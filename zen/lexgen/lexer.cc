@@ -2,6 +2,7 @@
 #include <functional>
 
 #include "zen/macros.h"
+#include "zen/perfect_hash.hpp"
 #include "zen/lexgen/lexer.hpp"
 #include "zen/string.hpp"
 
@@ -49,26 +50,28 @@ namespace zen {
     } \
   }
 
-#define ZEN_LEX_KEYWORD(str, name) \
-  { \
-    auto result = try_keyword(str, TokenType::name); \
-    ZEN_TRY(result); \
-    if (result->is_some()) { \
-      return right(**result); \
-    } \
-  }
+    static constexpr auto keywords = make_perfect_hash_map<TokenType>({
+      { "pub", TokenType::pub_keyword },
+    });
 
-    Result<Maybe<Token>> Lexer::try_keyword(String name, TokenType type) {
-      std::size_t i = 0;
-      for (;;) {
-        auto ch = peek_char();
-        ZEN_TRY(ch);
-        if (*ch != name[i]) {
-          return right(Empty());
+    static Maybe<TokenType> lookup_keyword(const String& name) {
+      // Keywords are plain ASCII, so anything else can be rejected before
+      // narrowing the glyphs to bytes.
+      if (name.size() > keywords.max_key_size()) {
+        return {};
+      }
+      char buffer[keywords.max_key_size()];
+      for (std::size_t i = 0; i < name.size(); i++) {
+        if (name[i] > 127) {
+          return {};
         }
-        get_char();
+        buffer[i] = static_cast<char>(name[i]);
+      }
+      auto type = keywords.find(std::string_view(buffer, name.size()));
+      if (type == nullptr) {
+        return {};
       }
-      return right(Token(type));
+      return TokenType(*type);
     }
 
     Result<Glyph> Lexer::lex_escape_sequence() {
@@ -108,14 +111,16 @@ namespace zen {
       ZEN_LEX_CHAR(c0, '(', open_paren)
       ZEN_LEX_CHAR(c0, ')', close_paren)
 
-      ZEN_LEX_KEYWORD(ZEN_STRING_LITERAL("pub"), pub_keyword)
-
       if (is_ident_start(*c0)) {
         String name { *c0 };
         auto result = take_while(name, is_ident_part);
         if (result.is_left()) {
             return left(result.left());
         }
+        auto keyword = lookup_keyword(name);
+        if (keyword.is_some()) {
+          return right(Token(*keyword));
+        }
         return right(Token(TokenType::identifier, some(name)));
       }
 
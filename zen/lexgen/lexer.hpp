@@ -86,8 +86,6 @@ namespace zen {
 
       Result<void> take_while(String& str, std::function<bool(Glyph)> pred);
 
-      Result<Maybe<Token>> try_keyword(String name, TokenType type);
-
       Result<Glyph> lex_escape_sequence();
 
     public:
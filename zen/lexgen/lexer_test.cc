@@ -27,3 +27,15 @@ TEST(LexgenLexerTest, CanLexIdentifiers) {
   ASSERT_EQ(std::get<0>(*t0.get_value()), ZEN_STRING_LITERAL("foo"));
 }
 
+
+TEST(LexgenLexerTest, CanLexKeywords) {
+  std::basic_string<Byte> test_text = ZEN_BYTE_LITERAL("pub public");
+  zen::StreamWrapper<std::basic_string<Byte>> wrapper(test_text);
+  Lexer l(wrapper);
+  auto t0 = l.lex().unwrap();
+  ASSERT_EQ(t0.get_type(), TokenType::pub_keyword);
+  ASSERT_FALSE(t0.has_value());
+  auto t1 = l.lex().unwrap();
+  ASSERT_EQ(t1.get_type(), TokenType::identifier);
+  ASSERT_EQ(std::get<0>(*t1.get_value()), ZEN_STRING_LITERAL("public"));
+}
@@ -86,7 +86,7 @@ namespace zen {
 
     class ChoiceExpr : public Expr {
 
-      using Elements = DLList<SPtr<Expr>>;
+      using Elements = UnrolledDLList<SPtr<Expr>>;
 
       Elements elements;
 
@@ -104,7 +104,7 @@ namespace zen {
 
     class SeqExpr : public Expr {
 
-      using Elements = DLList<SPtr<Expr>>;
+      using Elements = UnrolledDLList<SPtr<Expr>>;
 
       Elements elements;
 
@@ -408,7 +408,7 @@ inline constexpr bool is_meta = IsMeta<T>::value;
  * 
  */
 template<typename T, T...Vs>
-struct Seq;
+struct Seq {};
 
 #if ZEN_FEAT_MAKE_INTEGER_SEQ
 
@@ -419,7 +419,7 @@ struct Ascending : __make_integer_seq<Seq, T, N> {};
 
 template<typename T, size_t N, size_t ...Is>
 struct AscendImpl :
-    IfT<N == 0, Seq<T, Is...>, AscendImpl<T, N-1, N, Is...>> {};
+    IfT<N == 0, Seq<T, Is...>, AscendImpl<T, N-1, N-1, Is...>> {};
 
 template<typename T, size_t N>
 struct Ascending : AscendImpl<T, N> {};
@@ -1167,7 +1167,9 @@ struct AtImpl {
 
 #if ZEN_FEAT_TYPE_PACK_ELEMENT
 template<size_t Ix, typename ...Ts>
-struct TypePackElement : __type_pack_element<Ix, Ts...> {};
+struct TypePackElement {
+  using Type = __type_pack_element<Ix, Ts...>;
+};
 #else
 template<size_t Ix, typename T1, typename ...Ts>
 struct TypePackElement : TypePackElement<Ix - 1, Ts...> {};
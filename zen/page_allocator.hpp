@@ -0,0 +1,79 @@
+/// \file page_allocator.hpp
+/// \brief An allocator that maps large buffers directly from the kernel.
+
+#ifndef ZEN_PAGE_ALLOCATOR_HPP
+#define ZEN_PAGE_ALLOCATOR_HPP
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+
+ZEN_NAMESPACE_START
+
+/// \brief An allocator that gives every buffer its own memory mapping.
+///
+/// Allocations are rounded up to whole pages, so this allocator is only
+/// worth it for large buffers. In return, reallocate() lets the kernel move
+/// the pages of a buffer with `mremap` instead of copying them, so that
+/// growing a buffer of several gigabytes takes about as long as growing a
+/// small one.
+///
+/// ```
+/// Vector<uint64_t, size_t, PageAllocator<uint64_t>> samples;
+/// ```
+///
+/// On systems without `mremap`, buffers can only be shrunk in place and
+/// containers fall back to copying when they grow.
+template<typename T>
+class PageAllocator {
+
+  static inline size_t page_size() {
+    static const size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+  }
+
+  static inline size_t mapping_size(size_t sz) {
+    auto mask = page_size() - 1;
+    return (sz * sizeof(T) + mask) & ~mask;
+  }
+
+public:
+
+  inline T* allocate(size_t sz) {
+    if (sz == 0) {
+      return nullptr;
+    }
+    auto ptr = mmap(nullptr, mapping_size(sz), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : static_cast<T*>(ptr);
+  }
+
+  inline void free(T* ptr, size_t sz) {
+    munmap(ptr, mapping_size(sz));
+  }
+
+  inline T* reallocate(T* ptr, size_t old_sz, size_t new_sz) {
+    static_assert(IsTriviallyRelocatable<T>::value, "reallocate() can only move trivially relocatable elements");
+    auto old_size = mapping_size(old_sz);
+    auto new_size = mapping_size(new_sz);
+    if (old_size == new_size) {
+      return ptr;
+    }
+#ifdef MREMAP_MAYMOVE
+    auto new_ptr = mremap(ptr, old_size, new_size, MREMAP_MAYMOVE);
+    return new_ptr == MAP_FAILED ? nullptr : static_cast<T*>(new_ptr);
+#else
+    if (new_size < old_size && new_size > 0) {
+      munmap(reinterpret_cast<char*>(ptr) + new_size, old_size - new_size);
+      return ptr;
+    }
+    return nullptr;
+#endif
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_PAGE_ALLOCATOR_HPP
@@ -0,0 +1,72 @@
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+
+#include "zen/deque.hpp"
+#include "zen/page_allocator.hpp"
+#include "zen/small_vector.hpp"
+#include "zen/vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(PageAllocatorTest, KeepsElementsWhenGrowing) {
+  Vector<uint64_t, size_t, PageAllocator<uint64_t>> v1;
+  for (uint64_t i = 0; i < 1000000; i++) {
+    v1.append(i * 3);
+  }
+  ASSERT_EQ(v1.size(), 1000000);
+  for (uint64_t i = 0; i < 1000000; i++) {
+    ASSERT_EQ(v1[i], i * 3);
+  }
+}
+
+TEST(PageAllocatorTest, CanShrinkAndGrowInPlace) {
+  PageAllocator<char> allocator;
+  auto ptr = allocator.allocate(10000);
+  ASSERT_NE(ptr, nullptr);
+  ptr[9999] = 'a';
+  ptr[0] = 'b';
+  ptr = allocator.reallocate(ptr, 10000, 100);
+  ASSERT_NE(ptr, nullptr);
+  ASSERT_EQ(ptr[0], 'b');
+  ptr = allocator.reallocate(ptr, 100, 1000000);
+  ASSERT_NE(ptr, nullptr);
+  ASSERT_EQ(ptr[0], 'b');
+  ptr[999999] = 'c';
+  allocator.free(ptr, 1000000);
+}
+
+TEST(PageAllocatorTest, KeepsDequeOrderAcrossWrapAround) {
+  Deque<int, size_t, PageAllocator<int>> d1;
+  for (int i = 0; i < 6; i++) {
+    d1.append(i);
+  }
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(d1.pop_first(), i);
+    d1.append(i + 6);
+  }
+  for (int i = 1; i <= 2000; i++) {
+    d1.prepend(-i);
+  }
+  ASSERT_EQ(d1.size(), 2006);
+  int k = -2000;
+  for (auto element: d1) {
+    if (k == 0) {
+      k = 5;
+    }
+    ASSERT_EQ(element, k++);
+  }
+}
+
+TEST(PageAllocatorTest, CanPrependToSmallVector) {
+  SmallVector<int, 2, size_t, PageAllocator<int>> v1 { 1, 2 };
+  for (int i = 3; i <= 5000; i++) {
+    v1.append(i);
+  }
+  v1.prepend(0);
+  ASSERT_EQ(v1.size(), 5001);
+  for (int i = 0; i <= 5000; i++) {
+    ASSERT_EQ(v1[i], i);
+  }
+}
@@ -0,0 +1,169 @@
+/// \file parallel.hpp
+/// \brief Parallel versions of the generic algorithms on ranges.
+///
+/// All algorithms in this file accept any type that satisfies `IsRange`.
+/// Containers are taken by reference, so they are not copied. When
+/// the iterators of the range can be offset and subtracted in constant time
+/// (as is the case for Vector, Deque and `IterRange<T*>`), the work is split
+/// into chunks that run on the default ThreadPool. Otherwise, the algorithms
+/// fall back to a serial loop.
+///
+/// Functions passed to these algorithms may be invoked concurrently from
+/// several threads.
+
+#ifndef ZEN_PARALLEL_HPP
+#define ZEN_PARALLEL_HPP
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "zen/config.h"
+#include "zen/range.hpp"
+#include "zen/thread_pool.hpp"
+#include "zen/vector.hpp"
+
+ZEN_NAMESPACE_START
+
+/// Ranges smaller than this are not worth splitting over several threads.
+inline constexpr size_t parallel_grain = 4096;
+
+template<typename RangeT, typename Fn>
+inline void parallel_for_each(RangeT&& range, Fn fn) {
+  if constexpr (HasIterDiff<RangeT>::value) {
+    auto first = range.begin();
+    parallel_chunks(range_size(range), parallel_grain, [&](size_t begin, size_t end) {
+      auto it = first + begin;
+      for (auto i = begin; i < end; i++) {
+        fn(*it);
+        ++it;
+      }
+    });
+  } else {
+    for (auto&& element: range) {
+      fn(element);
+    }
+  }
+}
+
+/// \brief Write `fn(element)` to `out` for every element in `range`.
+///
+/// Returns an iterator just past the last element that was written. `out`
+/// must be randomly accessible for the work to be split.
+template<typename RangeT, typename Fn, typename OutIter>
+inline OutIter parallel_transform(RangeT&& range, Fn fn, OutIter out) {
+  if constexpr (HasIterDiff<RangeT>::value) {
+    auto first = range.begin();
+    auto count = range_size(range);
+    parallel_chunks(count, parallel_grain, [&](size_t begin, size_t end) {
+      auto it = first + begin;
+      auto it_out = out + begin;
+      for (auto i = begin; i < end; i++) {
+        *it_out = fn(*it);
+        ++it;
+        ++it_out;
+      }
+    });
+    return out + count;
+  } else {
+    return transform(range, fn, out);
+  }
+}
+
+template<typename RangeT, typename OutIter>
+inline OutIter parallel_copy(RangeT&& range, OutIter out) {
+  return parallel_transform(std::forward<RangeT>(range), [](auto& element) -> decltype(auto) { return element; }, out);
+}
+
+template<typename RangeT, typename OutIter>
+inline OutIter parallel_move_n(RangeT&& range, OutIter out) {
+  return parallel_transform(std::forward<RangeT>(range), [](auto& element) { return std::move(element); }, out);
+}
+
+/// \brief Combine all elements in `range` with `op`, starting from `init`.
+///
+/// `op` must be associative, because the elements are combined in chunks
+/// whose results are only merged at the end. It does not have to be
+/// commutative: partial results are merged in their original order.
+template<typename RangeT, typename T, typename Op = std::plus<>>
+inline T parallel_reduce(RangeT&& range, T init, Op op = Op()) {
+  if constexpr (HasIterDiff<RangeT>::value) {
+    auto first = range.begin();
+    auto count = range_size(range);
+    auto chunk_count = default_thread_pool().size() * 4;
+    auto chunk = (count + chunk_count - 1) / chunk_count;
+    if (chunk < parallel_grain) {
+      chunk = parallel_grain;
+    }
+    chunk_count = (count + chunk - 1) / chunk;
+    Vector<T> partials;
+    partials.resize(chunk_count, init);
+    parallel_chunks(chunk_count, 1, [&](size_t begin, size_t end) {
+      for (auto k = begin; k < end; k++) {
+        auto it = first + k * chunk;
+        auto stop = (k + 1) * chunk < count ? (k + 1) * chunk : count;
+        T result = *it;
+        ++it;
+        for (auto i = k * chunk + 1; i < stop; i++) {
+          result = op(std::move(result), *it);
+          ++it;
+        }
+        partials[k] = std::move(result);
+      }
+    });
+    for (auto& partial: partials) {
+      init = op(std::move(init), partial);
+    }
+    return init;
+  } else {
+    for (auto&& element: range) {
+      init = op(std::move(init), element);
+    }
+    return init;
+  }
+}
+
+/// \brief Sort the elements in `range` according to `compare`.
+///
+/// The range is cut into one chunk per worker. The chunks are sorted
+/// concurrently and then merged pairwise, again in parallel, until a single
+/// sorted run remains. The sort is not stable.
+template<typename RangeT, typename CompareT = std::less<>>
+inline void parallel_sort(RangeT&& range, CompareT compare = CompareT()) {
+  static_assert(HasIterDiff<RangeT>::value, "parallel_sort() requires random-access iterators");
+  auto first = range.begin();
+  auto count = range_size(range);
+  auto& pool = default_thread_pool();
+  size_t run_count = pool.size();
+  if (count / parallel_grain < run_count) {
+    run_count = count / parallel_grain;
+  }
+  if (run_count <= 1) {
+    std::sort(first, first + count, compare);
+    return;
+  }
+  auto run = (count + run_count - 1) / run_count;
+  parallel_chunks(run_count, 1, [&](size_t begin, size_t end) {
+    for (auto k = begin; k < end; k++) {
+      auto stop = (k + 1) * run < count ? (k + 1) * run : count;
+      std::sort(first + k * run, first + stop, compare);
+    }
+  });
+  for (; run < count; run *= 2) {
+    auto merge_count = (count + 2 * run - 1) / (2 * run);
+    parallel_chunks(merge_count, 1, [&](size_t begin, size_t end) {
+      for (auto k = begin; k < end; k++) {
+        auto left = k * 2 * run;
+        if (left + run >= count) {
+          continue;
+        }
+        auto right = left + 2 * run < count ? left + 2 * run : count;
+        std::inplace_merge(first + left, first + left + run, first + right, compare);
+      }
+    });
+  }
+}
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_PARALLEL_HPP
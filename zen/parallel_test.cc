@@ -0,0 +1,96 @@
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+#include "zen/deque.hpp"
+#include "zen/dllist.hpp"
+#include "zen/parallel.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(ParallelTest, TransformsAllElements) {
+  Vector<int> input;
+  input.resize(100000);
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = i;
+  }
+  Vector<long> output;
+  output.resize(input.size());
+  auto end = parallel_transform(input, [](int i) { return long(i) * 2; }, output.begin());
+  ASSERT_EQ(end, output.end());
+  for (size_t i = 0; i < output.size(); i++) {
+    ASSERT_EQ(output[i], long(i) * 2);
+  }
+  Vector<int> copy;
+  copy.resize(input.size());
+  parallel_copy(input, copy.begin());
+  ASSERT_EQ(copy[99999], 99999);
+}
+
+TEST(ParallelTest, ReducesInOrder) {
+  Vector<long> input;
+  for (long i = 1; i <= 100000; i++) {
+    input.append(i);
+  }
+  ASSERT_EQ(parallel_reduce(input, 0L), 5000050000L);
+  std::atomic<long> sum { 0 };
+  parallel_for_each(input, [&](long i) { sum += i; });
+  ASSERT_EQ(sum, 5000050000L);
+}
+
+TEST(ParallelTest, FallsBackToSerialForLists) {
+  DLList<int> input;
+  input.append(1);
+  input.append(2);
+  input.append(3);
+  int output[3] = { 0, 0, 0 };
+  parallel_transform(input, [](int i) { return i + 1; }, output);
+  ASSERT_EQ(output[0], 2);
+  ASSERT_EQ(output[1], 3);
+  ASSERT_EQ(output[2], 4);
+}
+
+TEST(ParallelTest, SortsLargeRanges) {
+  Vector<unsigned> input;
+  unsigned state = 12345;
+  for (int i = 0; i < 200000; i++) {
+    state = state * 1103515245 + 12345;
+    input.append(state >> 8);
+  }
+  parallel_sort(input);
+  for (size_t i = 1; i < input.size(); i++) {
+    ASSERT_LE(input[i-1], input[i]);
+  }
+  parallel_sort(input, [](unsigned a, unsigned b) { return a > b; });
+  ASSERT_GE(input[0], input[input.size()-1]);
+}
+
+TEST(ParallelTest, SortsDeques) {
+  Deque<unsigned> input;
+  unsigned state = 7;
+  for (int i = 0; i < 100000; i++) {
+    state = state * 1103515245 + 12345;
+    input.append(state >> 8);
+  }
+  parallel_sort(input);
+  for (size_t i = 1; i < input.size(); i++) {
+    ASSERT_LE(input[i-1], input[i]);
+  }
+}
+
+TEST(ParallelTest, TaskGroupsCanNest) {
+  std::atomic<int> count { 0 };
+  TaskGroup outer;
+  for (int i = 0; i < 8; i++) {
+    outer.run([&] {
+      TaskGroup inner;
+      for (int j = 0; j < 8; j++) {
+        inner.run([&] { count++; });
+      }
+      inner.wait();
+    });
+  }
+  outer.wait();
+  ASSERT_EQ(count, 64);
+}
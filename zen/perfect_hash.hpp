@@ -0,0 +1,260 @@
+/// \file perfect_hash.hpp
+/// \brief Lookup tables for fixed sets of string keys that are built at
+/// compile time.
+///
+/// A perfect hash function maps each key of a fixed set to its own slot, so a
+/// lookup hashes the input once and compares it to exactly one key. The
+/// tables in this file are built by the compiler, so the program does no
+/// work at startup:
+///
+/// ```
+/// enum class Keyword { if_, else_, while_ };
+///
+/// constexpr auto keywords = make_perfect_hash_map<Keyword>({
+///   { "if", Keyword::if_ },
+///   { "else", Keyword::else_ },
+///   { "while", Keyword::while_ },
+/// });
+///
+/// static_assert(*keywords.find("while") == Keyword::while_);
+/// ```
+///
+/// The builder follows [PTHash](https://arxiv.org/abs/2104.10402). Keys are
+/// first distributed over a small number of buckets. Then, starting with the
+/// largest bucket, it searches for a *pilot* value per bucket that moves all
+/// keys of that bucket into slots that are still free. A lookup only needs
+/// the pilot of its bucket to compute the slot of the key:
+///
+/// ```
+/// slot = (hash ^ hash_int(pilots[bucket(hash)])) % N
+/// ```
+///
+/// The table has exactly one slot per key, so it is a *minimal* perfect hash.
+
+#ifndef ZEN_PERFECT_HASH_HPP
+#define ZEN_PERFECT_HASH_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string_view>
+
+#include "zen/config.h"
+#include "zen/hash.hpp"
+#include "zen/macros.h"
+
+ZEN_NAMESPACE_START
+
+template<typename V, size_t N>
+class PerfectHashMap;
+
+template<typename V>
+struct PerfectHashEntry {
+  std::string_view key;
+  V value;
+};
+
+/// \brief A read-only map from a fixed set of string keys to values.
+///
+/// Use make_perfect_hash_map() to create one. `V` must be default
+/// constructible and copy assignable in constant expressions.
+template<typename V, size_t N>
+class PerfectHashMap {
+
+  static_assert(N > 0, "a perfect hash table needs at least one key");
+
+  template<typename V2, size_t N2>
+  friend constexpr bool _perfect_hash_try_build(PerfectHashMap<V2, N2>& map, const PerfectHashEntry<V2> (&entries)[N2]);
+
+  template<typename V2, size_t N2>
+  friend constexpr PerfectHashMap<V2, N2> make_perfect_hash_map(const PerfectHashEntry<V2> (&entries)[N2]);
+
+public:
+
+  using Key = std::string_view;
+  using Value = V;
+  using Size = size_t;
+
+  /// The amount of buckets that keys are spread over before searching for
+  /// their pilots. About 2 keys per bucket keeps the compile-time search
+  /// short while the table of pilots stays small.
+  static constexpr size_t bucket_count = N / 2 + 1;
+
+private:
+
+  uint64_t _seed = 0;
+  uint32_t _pilots[bucket_count] = {};
+  std::string_view _keys[N] = {};
+  V _values[N] = {};
+  size_t _max_key_size = 0;
+
+public:
+
+  static constexpr size_t bucket_of(uint64_t hash) {
+    // The high bits pick the bucket so that they are independent of the
+    // low bits that pick the slot.
+    return (hash >> 32) % bucket_count;
+  }
+
+  static constexpr size_t slot_of(uint64_t hash, uint32_t pilot) {
+    return (hash ^ hash_int(pilot)) % N;
+  }
+
+  /// \brief Get the index of the slot that `key` would be stored in, or N
+  /// if `key` is not one of the keys of this table.
+  constexpr size_t index_of(std::string_view key) const {
+    if (key.size() > _max_key_size) {
+      return N;
+    }
+    auto hash = hash_bytes(key.data(), key.size(), _seed);
+    auto slot = slot_of(hash, _pilots[bucket_of(hash)]);
+    return _keys[slot] == key ? slot : N;
+  }
+
+  /// \brief Get a pointer to the value of `key`, or `nullptr` if `key` is
+  /// not in this table.
+  constexpr const V* find(std::string_view key) const {
+    auto slot = index_of(key);
+    return slot == N ? nullptr : &_values[slot];
+  }
+
+  constexpr bool contains(std::string_view key) const {
+    return index_of(key) != N;
+  }
+
+  /// \brief Get the key that is stored at `index`.
+  constexpr std::string_view key_at(size_t index) const {
+    return _keys[index];
+  }
+
+  constexpr const V& value_at(size_t index) const {
+    return _values[index];
+  }
+
+  /// \brief Get the length of the longest key.
+  ///
+  /// Strings that are longer than this are rejected without hashing them.
+  constexpr size_t max_key_size() const {
+    return _max_key_size;
+  }
+
+  static constexpr size_t size() {
+    return N;
+  }
+
+};
+
+/// Try to find pilots for all buckets of `map` using the current seed.
+///
+/// Returns `false` if some bucket could not be placed, in which case the
+/// caller should try another seed.
+template<typename V, size_t N>
+constexpr bool _perfect_hash_try_build(PerfectHashMap<V, N>& map, const PerfectHashEntry<V> (&entries)[N]) {
+  using MapT = PerfectHashMap<V, N>;
+  constexpr size_t bucket_count = MapT::bucket_count;
+  constexpr uint32_t max_pilot = 1 << 16;
+
+  uint64_t hashes[N] = {};
+  size_t bucket_sizes[bucket_count] = {};
+  for (size_t i = 0; i < N; i++) {
+    hashes[i] = hash_bytes(entries[i].key.data(), entries[i].key.size(), map._seed);
+    bucket_sizes[MapT::bucket_of(hashes[i])]++;
+  }
+
+  // Place the largest buckets first, while most slots are still free.
+  size_t order[bucket_count] = {};
+  for (size_t i = 0; i < bucket_count; i++) {
+    auto k = i;
+    for (; k > 0 && bucket_sizes[order[k - 1]] < bucket_sizes[i]; k--) {
+      order[k] = order[k - 1];
+    }
+    order[k] = i;
+  }
+
+  bool taken[N] = {};
+  size_t members[N] = {};
+  size_t slots[N] = {};
+  for (auto bucket: order) {
+    if (bucket_sizes[bucket] == 0) {
+      break;
+    }
+    size_t member_count = 0;
+    for (size_t i = 0; i < N; i++) {
+      if (MapT::bucket_of(hashes[i]) == bucket) {
+        members[member_count++] = i;
+      }
+    }
+    uint32_t pilot = 0;
+    for (; pilot < max_pilot; pilot++) {
+      bool fits = true;
+      for (size_t j = 0; j < member_count && fits; j++) {
+        slots[j] = MapT::slot_of(hashes[members[j]], pilot);
+        fits = !taken[slots[j]];
+        for (size_t l = 0; l < j && fits; l++) {
+          fits = slots[l] != slots[j];
+        }
+      }
+      if (fits) {
+        break;
+      }
+    }
+    if (pilot == max_pilot) {
+      return false;
+    }
+    map._pilots[bucket] = pilot;
+    for (size_t j = 0; j < member_count; j++) {
+      taken[slots[j]] = true;
+      map._keys[slots[j]] = entries[members[j]].key;
+      map._values[slots[j]] = entries[members[j]].value;
+    }
+  }
+  return true;
+}
+
+/// \brief Build a PerfectHashMap from a list of unique keys and their
+/// values.
+///
+/// This function is meant to be evaluated at compile time by assigning its
+/// result to a `constexpr` variable. The keys must be distinct.
+template<typename V, size_t N>
+constexpr PerfectHashMap<V, N> make_perfect_hash_map(const PerfectHashEntry<V> (&entries)[N]) {
+  PerfectHashMap<V, N> map;
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = 0; j < i; j++) {
+      ZEN_ASSERT(entries[i].key != entries[j].key);
+    }
+    if (entries[i].key.size() > map._max_key_size) {
+      map._max_key_size = entries[i].key.size();
+    }
+  }
+  for (uint64_t seed = 0;; seed++) {
+    map._seed = seed;
+    if (_perfect_hash_try_build(map, entries)) {
+      return map;
+    }
+  }
+}
+
+/// \brief A read-only set of string keys that maps each key to its position
+/// in the list the set was built from.
+template<size_t N>
+using PerfectHashSet = PerfectHashMap<size_t, N>;
+
+/// \brief Build a PerfectHashSet from a list of unique keys.
+///
+/// ```
+/// constexpr auto fields = make_perfect_hash_set({ "x", "y", "z" });
+/// static_assert(*fields.find("y") == 1);
+/// ```
+template<size_t N>
+constexpr PerfectHashSet<N> make_perfect_hash_set(const std::string_view (&keys)[N]) {
+  PerfectHashEntry<size_t> entries[N] = {};
+  for (size_t i = 0; i < N; i++) {
+    entries[i] = { keys[i], i };
+  }
+  return make_perfect_hash_map(entries);
+}
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_PERFECT_HASH_HPP
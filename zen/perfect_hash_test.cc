@@ -0,0 +1,63 @@
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "zen/perfect_hash.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+enum class Keyword {
+  if_keyword,
+  else_keyword,
+  while_keyword,
+  return_keyword,
+};
+
+constexpr auto keywords = make_perfect_hash_map<Keyword>({
+  { "if", Keyword::if_keyword },
+  { "else", Keyword::else_keyword },
+  { "while", Keyword::while_keyword },
+  { "return", Keyword::return_keyword },
+});
+
+static_assert(*keywords.find("while") == Keyword::while_keyword);
+static_assert(keywords.find("for") == nullptr);
+static_assert(keywords.max_key_size() == 6);
+
+TEST(PerfectHashTest, FindsAllKeysOfMap) {
+  ASSERT_EQ(keywords.size(), 4);
+  ASSERT_EQ(*keywords.find("if"), Keyword::if_keyword);
+  ASSERT_EQ(*keywords.find("else"), Keyword::else_keyword);
+  ASSERT_EQ(*keywords.find("while"), Keyword::while_keyword);
+  ASSERT_EQ(*keywords.find("return"), Keyword::return_keyword);
+  ASSERT_EQ(keywords.find(""), nullptr);
+  ASSERT_EQ(keywords.find("whilst"), nullptr);
+  ASSERT_EQ(keywords.find("returns"), nullptr);
+  ASSERT_FALSE(keywords.contains("i"));
+  std::string runtime_key = "els";
+  runtime_key += 'e';
+  ASSERT_TRUE(keywords.contains(runtime_key));
+}
+
+TEST(PerfectHashTest, SetMapsKeysToTheirPosition) {
+  constexpr auto fields = make_perfect_hash_set({
+    "alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta",
+    "iota", "kappa", "lambda", "mu", "nu", "xi", "omicron", "pi", "rho",
+    "sigma", "tau", "upsilon", "phi", "chi", "psi", "omega",
+  });
+  static_assert(*fields.find("alpha") == 0);
+  static_assert(*fields.find("omega") == 23);
+  ASSERT_EQ(fields.size(), 24);
+  for (size_t i = 0; i < fields.size(); i++) {
+    auto key = fields.key_at(i);
+    ASSERT_EQ(fields.index_of(key), i);
+  }
+  ASSERT_FALSE(fields.contains("digamma"));
+}
+
+TEST(PerfectHashTest, SupportsSingleKey) {
+  constexpr auto single = make_perfect_hash_set({ "pub" });
+  ASSERT_TRUE(single.contains("pub"));
+  ASSERT_FALSE(single.contains("pug"));
+}
@@ -0,0 +1,478 @@
+/// \file persistent_vector.hpp
+/// \brief An immutable vector whose versions share most of their memory.
+
+#ifndef ZEN_PERSISTENT_VECTOR_HPP
+#define ZEN_PERSISTENT_VECTOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+#include "zen/macros.h"
+#include "zen/range.hpp"
+
+ZEN_NAMESPACE_START
+
+template<
+  typename T,
+  typename AllocatorT = DefaultAllocator<T>
+>
+class PersistentVector;
+
+template<typename T, typename AllocatorT>
+class PersistentVectorIter {
+
+  using Container = PersistentVector<T, AllocatorT>;
+
+  const Container* vector;
+  size_t index;
+  const T* leaf;
+
+  inline const T* leaf_at(size_t index) const {
+    return index < vector->size() ? vector->leaf_for(index) : nullptr;
+  }
+
+public:
+
+  using Value = T;
+  using Size = size_t;
+  using Diff = ptrdiff_t;
+
+  using value_type = Value;
+
+  inline PersistentVectorIter(const Container* vector, size_t index):
+    vector(vector), index(index), leaf(leaf_at(index)) {}
+
+  bool operator==(const PersistentVectorIter& other) const {
+    return other.vector == vector && other.index == index;
+  }
+
+  bool operator!=(const PersistentVectorIter& other) const {
+    return !(*this == other);
+  }
+
+  const T& operator*() const {
+    return leaf[index & Container::mask];
+  }
+
+  const T* operator->() const {
+    return &leaf[index & Container::mask];
+  }
+
+  PersistentVectorIter& operator++() {
+    index++;
+    if ((index & Container::mask) == 0) {
+      leaf = leaf_at(index);
+    }
+    return *this;
+  }
+
+  PersistentVectorIter operator+(Diff offset) const {
+    return PersistentVectorIter(vector, index + offset);
+  }
+
+  Diff operator-(const PersistentVectorIter& other) const {
+    return Diff(index) - Diff(other.index);
+  }
+
+};
+
+/// \brief An immutable sequence that is cheap to copy and to derive new
+/// versions from.
+///
+/// The elements are stored in the leaves of a tree where every node has up to
+/// 32 children, so that reading, updating and appending an element takes
+/// O(log32 n) steps, which is at most 7 for any vector that fits in memory.
+/// The last leaf is kept outside of the tree, which makes most appends run in
+/// constant time.
+///
+/// append() and set() never touch the vector they are called on. Instead, they
+/// return a new version that only copies the nodes on the path to the changed
+/// element and shares all other nodes with the original. Copying a vector
+/// merely increments two reference counts, which makes it a good fit for
+/// taking snapshots of a large array. Nodes are reference-counted atomically,
+/// so different versions may be read and dropped from different threads.
+///
+/// ```
+/// PersistentVector<int> v1 { 1, 2, 3 };
+/// auto v2 = v1.set(0, 42);
+/// // v1[0] is still 1
+/// ```
+///
+/// Calling append() on a temporary reuses the last leaf when no other
+/// version refers to it, so building a vector from scratch does not copy
+/// each element several times:
+///
+/// ```
+/// PersistentVector<int> v3;
+/// for (int i = 0; i < 1000; i++) {
+///   v3 = std::move(v3).append(i);
+/// }
+/// ```
+///
+/// Nodes are allocated with `AllocatorT` rebound to the node type.
+template<
+  typename T,
+  typename AllocatorT
+>
+class PersistentVector {
+
+  friend class PersistentVectorIter<T, AllocatorT>;
+
+public:
+
+  using Value = T;
+  using Size = size_t;
+  using Iter = PersistentVectorIter<T, AllocatorT>;
+  using Range = IterRange<Iter>;
+
+  using value_type = T;
+  using size_type = size_t;
+
+  /// The amount of index bits that are resolved by one level of the tree.
+  static constexpr size_t bits = 5;
+
+  /// The maximum amount of children of a single node.
+  static constexpr size_t branching = size_t(1) << bits;
+
+private:
+
+  static constexpr size_t mask = branching - 1;
+
+  struct Node {
+    std::atomic<uint32_t> refcount { 1 };
+  };
+
+  struct Leaf : Node {
+    size_t count = 0;
+    alignas(T) unsigned char storage[branching * sizeof(T)];
+    inline T* values() {
+      return reinterpret_cast<T*>(storage);
+    }
+  };
+
+  struct Inner : Node {
+    Node* children[branching] = {};
+  };
+
+  using LeafAllocator = RebindAllocatorT<AllocatorT, Leaf>;
+  using InnerAllocator = RebindAllocatorT<AllocatorT, Inner>;
+
+  LeafAllocator _leaf_allocator;
+  InnerAllocator _inner_allocator;
+  Inner* _root;
+  Leaf* _tail;
+  size_t _shift;
+  size_t _sz;
+
+  static inline void retain(Node* node) {
+    if (node != nullptr) {
+      node->refcount.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  static inline bool is_unique(Node* node) {
+    return node->refcount.load(std::memory_order_acquire) == 1;
+  }
+
+  inline void release_leaf(Leaf* leaf) {
+    if (leaf == nullptr || leaf->refcount.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+    for (size_t i = 0; i < leaf->count; i++) {
+      leaf->values()[i].~T();
+    }
+    leaf->~Leaf();
+    _leaf_allocator.free(leaf, 1);
+  }
+
+  /// Drop a reference to `node`, which is a leaf when `level` is zero.
+  inline void release(Node* node, size_t level) {
+    if (level == 0) {
+      release_leaf(static_cast<Leaf*>(node));
+      return;
+    }
+    if (node == nullptr || node->refcount.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+    auto inner = static_cast<Inner*>(node);
+    for (auto child: inner->children) {
+      release(child, level - bits);
+    }
+    inner->~Inner();
+    _inner_allocator.free(inner, 1);
+  }
+
+  inline Leaf* make_leaf() {
+    auto ptr = _leaf_allocator.allocate(1);
+    ZEN_ASSERT(ptr != nullptr);
+    return new (ptr) Leaf;
+  }
+
+  inline Inner* make_inner() {
+    auto ptr = _inner_allocator.allocate(1);
+    ZEN_ASSERT(ptr != nullptr);
+    return new (ptr) Inner;
+  }
+
+  inline Leaf* copy_leaf(Leaf* leaf) {
+    auto result = make_leaf();
+    for (size_t i = 0; i < leaf->count; i++) {
+      new (result->values() + i) T(leaf->values()[i]);
+    }
+    result->count = leaf->count;
+    return result;
+  }
+
+  inline Inner* copy_inner(Inner* inner) {
+    auto result = make_inner();
+    for (size_t i = 0; i < branching; i++) {
+      result->children[i] = inner->children[i];
+      retain(inner->children[i]);
+    }
+    return result;
+  }
+
+  /// The index of the first element that is stored in `_tail`.
+  inline size_t tail_offset() const {
+    return _sz < branching ? 0 : ((_sz - 1) >> bits) << bits;
+  }
+
+  inline const T* leaf_for(size_t index) const {
+    if (index >= tail_offset()) {
+      return _tail->values();
+    }
+    Node* node = _root;
+    for (size_t level = _shift; level > 0; level -= bits) {
+      node = static_cast<Inner*>(node)->children[(index >> level) & mask];
+    }
+    return static_cast<Leaf*>(node)->values();
+  }
+
+  /// Build a chain of single-child nodes from `level` down to `leaf`.
+  inline Node* new_path(size_t level, Leaf* leaf) {
+    if (level == 0) {
+      return leaf;
+    }
+    auto inner = make_inner();
+    inner->children[0] = new_path(level - bits, leaf);
+    return inner;
+  }
+
+  /// Return a copy of `parent` that has the full `_tail` as its last leaf.
+  /// The reference to `_tail` is taken over.
+  inline Inner* push_tail(size_t level, Inner* parent, Leaf* tail) {
+    auto result = parent != nullptr ? copy_inner(parent) : make_inner();
+    auto index = ((_sz - 1) >> level) & mask;
+    auto existing = result->children[index];
+    if (level == bits) {
+      result->children[index] = tail;
+    } else if (existing != nullptr) {
+      result->children[index] = push_tail(level - bits, static_cast<Inner*>(existing), tail);
+      release(existing, level - bits);
+    } else {
+      result->children[index] = new_path(level - bits, tail);
+    }
+    return result;
+  }
+
+  /// Return a copy of `node` in which the element at `index` is replaced.
+  template<typename ValueT>
+  inline Node* set_path(size_t level, Node* node, size_t index, ValueT&& value) {
+    if (level == 0) {
+      auto leaf = copy_leaf(static_cast<Leaf*>(node));
+      leaf->values()[index & mask] = std::forward<ValueT>(value);
+      return leaf;
+    }
+    auto inner = copy_inner(static_cast<Inner*>(node));
+    auto slot = (index >> level) & mask;
+    auto child = inner->children[slot];
+    inner->children[slot] = set_path(level - bits, child, index, std::forward<ValueT>(value));
+    release(child, level - bits);
+    return inner;
+  }
+
+  template<typename ...ForwardArgs>
+  inline void push(ForwardArgs&& ...args) {
+    if (_tail != nullptr && _sz - tail_offset() < branching) {
+      if (!is_unique(_tail)) {
+        auto copy = copy_leaf(_tail);
+        release_leaf(_tail);
+        _tail = copy;
+      }
+    } else {
+      if (_tail != nullptr) {
+        Inner* new_root;
+        if ((_sz >> bits) > (size_t(1) << _shift)) {
+          new_root = make_inner();
+          new_root->children[0] = _root;
+          new_root->children[1] = new_path(_shift, _tail);
+          _shift += bits;
+        } else {
+          new_root = push_tail(_shift, _root, _tail);
+          if (_root != nullptr) {
+            release(_root, _shift);
+          }
+        }
+        _root = new_root;
+      }
+      _tail = make_leaf();
+    }
+    new (_tail->values() + _tail->count) T(std::forward<ForwardArgs>(args)...);
+    _tail->count++;
+    _sz++;
+  }
+
+  inline void destroy_all() {
+    if (_root != nullptr) {
+      release(_root, _shift);
+    }
+    release_leaf(_tail);
+  }
+
+public:
+
+  inline PersistentVector():
+    _root(nullptr),
+    _tail(nullptr),
+    _shift(bits),
+    _sz(0) {}
+
+  inline PersistentVector(std::initializer_list<T> elements):
+    PersistentVector() {
+      for (auto& element: elements) {
+        push(element);
+      }
+    }
+
+  template<
+    typename RangeT,
+    typename = std::enable_if_t<IsRange<RangeT>::value && !std::is_same_v<std::decay_t<RangeT>, PersistentVector>>
+  >
+  PersistentVector(RangeT range):
+    PersistentVector() {
+      for (auto&& element: range) {
+        push(element);
+      }
+    }
+
+  inline PersistentVector(const PersistentVector& other):
+    _leaf_allocator(other._leaf_allocator),
+    _inner_allocator(other._inner_allocator),
+    _root(other._root),
+    _tail(other._tail),
+    _shift(other._shift),
+    _sz(other._sz) {
+      retain(_root);
+      retain(_tail);
+    }
+
+  inline PersistentVector(PersistentVector&& other):
+    _leaf_allocator(std::move(other._leaf_allocator)),
+    _inner_allocator(std::move(other._inner_allocator)),
+    _root(other._root),
+    _tail(other._tail),
+    _shift(other._shift),
+    _sz(other._sz) {
+      other._root = nullptr;
+      other._tail = nullptr;
+      other._shift = bits;
+      other._sz = 0;
+    }
+
+  inline PersistentVector& operator=(const PersistentVector& other) {
+    if (this != &other) {
+      PersistentVector copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  inline PersistentVector& operator=(PersistentVector&& other) {
+    if (this != &other) {
+      destroy_all();
+      _leaf_allocator = std::move(other._leaf_allocator);
+      _inner_allocator = std::move(other._inner_allocator);
+      _root = other._root;
+      _tail = other._tail;
+      _shift = other._shift;
+      _sz = other._sz;
+      other._root = nullptr;
+      other._tail = nullptr;
+      other._shift = bits;
+      other._sz = 0;
+    }
+    return *this;
+  }
+
+  inline ~PersistentVector() {
+    destroy_all();
+  }
+
+  inline const T& operator[](size_t index) const {
+    ZEN_ASSERT(index < _sz);
+    return leaf_for(index)[index & mask];
+  }
+
+  /// \brief Return a new version with `element` added to the end.
+  ZEN_NODISCARD inline PersistentVector append(T element) const& {
+    PersistentVector result(*this);
+    result.push(std::move(element));
+    return result;
+  }
+
+  /// \brief Return a new version with `element` added to the end, reusing
+  /// the nodes of this temporary where possible.
+  ZEN_NODISCARD inline PersistentVector append(T element) && {
+    push(std::move(element));
+    return std::move(*this);
+  }
+
+  /// \brief Return a new version where the element at `index` is replaced by
+  /// `element`.
+  ZEN_NODISCARD inline PersistentVector set(size_t index, T element) const {
+    ZEN_ASSERT(index < _sz);
+    PersistentVector result(*this);
+    if (index >= tail_offset()) {
+      auto tail = result.copy_leaf(_tail);
+      tail->values()[index & mask] = std::move(element);
+      result.release_leaf(result._tail);
+      result._tail = tail;
+    } else {
+      auto root = result.set_path(_shift, _root, index, std::move(element));
+      result.release(result._root, _shift);
+      result._root = static_cast<Inner*>(root);
+    }
+    return result;
+  }
+
+  inline bool is_empty() const {
+    return _sz == 0;
+  }
+
+  inline size_t size() const {
+    return _sz;
+  }
+
+  inline Range range() const {
+    return make_iter_range(begin(), end());
+  }
+
+  inline Iter begin() const {
+    return Iter(this, 0);
+  }
+
+  inline Iter end() const {
+    return Iter(this, _sz);
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_PERSISTENT_VECTOR_HPP
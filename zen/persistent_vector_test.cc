@@ -0,0 +1,109 @@
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "zen/persistent_vector.hpp"
+#include "zen/vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+namespace {
+
+std::size_t node_count = 0;
+
+template<typename T>
+class CountingAllocator {
+public:
+
+  inline T* allocate(size_t sz) {
+    node_count++;
+    return static_cast<T*>(malloc(sz * sizeof(T)));
+  }
+
+  inline void free(T* ptr, size_t sz) {
+    node_count--;
+    ::free(ptr);
+  }
+
+};
+
+} // of anonymous namespace
+
+TEST(PersistentVectorTest, CanAppendManyElements) {
+  PersistentVector<int> v1;
+  for (int i = 0; i < 100000; i++) {
+    v1 = std::move(v1).append(i);
+  }
+  ASSERT_EQ(v1.size(), 100000);
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_EQ(v1[i], i);
+  }
+  int k = 0;
+  for (auto element: v1) {
+    ASSERT_EQ(element, k++);
+  }
+  ASSERT_EQ(k, 100000);
+}
+
+TEST(PersistentVectorTest, KeepsOldVersionsIntact) {
+  PersistentVector<std::string> v1;
+  Vector<PersistentVector<std::string>> versions;
+  for (int i = 0; i < 2000; i++) {
+    versions.append(v1);
+    v1 = v1.append(std::to_string(i));
+  }
+  for (int i = 0; i < 2000; i++) {
+    auto& version = versions[i];
+    ASSERT_EQ(version.size(), i);
+    for (int j = 0; j < i; j += 97) {
+      ASSERT_EQ(version[j], std::to_string(j));
+    }
+  }
+}
+
+TEST(PersistentVectorTest, SetReturnsNewVersion) {
+  PersistentVector<int> v1;
+  for (int i = 0; i < 5000; i++) {
+    v1 = std::move(v1).append(i);
+  }
+  auto v2 = v1.set(10, -1).set(4990, -2).set(2048, -3);
+  ASSERT_EQ(v1[10], 10);
+  ASSERT_EQ(v1[4990], 4990);
+  ASSERT_EQ(v1[2048], 2048);
+  ASSERT_EQ(v2[10], -1);
+  ASSERT_EQ(v2[4990], -2);
+  ASSERT_EQ(v2[2048], -3);
+  ASSERT_EQ(v2[11], 11);
+  ASSERT_EQ(v2.size(), 5000);
+}
+
+TEST(PersistentVectorTest, SharesNodesBetweenVersions) {
+  node_count = 0;
+  {
+    PersistentVector<int, CountingAllocator<int>> v1;
+    for (int i = 0; i < 32 * 32 * 32; i++) {
+      v1 = std::move(v1).append(i);
+    }
+    auto before = node_count;
+    auto v2 = v1;
+    ASSERT_EQ(node_count, before);
+    auto v3 = v1.set(12345, 0);
+    // One leaf and two inner nodes on the path from the root
+    ASSERT_EQ(node_count, before + 3);
+    ASSERT_EQ(v3[12345], 0);
+    ASSERT_EQ(v2[12345], 12345);
+  }
+  ASSERT_EQ(node_count, 0);
+}
+
+TEST(PersistentVectorTest, CanBuildFromRange) {
+  Vector<int> v1 { 1, 2, 3 };
+  PersistentVector<int> v2(v1);
+  PersistentVector<int> v3 { 1, 2, 3 };
+  ASSERT_EQ(v2.size(), 3);
+  ASSERT_EQ(v3.size(), 3);
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_EQ(v2[i], v3[i]);
+  }
+}
@@ -0,0 +1,248 @@
+/// \file pool_allocator.hpp
+/// \brief An allocator for many objects of the same size.
+
+#ifndef ZEN_POOL_ALLOCATOR_HPP
+#define ZEN_POOL_ALLOCATOR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+#include "zen/macros.h"
+
+ZEN_NAMESPACE_START
+
+struct _PoolSlot {
+  _PoolSlot* next;
+};
+
+/// The free slots of one thread, which stay behind for the next thread that
+/// uses the pool when the thread exits.
+struct _PoolOwner {
+
+  /// Slots that only the owning thread touches.
+  _PoolSlot* free_list = nullptr;
+
+  /// The part of the newest slab that has not been carved into slots yet.
+  char* bump = nullptr;
+  char* bump_end = nullptr;
+
+  /// Slots that other threads freed, pushed in batches.
+  std::atomic<_PoolSlot*> remote { nullptr };
+
+  _PoolOwner* next_retired = nullptr;
+
+};
+
+struct _PoolSlabHeader {
+  _PoolOwner* owner;
+};
+
+/// \brief The shared state of all PoolAllocators whose slots have the same
+/// size and alignment.
+///
+/// Memory is taken from the system in slabs that are aligned to their size,
+/// so the header of the slab that a slot belongs to is found by masking the
+/// address of the slot. The header points to the thread that carved the
+/// slab.
+///
+/// Each thread pops slots from its own free list without any
+/// synchronisation. A slot that is freed by another thread is collected in a
+/// batch on that thread and handed back with a single atomic operation once
+/// the batch is full, and the owner takes all returned slots at once when its
+/// own free list runs dry.
+template<size_t SlotSize, size_t SlotAlign>
+class _Pool {
+
+  static constexpr size_t slab_size = 64 * 1024;
+  static constexpr size_t header_size = (sizeof(_PoolSlabHeader) + SlotAlign - 1) & ~(SlotAlign - 1);
+  static constexpr size_t batch_size = 32;
+
+  static_assert(header_size + SlotSize <= slab_size, "objects are too large to be pooled");
+
+  struct ThreadCache {
+
+    _PoolOwner* owner = nullptr;
+
+    _PoolOwner* batch_owner = nullptr;
+    _PoolSlot* batch_head = nullptr;
+    _PoolSlot* batch_tail = nullptr;
+    size_t batch_count = 0;
+
+    inline ~ThreadCache() {
+      flush_batch(*this);
+      if (owner != nullptr) {
+        std::lock_guard<std::mutex> lock(retired_mutex());
+        owner->next_retired = retired();
+        retired() = owner;
+      }
+    }
+
+  };
+
+  static inline std::mutex& retired_mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  /// Owners of threads that have exited. They are never freed, because
+  /// their slabs may still be in use.
+  static inline _PoolOwner*& retired() {
+    static _PoolOwner* head = nullptr;
+    return head;
+  }
+
+  static inline ThreadCache& cache() {
+    static thread_local ThreadCache cache;
+    return cache;
+  }
+
+  static inline _PoolOwner* adopt_owner() {
+    {
+      std::lock_guard<std::mutex> lock(retired_mutex());
+      auto owner = retired();
+      if (owner != nullptr) {
+        retired() = owner->next_retired;
+        return owner;
+      }
+    }
+    return new _PoolOwner;
+  }
+
+  static inline void flush_batch(ThreadCache& cache) {
+    if (cache.batch_head == nullptr) {
+      return;
+    }
+    auto& remote = cache.batch_owner->remote;
+    auto head = remote.load(std::memory_order_relaxed);
+    do {
+      cache.batch_tail->next = head;
+    } while (!remote.compare_exchange_weak(head, cache.batch_head, std::memory_order_release, std::memory_order_relaxed));
+    cache.batch_head = cache.batch_tail = nullptr;
+    cache.batch_count = 0;
+  }
+
+  static inline void new_slab(_PoolOwner* owner) {
+    auto slab = static_cast<char*>(aligned_alloc(slab_size, slab_size));
+    ZEN_ASSERT(slab != nullptr);
+    reinterpret_cast<_PoolSlabHeader*>(slab)->owner = owner;
+    owner->bump = slab + header_size;
+    owner->bump_end = owner->bump + (slab_size - header_size) / SlotSize * SlotSize;
+  }
+
+public:
+
+  static inline void* allocate() {
+    auto& c = cache();
+    if (c.owner == nullptr) {
+      c.owner = adopt_owner();
+    }
+    auto owner = c.owner;
+    if (owner->free_list == nullptr) {
+      owner->free_list = owner->remote.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (owner->free_list != nullptr) {
+      auto slot = owner->free_list;
+      owner->free_list = slot->next;
+      return slot;
+    }
+    if (owner->bump == owner->bump_end) {
+      new_slab(owner);
+    }
+    auto ptr = owner->bump;
+    owner->bump += SlotSize;
+    return ptr;
+  }
+
+  static inline void free(void* ptr) {
+    auto header = reinterpret_cast<_PoolSlabHeader*>(reinterpret_cast<uintptr_t>(ptr) & ~uintptr_t(slab_size - 1));
+    auto slot = static_cast<_PoolSlot*>(ptr);
+    auto& c = cache();
+    if (header->owner == c.owner) {
+      slot->next = c.owner->free_list;
+      c.owner->free_list = slot;
+      return;
+    }
+    if (c.batch_owner != header->owner) {
+      flush_batch(c);
+      c.batch_owner = header->owner;
+    }
+    slot->next = c.batch_head;
+    c.batch_head = slot;
+    if (c.batch_tail == nullptr) {
+      c.batch_tail = slot;
+    }
+    if (++c.batch_count == batch_size) {
+      flush_batch(c);
+    }
+  }
+
+  static inline void flush() {
+    flush_batch(cache());
+  }
+
+};
+
+/// \brief An allocator that hands out single objects from slabs.
+///
+/// Allocating or freeing one object takes a few instructions and no locks,
+/// and objects of the same size are packed densely, which makes this
+/// allocator a good fit for the nodes of node-based containers:
+///
+/// ```
+/// DLList<Token, size_t, PoolAllocator<Token>> tokens;
+/// ```
+///
+/// All PoolAllocators for types of the same size and alignment share their
+/// slabs. Slabs are never given back to the system, because a pool is
+/// expected to be reused by the same kind of objects.
+///
+/// Objects may be freed on another thread than the one that allocated them.
+/// They are then returned to their owner in batches, so a thread may hold on
+/// to up to a batch of such objects until it calls flush() or exits.
+///
+/// Requests for more than one object are passed on to `malloc`.
+template<typename T>
+class PoolAllocator {
+
+  static constexpr size_t slot_align = alignof(T) > alignof(_PoolSlot) ? alignof(T) : alignof(_PoolSlot);
+  static constexpr size_t slot_size = ((sizeof(T) > sizeof(_PoolSlot) ? sizeof(T) : sizeof(_PoolSlot)) + slot_align - 1) & ~(slot_align - 1);
+
+  using Pool = _Pool<slot_size, slot_align>;
+
+public:
+
+  inline T* allocate(size_t sz) {
+    if (sz == 1) {
+      return static_cast<T*>(Pool::allocate());
+    }
+    return static_cast<T*>(malloc(sz * sizeof(T)));
+  }
+
+  inline void free(T* ptr, size_t sz) {
+    if (ptr == nullptr) {
+      return;
+    }
+    if (sz == 1) {
+      Pool::free(ptr);
+    } else {
+      ::free(ptr);
+    }
+  }
+
+  /// \brief Return the objects that this thread freed on behalf of other
+  /// threads right away instead of waiting for a full batch.
+  static inline void flush() {
+    Pool::flush();
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_POOL_ALLOCATOR_HPP
@@ -0,0 +1,108 @@
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "zen/dllist.hpp"
+#include "zen/pool_allocator.hpp"
+#include "zen/vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(PoolAllocatorTest, ReusesFreedSlots) {
+  PoolAllocator<uint64_t> allocator;
+  auto a = allocator.allocate(1);
+  auto b = allocator.allocate(1);
+  ASSERT_NE(a, b);
+  *a = 1;
+  *b = 2;
+  allocator.free(a, 1);
+  ASSERT_EQ(allocator.allocate(1), a);
+  ASSERT_EQ(*b, 2);
+  allocator.free(a, 1);
+  allocator.free(b, 1);
+  auto array = allocator.allocate(100);
+  array[99] = 3;
+  allocator.free(array, 100);
+}
+
+TEST(PoolAllocatorTest, CanBackNodeBasedContainers) {
+  DLList<int, size_t, PoolAllocator<int>> l1;
+  for (int i = 0; i < 100000; i++) {
+    l1.append(i);
+  }
+  int k = 0;
+  for (auto i: l1) {
+    ASSERT_EQ(i, k++);
+  }
+  l1.clear();
+  ASSERT_TRUE(l1.is_empty());
+}
+
+TEST(PoolAllocatorTest, ReturnsSlotsFreedOnOtherThreadsToTheirOwner) {
+  PoolAllocator<uint64_t> allocator;
+  Vector<uint64_t*> ptrs;
+  for (size_t i = 0; i < 1000; i++) {
+    auto ptr = allocator.allocate(1);
+    *ptr = i;
+    ptrs.append(ptr);
+  }
+  std::thread other([&]() {
+    for (auto ptr: ptrs) {
+      allocator.free(ptr, 1);
+    }
+    allocator.flush();
+  });
+  other.join();
+  Vector<uint64_t*> reused;
+  for (size_t i = 0; i < 1000; i++) {
+    reused.append(allocator.allocate(1));
+  }
+  std::sort(reused.begin(), reused.end());
+  std::sort(ptrs.begin(), ptrs.end());
+  for (size_t i = 0; i < 1000; i++) {
+    ASSERT_EQ(reused[i], ptrs[i]);
+  }
+  for (auto ptr: reused) {
+    allocator.free(ptr, 1);
+  }
+}
+
+TEST(PoolAllocatorTest, SurvivesFreesFromManyThreads) {
+  PoolAllocator<uint64_t> allocator;
+  std::mutex mutex;
+  Vector<uint64_t*> shared;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([&]() {
+      for (size_t round = 0; round < 50; round++) {
+        for (size_t i = 0; i < 100; i++) {
+          auto ptr = allocator.allocate(1);
+          *ptr = 42;
+          std::lock_guard<std::mutex> lock(mutex);
+          shared.append(ptr);
+        }
+        for (size_t i = 0; i < 100; i++) {
+          uint64_t* ptr;
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto sz = shared.size();
+            ptr = shared[sz - 1];
+            shared.resize(sz - 1);
+          }
+          ASSERT_EQ(*ptr, 42);
+          *ptr = 0;
+          allocator.free(ptr, 1);
+        }
+      }
+    });
+  }
+  for (auto& thread: threads) {
+    thread.join();
+  }
+  ASSERT_EQ(shared.size(), 0);
+}
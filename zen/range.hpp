@@ -23,10 +23,12 @@ struct IsRange<
    > : True {};
 
 template<typename Range, typename Fn, typename OutIt>
-inline typename std::invoke_result<Fn(typename Range::value_type)>::type transform(Range range, Fn transformer, OutIt out) {
+inline OutIt transform(Range range, Fn transformer, OutIt out) {
   for (auto& element: range) {
     *out = transformer(element);
+    ++out;
   }
+  return out;
 }
 
 /**
@@ -71,6 +73,40 @@ inline IterRange<IterT> make_iter_range(IterT begin, IterT end) {
   return IterRange<IterT> { begin, end };
 }
 
+template<typename T, typename = void>
+struct HasSize : False {};
+
+template<typename T>
+struct HasSize<T, VoidT<decltype(declval<T&>().size())>> : True {};
+
+template<typename T, typename = void>
+struct HasIterDiff : False {};
+
+template<typename T>
+struct HasIterDiff<T, VoidT<decltype(declval<T&>().end() - declval<T&>().begin())>> : True {};
+
+/**
+ * @brief Count the amount of elements in a range.
+ *
+ * This runs in constant time if the range knows its own size or if its
+ * iterators can be subtracted from one another. Otherwise, the range is
+ * traversed once, so it must be possible to iterate over it again afterwards.
+ */
+template<typename RangeT>
+inline size_t range_size(RangeT& range) {
+  if constexpr (HasSize<RangeT>::value) {
+    return range.size();
+  } else if constexpr (HasIterDiff<RangeT>::value) {
+    return range.end() - range.begin();
+  } else {
+    size_t count = 0;
+    for (auto it = range.begin(); it != range.end(); ++it) {
+      count++;
+    }
+    return count;
+  }
+}
+
 ZEN_NAMESPACE_END
 
 #endif // ZEN_RANGE_HPP
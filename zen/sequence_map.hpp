@@ -1,18 +1,47 @@
 #ifndef ZEN_SEQUENCE_MAP_HPP
 #define ZEN_SEQUENCE_MAP_HPP
 
-#include <memory>
-#include <unordered_map>
-#include <list>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <utility>
+
+#include "zen/allocator.hpp"
+#include "zen/hash.hpp"
+#include "zen/macros.h"
+#include "zen/vector.hpp"
 
 namespace zen {
 
+  /// \brief A hash map that remembers the order in which keys were inserted.
+  ///
+  /// The entries are stored one after the other in a single buffer, in
+  /// insertion order, which is also the order in which they are iterated.
+  /// Next to each entry, the map keeps 31 bits of the hash of its key. Keys
+  /// are found through an open-addressing table of 32-bit entry positions
+  /// that uses linear probing. Small maps do not need that table at all: up
+  /// to `linear_scan_limit` entries, a lookup simply compares the stored
+  /// hashes one by one.
+  ///
+  /// Compared to a linked list of entries with a separate node-based index,
+  /// this takes no allocations per entry and stores each key only once.
+  ///
+  /// Erasing an entry destroys it and leaves a tombstone in its place, so
+  /// that the other entries keep their position. Erasing never invalidates
+  /// iterators or references to entries other than the erased one. The
+  /// tombstones are removed by the next insertion that either has to grow
+  /// the buffer or finds that more than half of the used slots are
+  /// tombstones. Because of this, inserting an entry may move all other
+  /// entries, which invalidates all iterators and references.
   template<
     typename Key,
     typename Value,
-    typename Hash = std::hash<Key>,
+    typename KeyHash = Hash<Key>,
     typename KeyEqual = std::equal_to<Key>,
-    typename Allocator = std::allocator<std::pair<const Key, Value>>
+    typename Allocator = DefaultAllocator<std::pair<const Key, Value>>
   >
   class sequence_map {
   public:
@@ -22,81 +51,553 @@ namespace zen {
     using value_type = std::pair<const Key, Value>;
     using size_type = std::size_t;
     using difference_type = std::ptrdiff_t;
-    using hasher = Hash;
+    using hasher = KeyHash;
     using key_equal = KeyEqual;
     using allocator_type = Allocator;
     using reference = value_type&;
     using const_reference = const value_type&;
-    using pointer = typename std::allocator_traits<Allocator>::pointer;
-    using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+
+    /// Maps with at most this many entries are searched without an index.
+    static constexpr size_type linear_scan_limit = 8;
 
   private:
-    using sequence_type = typename std::list<value_type, Allocator>;
-    using index_type = typename std::unordered_map<Key, Value*, Hash, KeyEqual>;
+
+    static constexpr std::uint32_t empty_slot = UINT32_MAX;
+
+    /// Stored in place of the hash of an erased entry. Real hashes never
+    /// have their highest bit set.
+    static constexpr std::uint32_t dead_hash = UINT32_MAX;
+
+    static constexpr size_type not_found = SIZE_MAX;
+
+    template<typename EntryT>
+    class basic_iterator {
+
+      friend class sequence_map;
+
+      EntryT* entry = nullptr;
+      const std::uint32_t* hash = nullptr;
+      const std::uint32_t* hash_end = nullptr;
+
+      inline basic_iterator(EntryT* entry, const std::uint32_t* hash, const std::uint32_t* hash_end):
+        entry(entry), hash(hash), hash_end(hash_end) {
+          skip_dead();
+        }
+
+      inline void skip_dead() {
+        while (hash != hash_end && *hash == dead_hash) {
+          ++hash;
+          ++entry;
+        }
+      }
+
+    public:
+
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = EntryT;
+      using difference_type = std::ptrdiff_t;
+      using pointer = EntryT*;
+      using reference = EntryT&;
+
+      basic_iterator() = default;
+
+      /// Allows an iterator to be converted into a const_iterator.
+      template<typename OtherEntryT>
+      inline basic_iterator(const basic_iterator<OtherEntryT>& other):
+        entry(other.entry), hash(other.hash), hash_end(other.hash_end) {}
+
+      inline EntryT& operator*() const {
+        return *entry;
+      }
+
+      inline EntryT* operator->() const {
+        return entry;
+      }
+
+      inline basic_iterator& operator++() {
+        ++hash;
+        ++entry;
+        skip_dead();
+        return *this;
+      }
+
+      inline basic_iterator operator++(int) {
+        auto old = *this;
+        ++*this;
+        return old;
+      }
+
+      template<typename OtherEntryT>
+      inline bool operator==(const basic_iterator<OtherEntryT>& other) const {
+        return entry == other.entry;
+      }
+
+      template<typename OtherEntryT>
+      inline bool operator!=(const basic_iterator<OtherEntryT>& other) const {
+        return entry != other.entry;
+      }
+
+    };
 
   public:
-    using iterator = typename sequence_type::iterator;
-    using const_iterator = typename sequence_type::const_iterator;
+
+    using iterator = basic_iterator<value_type>;
+    using const_iterator = basic_iterator<const value_type>;
 
   private:
 
-    sequence_type sequence;
-    index_type index;
+    Allocator allocator;
 
-  public:
+    /// Holds `used` slots, some of which may be tombstones.
+    value_type* entries = nullptr;
+    size_type capacity = 0;
+    size_type used = 0;
 
-    inline sequence_map(std::initializer_list<value_type> init):
-      sequence(init.begin(), init.end()) {
-      for (auto& [key, value]: sequence) {
-        index.emplace(key, &value);
+    /// The amount of slots that hold a live entry.
+    size_type live = 0;
+
+    /// No live entry comes before this slot.
+    size_type first = 0;
+
+    Vector<std::uint32_t, size_type> hashes;
+    Vector<std::uint32_t, size_type> index;
+    KeyHash hash_function;
+    KeyEqual key_equal_function;
+
+    inline std::uint32_t hash_key(const Key& key) const {
+      return static_cast<std::uint32_t>(hash_function(key)) & 0x7FFFFFFF;
+    }
+
+    inline iterator make_iterator(size_type position) {
+      auto hash_data = hashes.data();
+      return iterator(entries + position, hash_data + position, hash_data + used);
+    }
+
+    inline const_iterator make_iterator(size_type position) const {
+      auto hash_data = hashes.data();
+      return const_iterator(entries + position, hash_data + position, hash_data + used);
+    }
+
+    inline size_type find_position(const Key& key, std::uint32_t hash) const {
+      auto hash_data = hashes.data();
+      if (index.size() == 0) {
+        for (size_type i = first; i < used; i++) {
+          if (hash_data[i] == hash && key_equal_function(entries[i].first, key)) {
+            return i;
+          }
+        }
+        return not_found;
+      }
+      auto slots = index.data();
+      auto mask = index.size() - 1;
+      for (auto i = hash & mask;; i = (i + 1) & mask) {
+        auto slot = slots[i];
+        if (slot == empty_slot) {
+          return not_found;
+        }
+        if (hash_data[slot] == hash && key_equal_function(entries[slot].first, key)) {
+          return slot;
+        }
       }
     }
 
-    inline sequence_map() {};
+    inline void index_position(size_type position) {
+      auto slots = index.data();
+      auto mask = index.size() - 1;
+      auto i = hashes.data()[position] & mask;
+      while (slots[i] != empty_slot) {
+        i = (i + 1) & mask;
+      }
+      slots[i] = static_cast<std::uint32_t>(position);
+    }
+
+    /// Remove `position` from the index, shifting later entries of the
+    /// same probe sequence back so that lookups need no tombstones.
+    inline void unindex_position(size_type position) {
+      auto slots = index.data();
+      auto hash_data = hashes.data();
+      auto mask = index.size() - 1;
+      auto i = hash_data[position] & mask;
+      while (slots[i] != position) {
+        i = (i + 1) & mask;
+      }
+      for (auto j = (i + 1) & mask; slots[j] != empty_slot; j = (j + 1) & mask) {
+        auto home = hash_data[slots[j]] & mask;
+        // Move the slot at `j` into the hole at `i` unless its home lies
+        // cyclically in (i, j].
+        bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+        if (!stays) {
+          slots[i] = slots[j];
+          i = j;
+        }
+      }
+      slots[i] = empty_slot;
+    }
+
+    /// Rebuild the index so that `count` entries fit in it while it is at
+    /// most half full.
+    inline void rebuild_index(size_type count) {
+      if (count <= linear_scan_limit && index.size() == 0) {
+        return;
+      }
+      size_type index_capacity = 16;
+      while (index_capacity < count * 2) {
+        index_capacity *= 2;
+      }
+      Vector<std::uint32_t, size_type> new_index;
+      new_index.resize(index_capacity, empty_slot);
+      index = std::move(new_index);
+      auto hash_data = hashes.data();
+      for (size_type i = 0; i < used; i++) {
+        if (hash_data[i] != dead_hash) {
+          index_position(i);
+        }
+      }
+    }
 
-    sequence_map(const sequence_map& other) = default;
-    sequence_map(sequence_map&& other) = default;
+    /// Move the live entries into a buffer of `new_capacity` slots, dropping
+    /// all tombstones.
+    inline void compact(size_type new_capacity) {
+      auto new_entries = new_capacity == capacity ? entries : allocator.allocate(new_capacity);
+      ZEN_ASSERT(new_entries != nullptr);
+      auto hash_data = hashes.data();
+      size_type count = 0;
+      for (size_type i = first; i < used; i++) {
+        if (hash_data[i] == dead_hash) {
+          continue;
+        }
+        if (new_entries + count != entries + i) {
+          new (new_entries + count) value_type(std::move(entries[i]));
+          entries[i].~value_type();
+        }
+        hash_data[count++] = hash_data[i];
+      }
+      if (new_entries != entries && entries != nullptr) {
+        allocator.free(entries, capacity);
+      }
+      entries = new_entries;
+      capacity = new_capacity;
+      used = count;
+      first = 0;
+      hashes.resize(count);
+      if (index.size() > 0) {
+        index.resize(0);
+        rebuild_index(count);
+      }
+    }
+
+    /// Whether append_entry() is going to move the existing entries.
+    inline bool must_compact() const {
+      return used == capacity || (used - live) * 2 > used;
+    }
 
     template<typename ...ForwardArgs>
-    value_type& emplace(ForwardArgs&& ...args) {
-      auto to_insert = value_type(std::forward<ForwardArgs>(args)...);
-      sequence.push_back(to_insert);
-      auto& inserted = sequence.back();
-      auto& [key, value] = inserted;
-      index.emplace(key, &value);
-      return inserted;
-    }
-
-    sequence_map& operator=(sequence_map&& other) {
-      sequence = std::move(other.sequence);
-      index = std::move(other.index);
+    inline iterator append_entry(std::uint32_t hash, ForwardArgs&& ...args) {
+      if (used == capacity) {
+        // Only grow if dropping the tombstones would not leave enough room.
+        compact(live * 2 < capacity ? capacity : (capacity < 4 ? 4 : capacity * 2));
+      } else if ((used - live) * 2 > used) {
+        // Keep iteration from slowing down once most slots are tombstones.
+        // This runs after at least used / 2 erasures, so its cost is
+        // amortized over those.
+        compact(capacity);
+      }
+      ZEN_ASSERT(used < empty_slot);
+      new (entries + used) value_type(std::forward<ForwardArgs>(args)...);
+      hashes.append(hash);
+      auto position = used++;
+      live++;
+      if (live > index.size() / 2) {
+        rebuild_index(live);
+      } else {
+        index_position(position);
+      }
+      return make_iterator(position);
+    }
+
+    inline void destroy_all() {
+      auto hash_data = hashes.data();
+      for (size_type i = first; i < used; i++) {
+        if (hash_data[i] != dead_hash) {
+          entries[i].~value_type();
+        }
+      }
+      if (entries != nullptr) {
+        allocator.free(entries, capacity);
+      }
+    }
+
+  public:
+
+    inline sequence_map() {};
+
+    inline sequence_map(std::initializer_list<value_type> init) {
+      reserve(init.size());
+      for (auto& entry: init) {
+        insert(entry);
+      }
+    }
+
+    inline sequence_map(const sequence_map& other):
+      allocator(other.allocator),
+      hash_function(other.hash_function),
+      key_equal_function(other.key_equal_function) {
+        reserve(other.live);
+        for (auto it = other.begin(); it != other.end(); ++it) {
+          append_entry(*it.hash, *it);
+        }
+      }
+
+    inline sequence_map(sequence_map&& other):
+      allocator(std::move(other.allocator)),
+      entries(other.entries),
+      capacity(other.capacity),
+      used(other.used),
+      live(other.live),
+      first(other.first),
+      hashes(std::move(other.hashes)),
+      index(std::move(other.index)),
+      hash_function(std::move(other.hash_function)),
+      key_equal_function(std::move(other.key_equal_function)) {
+        other.entries = nullptr;
+        other.capacity = 0;
+        other.used = 0;
+        other.live = 0;
+        other.first = 0;
+      }
+
+    inline sequence_map& operator=(const sequence_map& other) {
+      if (this != &other) {
+        sequence_map copy(other);
+        swap(copy);
+      }
       return *this;
-    };
+    }
 
-    sequence_map& operator=(const sequence_map& other)  {
-      std::copy(other.sequence.cbegin(), other.sequence.cend(), std::back_inserter(sequence));
-      std::copy(other.index.cbegin(), other.index.cend(), std::inserter(index, index.end()));
+    inline sequence_map& operator=(sequence_map&& other) {
+      if (this != &other) {
+        sequence_map moved(std::move(other));
+        swap(moved);
+      }
       return *this;
     }
 
-    inline size_type size() {
-      return sequence.size();
+    inline ~sequence_map() {
+      destroy_all();
+    }
+
+    inline void swap(sequence_map& other) {
+      std::swap(allocator, other.allocator);
+      std::swap(entries, other.entries);
+      std::swap(capacity, other.capacity);
+      std::swap(used, other.used);
+      std::swap(live, other.live);
+      std::swap(first, other.first);
+      hashes.swap(other.hashes);
+      index.swap(other.index);
+      std::swap(hash_function, other.hash_function);
+      std::swap(key_equal_function, other.key_equal_function);
+    }
+
+    /// \brief Make room for `count` entries without growing the entry
+    /// buffer or the index.
+    inline void reserve(size_type count) {
+      if (count > capacity) {
+        compact(count);
+      }
+      hashes.reserve(count);
+      if (count > index.size() / 2) {
+        rebuild_index(count);
+      }
+    }
+
+    /// \brief Insert a new entry that is constructed from `args`, unless
+    /// its key is already present.
+    ///
+    /// Returns an iterator to the entry with the key, and whether the entry
+    /// was inserted.
+    template<typename ...ForwardArgs>
+    std::pair<iterator, bool> emplace(ForwardArgs&& ...args) {
+      value_type entry(std::forward<ForwardArgs>(args)...);
+      auto hash = hash_key(entry.first);
+      auto position = find_position(entry.first, hash);
+      if (position != not_found) {
+        return { make_iterator(position), false };
+      }
+      return { append_entry(hash, std::move(entry)), true };
+    }
+
+    /// \brief Insert `key` with a value constructed from `args`, unless the
+    /// key is already present.
+    ///
+    /// Unlike emplace(), nothing is constructed if the key already exists.
+    template<typename ...ForwardArgs>
+    std::pair<iterator, bool> try_emplace(key_type key, ForwardArgs&& ...args) {
+      auto hash = hash_key(key);
+      auto position = find_position(key, hash);
+      if (position != not_found) {
+        return { make_iterator(position), false };
+      }
+      if (must_compact()) {
+        // Construct the entry before the other entries are moved, because
+        // the arguments might refer to one of them.
+        value_type entry(
+          std::piecewise_construct,
+          std::forward_as_tuple(std::move(key)),
+          std::forward_as_tuple(std::forward<ForwardArgs>(args)...)
+        );
+        return { append_entry(hash, std::move(entry)), true };
+      }
+      auto inserted = append_entry(
+        hash,
+        std::piecewise_construct,
+        std::forward_as_tuple(std::move(key)),
+        std::forward_as_tuple(std::forward<ForwardArgs>(args)...)
+      );
+      return { inserted, true };
+    }
+
+    inline std::pair<iterator, bool> insert(const value_type& entry) {
+      return try_emplace(entry.first, entry.second);
+    }
+
+    inline std::pair<iterator, bool> insert(value_type&& entry) {
+      return try_emplace(entry.first, std::move(entry.second));
+    }
+
+    /// \brief Set the value of `key`, appending a new entry if the key is
+    /// not present yet.
+    template<typename ValueT>
+    std::pair<iterator, bool> insert_or_assign(key_type key, ValueT&& value) {
+      auto result = try_emplace(std::move(key), std::forward<ValueT>(value));
+      if (!result.second) {
+        result.first->second = std::forward<ValueT>(value);
+      }
+      return result;
+    }
+
+    /// \brief Remove the entry that `pos` points to.
+    ///
+    /// Returns an iterator to the entry that followed it. Iterators to other
+    /// entries remain valid.
+    inline iterator erase(const_iterator pos) {
+      auto position = static_cast<size_type>(pos.entry - entries);
+      ZEN_ASSERT(position < used && hashes.data()[position] != dead_hash);
+      if (index.size() > 0) {
+        unindex_position(position);
+      }
+      entries[position].~value_type();
+      auto hash_data = hashes.data();
+      hash_data[position] = dead_hash;
+      live--;
+      while (first < used && hash_data[first] == dead_hash) {
+        first++;
+      }
+      // Even if this was the last entry, `used` stays the same so that end()
+      // does not move. The next insertion drops the tombstones.
+      return make_iterator(position);
+    }
+
+    /// \brief Remove the entry of `key`, if there is one.
+    ///
+    /// Returns the amount of entries that were removed.
+    inline size_type erase(const key_type& key) {
+      auto position = find_position(key, hash_key(key));
+      if (position == not_found) {
+        return 0;
+      }
+      erase(make_iterator(position));
+      return 1;
+    }
+
+    inline iterator find(const key_type& key) {
+      auto position = find_position(key, hash_key(key));
+      return position == not_found ? end() : make_iterator(position);
+    }
+
+    inline const_iterator find(const key_type& key) const {
+      auto position = find_position(key, hash_key(key));
+      return position == not_found ? end() : make_iterator(position);
+    }
+
+    inline bool contains(const key_type& key) const {
+      return find_position(key, hash_key(key)) != not_found;
+    }
+
+    inline size_type count(const key_type& key) const {
+      return contains(key) ? 1 : 0;
+    }
+
+    /// \brief Get the value of a key that must be present.
+    inline mapped_type& at(const key_type& key) {
+      auto match = find(key);
+      ZEN_ASSERT(match != end());
+      return match->second;
+    }
+
+    inline const mapped_type& at(const key_type& key) const {
+      auto match = find(key);
+      ZEN_ASSERT(match != end());
+      return match->second;
+    }
+
+    /// \brief Get the value of `key`, appending a default-constructed value
+    /// if the key is not present yet.
+    inline mapped_type& operator[](const key_type& key) {
+      return try_emplace(key).first->second;
+    }
+
+    inline mapped_type& operator[](key_type&& key) {
+      return try_emplace(std::move(key)).first->second;
+    }
+
+    /// \brief Remove all entries while keeping the buffer around.
+    inline void clear() {
+      auto hash_data = hashes.data();
+      for (size_type i = first; i < used; i++) {
+        if (hash_data[i] != dead_hash) {
+          entries[i].~value_type();
+        }
+      }
+      used = 0;
+      live = 0;
+      first = 0;
+      hashes.resize(0);
+      index.resize(0);
+    }
+
+    inline size_type size() const {
+      return live;
+    }
+
+    inline bool empty() const {
+      return live == 0;
+    }
+
+    inline iterator begin() {
+      return make_iterator(first);
+    }
+
+    inline iterator end() {
+      return make_iterator(used);
     }
 
-    reference operator[](const key_type& key) {
-      return index[key];
+    inline const_iterator begin() const {
+      return make_iterator(first);
     }
 
-    reference operator[](key_type&& key) {
-      return index[std::move(key)];
+    inline const_iterator end() const {
+      return make_iterator(used);
     }
 
-    iterator begin() {
-      return sequence.begin();
+    inline const_iterator cbegin() const {
+      return begin();
     }
 
-    iterator end() {
-      return sequence.end();
+    inline const_iterator cend() const {
+      return end();
     }
 
   };
@@ -0,0 +1,225 @@
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include "zen/sequence_map.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(SequenceMapTest, IteratesInInsertionOrder) {
+  sequence_map<std::string, int> m1 {
+    { "zeta", 1 },
+    { "alpha", 2 },
+    { "mu", 3 },
+  };
+  m1.emplace("beta", 4);
+  ASSERT_FALSE(m1.emplace("alpha", 5).second);
+  ASSERT_EQ(m1.size(), 4);
+  std::vector<std::string> keys;
+  for (auto& [key, value]: m1) {
+    keys.push_back(key);
+  }
+  ASSERT_EQ(keys, (std::vector<std::string> { "zeta", "alpha", "mu", "beta" }));
+  ASSERT_EQ(m1.at("alpha"), 2);
+}
+
+TEST(SequenceMapTest, IndexOperatorReturnsValue) {
+  sequence_map<std::string, int> m1;
+  m1["one"] = 1;
+  m1["two"] = 2;
+  m1["one"] += 10;
+  ASSERT_EQ(m1.size(), 2);
+  ASSERT_EQ(m1["one"], 11);
+  ASSERT_EQ(m1["two"], 2);
+  ASSERT_EQ(m1.begin()->first, "one");
+  ASSERT_TRUE(m1.insert_or_assign("two", 22).second == false);
+  ASSERT_EQ(m1.at("two"), 22);
+  ASSERT_TRUE(m1.find("three") == m1.end());
+  ASSERT_FALSE(m1.contains("three"));
+  ASSERT_EQ(m1.count("one"), 1);
+}
+
+TEST(SequenceMapTest, CopyAssignmentReplacesEntries) {
+  sequence_map<std::string, int> m1 { { "a", 1 }, { "b", 2 } };
+  sequence_map<std::string, int> m2 { { "c", 3 } };
+  m2 = m1;
+  ASSERT_EQ(m2.size(), 2);
+  ASSERT_FALSE(m2.contains("c"));
+  ASSERT_EQ(m2.at("a"), 1);
+  m2["a"] = 10;
+  ASSERT_EQ(m1.at("a"), 1);
+  sequence_map<std::string, int> m3 = std::move(m2);
+  ASSERT_EQ(m3.at("a"), 10);
+  m3.clear();
+  ASSERT_TRUE(m3.empty());
+  ASSERT_FALSE(m3.contains("a"));
+}
+
+namespace {
+
+int next_allocator_id = 0;
+int last_allocator_id = -1;
+
+/// Remembers which instance made the last allocation.
+template<typename T>
+struct NumberedAllocator {
+
+  int id = next_allocator_id++;
+
+  T* allocate(size_t sz) {
+    last_allocator_id = id;
+    return static_cast<T*>(malloc(sz * sizeof(T)));
+  }
+
+  void free(T* ptr, size_t sz) {
+    ::free(ptr);
+  }
+
+};
+
+} // of anonymous namespace
+
+TEST(SequenceMapTest, ClearKeepsAllocatorAndBuffer) {
+  sequence_map<int, std::string, Hash<int>, std::equal_to<int>, NumberedAllocator<std::pair<const int, std::string>>> m1;
+  m1[1] = "one";
+  auto id = last_allocator_id;
+  m1.clear();
+  ASSERT_TRUE(m1.empty());
+  ASSERT_TRUE(m1.begin() == m1.end());
+  ASSERT_FALSE(m1.contains(1));
+  last_allocator_id = -1;
+  for (int i = 0; i < 100; i++) {
+    m1[i] = std::to_string(i);
+  }
+  ASSERT_EQ(last_allocator_id, id);
+  ASSERT_EQ(m1.size(), 100);
+  ASSERT_EQ(m1.at(42), "42");
+}
+
+TEST(SequenceMapTest, CanInsertValueOfItself) {
+  sequence_map<int, std::string> m1;
+  m1[0] = "a fairly long string that lives on the heap";
+  for (int i = 1; i < 1000; i++) {
+    m1.try_emplace(i, m1.at(i - 1));
+    if (i % 3 == 0) {
+      m1.erase(i - 2);
+    }
+  }
+  ASSERT_EQ(m1.at(999), m1.at(0));
+}
+
+TEST(SequenceMapTest, FindsKeysInLargeMaps) {
+  sequence_map<int, int> m1;
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_TRUE(m1.try_emplace(i * 7, i).second);
+  }
+  ASSERT_EQ(m1.size(), 10000);
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(m1.at(i * 7), i);
+    ASSERT_FALSE(m1.contains(i * 7 + 1));
+  }
+  int expected = 0;
+  for (auto& [key, value]: m1) {
+    ASSERT_EQ(value, expected++);
+  }
+}
+
+TEST(SequenceMapTest, CanEraseWhileKeepingOrder) {
+  sequence_map<std::string, int> m1 {
+    { "a", 1 },
+    { "b", 2 },
+    { "c", 3 },
+    { "d", 4 },
+  };
+  auto c = m1.find("c");
+  ASSERT_EQ(m1.erase("b"), 1);
+  ASSERT_EQ(m1.erase("b"), 0);
+  ASSERT_EQ(c->second, 3);
+  ASSERT_EQ(m1.size(), 3);
+  ASSERT_FALSE(m1.contains("b"));
+  auto next = m1.erase(m1.find("a"));
+  ASSERT_TRUE(next == c);
+  ASSERT_TRUE(m1.begin() == c);
+  std::vector<std::string> keys;
+  for (auto& [key, value]: m1) {
+    keys.push_back(key);
+  }
+  ASSERT_EQ(keys, (std::vector<std::string> { "c", "d" }));
+  m1["b"] = 5;
+  keys.clear();
+  for (auto& [key, value]: m1) {
+    keys.push_back(key);
+  }
+  ASSERT_EQ(keys, (std::vector<std::string> { "c", "d", "b" }));
+}
+
+TEST(SequenceMapTest, CanEraseDuringIteration) {
+  sequence_map<int, int> m1;
+  for (int i = 0; i < 1000; i++) {
+    m1[i] = i;
+  }
+  for (auto it = m1.begin(); it != m1.end();) {
+    if (it->first % 3 != 0) {
+      it = m1.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ASSERT_EQ(m1.size(), 334);
+  int expected = 0;
+  for (auto& [key, value]: m1) {
+    ASSERT_EQ(key, expected);
+    expected += 3;
+  }
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(m1.contains(i), i % 3 == 0);
+  }
+}
+
+TEST(SequenceMapTest, KeepsEndWhenErasingLastEntry) {
+  sequence_map<int, int> m1;
+  for (int i = 0; i < 100; i++) {
+    m1[i] = i;
+  }
+  auto count = 0;
+  for (auto it = m1.begin(), end = m1.end(); it != end;) {
+    it = m1.erase(it);
+    count++;
+  }
+  ASSERT_EQ(count, 100);
+  ASSERT_TRUE(m1.empty());
+  ASSERT_TRUE(m1.begin() == m1.end());
+  m1[5] = 50;
+  ASSERT_EQ(m1.size(), 1);
+  ASSERT_EQ(m1.begin()->second, 50);
+}
+
+TEST(SequenceMapTest, CompactsAfterHeavyChurn) {
+  sequence_map<std::string, std::string> m1;
+  for (int round = 0; round < 50; round++) {
+    for (int i = 0; i < 100; i++) {
+      m1[std::to_string(round * 100 + i)] = "value";
+    }
+    for (int i = 0; i < 100; i += 2) {
+      ASSERT_EQ(m1.erase(std::to_string(round * 100 + i)), 1);
+    }
+  }
+  ASSERT_EQ(m1.size(), 2500);
+  size_t count = 0;
+  for (auto& entry: m1) {
+    ASSERT_EQ(std::stoi(entry.first) % 2, 1);
+    count++;
+  }
+  ASSERT_EQ(count, 2500);
+  for (auto& entry: m1) {
+    m1.erase(entry.first);
+  }
+  ASSERT_TRUE(m1.empty());
+  ASSERT_TRUE(m1.begin() == m1.end());
+  m1["x"] = "y";
+  ASSERT_EQ(m1.at("x"), "y");
+  auto m2 = m1;
+  ASSERT_EQ(m2.size(), 1);
+}
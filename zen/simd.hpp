@@ -0,0 +1,689 @@
+/// \file simd.hpp
+/// \brief Vectorized search and reduction algorithms for arithmetic ranges.
+///
+/// The algorithms in this file work on any range, but they only switch to
+/// SIMD kernels when the range is backed by a plain array of integers or
+/// floating-point numbers, such as a Vector or an `IterRange<T*>`. In all
+/// other cases, they run a simple loop.
+///
+/// The kernels are written with GCC/Clang vector extensions so that a single
+/// template covers all element types. On x86, the best implementation is
+/// picked at run-time: AVX2 if the CPU supports it and SSE2 otherwise. Other
+/// architectures use 16-byte vectors (which map to NEON on ARM), and
+/// compilers without vector extensions get the scalar fallback.
+///
+/// Note that sum() adds up floating-point numbers in a different order than
+/// a naive loop would, so the result may differ in the last few bits.
+
+#ifndef ZEN_SIMD_HPP
+#define ZEN_SIMD_HPP
+
+#include <stdint.h>
+#include <string.h>
+
+#include <limits>
+#include <type_traits>
+
+#include "zen/config.h"
+#include "zen/maybe.hpp"
+#include "zen/meta.hpp"
+#include "zen/range.hpp"
+
+#if defined(__GNUC__)
+#define ZEN_SIMD_VECTOR_EXTENSIONS 1
+#else
+#define ZEN_SIMD_VECTOR_EXTENSIONS 0
+#endif
+
+#if ZEN_SIMD_VECTOR_EXTENSIONS && (defined(__x86_64__) || defined(__i386__))
+#define ZEN_SIMD_X86 1
+#else
+#define ZEN_SIMD_X86 0
+#endif
+
+ZEN_NAMESPACE_START
+
+/// \brief Whether the SIMD kernels can process elements of type `T`.
+template<typename T>
+struct IsSimdElement : Bool<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>> {};
+
+#if ZEN_SIMD_VECTOR_EXTENSIONS
+
+#define ZEN_SIMD_INLINE inline __attribute__((always_inline))
+
+template<size_t Size>
+struct _SimdLane;
+
+template<> struct _SimdLane<1> { using Type = int8_t; };
+template<> struct _SimdLane<2> { using Type = int16_t; };
+template<> struct _SimdLane<4> { using Type = int32_t; };
+template<> struct _SimdLane<8> { using Type = int64_t; };
+
+// GCC drops vector_size from non-dependent typedefs inside templates, so the
+// word type is routed through T.
+template<typename T>
+struct _SimdWord { using Type = uint64_t; };
+
+// The helpers below take and produce vectors through references, because
+// passing wide vectors by value from code that was not compiled for AVX
+// triggers ABI warnings, even though everything gets inlined.
+template<typename T, size_t Width>
+struct _Simd {
+
+  typedef T Vec __attribute__((vector_size(Width)));
+
+  using Lane = typename _SimdLane<sizeof(T)>::Type;
+
+  typedef Lane Mask __attribute__((vector_size(Width)));
+
+  typedef typename _SimdWord<T>::Type Words __attribute__((vector_size(Width)));
+
+  static constexpr size_t lanes = Width / sizeof(T);
+
+  static ZEN_SIMD_INLINE void load(Vec& out, const T* ptr) {
+    memcpy(&out, ptr, sizeof(Vec));
+  }
+
+  static ZEN_SIMD_INLINE void broadcast(Vec& out, T value) {
+    out = Vec {} + value;
+  }
+
+  static ZEN_SIMD_INLINE bool any(const Mask& mask) {
+    Words words = reinterpret_cast<Words>(mask);
+    uint64_t result = 0;
+    for (size_t i = 0; i < Width / 8; i++) {
+      result |= words[i];
+    }
+    return result != 0;
+  }
+
+};
+
+/// Integers are added up as unsigned numbers, so that overflow wraps around
+/// instead of being undefined.
+template<typename T, bool IsIntegral = std::is_integral_v<T>>
+struct _SimdSum {
+  using Type = T;
+};
+
+template<typename T>
+struct _SimdSum<T, true> {
+  using Type = std::make_unsigned_t<T>;
+};
+
+/// `IsEqual` selects between searching for `value` and searching for
+/// anything but `value`.
+template<size_t Width, bool IsEqual, typename T>
+ZEN_SIMD_INLINE size_t _simd_find_kernel(const T* ptr, size_t count, T value) {
+  using S = _Simd<T, Width>;
+  typename S::Vec needle, chunk;
+  S::broadcast(needle, value);
+  size_t i = 0;
+  for (; i + S::lanes <= count; i += S::lanes) {
+    S::load(chunk, ptr + i);
+    if (S::any(reinterpret_cast<typename S::Mask>(IsEqual ? chunk == needle : chunk != needle))) {
+      break;
+    }
+  }
+  for (; i < count; i++) {
+    if ((ptr[i] == value) == IsEqual) {
+      return i;
+    }
+  }
+  return count;
+}
+
+template<size_t Width, typename T>
+ZEN_SIMD_INLINE size_t _simd_count_kernel(const T* ptr, size_t count, T value) {
+  using S = _Simd<T, Width>;
+  using Lane = typename S::Lane;
+  // Every lane of the accumulator counts up to this many matches before it
+  // has to be flushed, so that narrow lanes cannot overflow.
+  constexpr size_t flush_interval = std::numeric_limits<Lane>::max();
+  typename S::Vec needle, chunk;
+  S::broadcast(needle, value);
+  size_t result = 0;
+  size_t i = 0;
+  while (i + S::lanes <= count) {
+    typename S::Mask matches {};
+    for (size_t k = 0; k < flush_interval && i + S::lanes <= count; k++, i += S::lanes) {
+      S::load(chunk, ptr + i);
+      matches -= reinterpret_cast<typename S::Mask>(chunk == needle);
+    }
+    for (size_t j = 0; j < S::lanes; j++) {
+      result += static_cast<size_t>(matches[j]);
+    }
+  }
+  for (; i < count; i++) {
+    if (ptr[i] == value) {
+      result++;
+    }
+  }
+  return result;
+}
+
+template<size_t Width, typename T>
+ZEN_SIMD_INLINE T _simd_sum_kernel(const T* ptr, size_t count) {
+  using A = typename _SimdSum<T>::Type;
+  using S = _Simd<A, Width>;
+  auto data = reinterpret_cast<const A*>(ptr);
+  typename S::Vec acc {}, chunk;
+  size_t i = 0;
+  for (; i + S::lanes <= count; i += S::lanes) {
+    S::load(chunk, data + i);
+    acc += chunk;
+  }
+  A result = 0;
+  for (size_t j = 0; j < S::lanes; j++) {
+    result += acc[j];
+  }
+  for (auto end = data + count, p = data + i; p != end; ++p) {
+    result += *p;
+  }
+  return T(result);
+}
+
+/// `IsMax` selects between the minimum and the maximum, so that both can
+/// share a single kernel. `count` must be greater than zero.
+///
+/// Every lane starts out with the first element, just like the scalar loop
+/// does. A comparison with NaN is false, so a NaN never replaces a lane, and
+/// a lane only holds NaN if the first element is NaN. This way the result is
+/// the same as that of the scalar loop.
+template<size_t Width, bool IsMax, typename T>
+ZEN_SIMD_INLINE T _simd_extreme_kernel(const T* ptr, size_t count) {
+  using S = _Simd<T, Width>;
+  size_t i = 0;
+  T result = ptr[0];
+  if (count >= S::lanes) {
+    typename S::Vec acc, chunk;
+    S::broadcast(acc, ptr[0]);
+    for (; i + S::lanes <= count; i += S::lanes) {
+      S::load(chunk, ptr + i);
+      if constexpr (IsMax) {
+        acc = acc < chunk ? chunk : acc;
+      } else {
+        acc = chunk < acc ? chunk : acc;
+      }
+    }
+    result = acc[0];
+    for (size_t j = 1; j < S::lanes; j++) {
+      if (IsMax ? result < acc[j] : acc[j] < result) {
+        result = acc[j];
+      }
+    }
+  }
+  for (; i < count; i++) {
+    if (IsMax ? result < ptr[i] : ptr[i] < result) {
+      result = ptr[i];
+    }
+  }
+  return result;
+}
+
+template<size_t Width, typename T>
+ZEN_SIMD_INLINE bool _simd_equal_kernel(const T* a, const T* b, size_t count) {
+  using S = _Simd<T, Width>;
+  typename S::Vec chunk_a, chunk_b;
+  size_t i = 0;
+  for (; i + S::lanes <= count; i += S::lanes) {
+    S::load(chunk_a, a + i);
+    S::load(chunk_b, b + i);
+    if (S::any(reinterpret_cast<typename S::Mask>(chunk_a != chunk_b))) {
+      return false;
+    }
+  }
+  for (; i < count; i++) {
+    if (a[i] != b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ZEN_SIMD_INLINE size_t _simd_popcount_kernel(const uint64_t* ptr, size_t count) {
+  // Independent counters keep several popcount instructions in flight.
+  size_t a = 0, b = 0, c = 0, d = 0;
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    a += __builtin_popcountll(ptr[i]);
+    b += __builtin_popcountll(ptr[i+1]);
+    c += __builtin_popcountll(ptr[i+2]);
+    d += __builtin_popcountll(ptr[i+3]);
+  }
+  for (; i < count; i++) {
+    a += __builtin_popcountll(ptr[i]);
+  }
+  return a + b + c + d;
+}
+
+enum class _BitOp {
+  And,
+  Or,
+  Xor,
+  AndNot,
+};
+
+template<_BitOp Op, typename T>
+ZEN_SIMD_INLINE void _simd_apply_bit_op(T& a, const T& b) {
+  if constexpr (Op == _BitOp::And) {
+    a &= b;
+  } else if constexpr (Op == _BitOp::Or) {
+    a |= b;
+  } else if constexpr (Op == _BitOp::Xor) {
+    a ^= b;
+  } else {
+    a &= ~b;
+  }
+}
+
+template<size_t Width, _BitOp Op>
+ZEN_SIMD_INLINE void _simd_bit_op_kernel(uint64_t* dst, const uint64_t* src, size_t count) {
+  using S = _Simd<uint64_t, Width>;
+  typename S::Vec chunk_dst, chunk_src;
+  size_t i = 0;
+  for (; i + S::lanes <= count; i += S::lanes) {
+    S::load(chunk_dst, dst + i);
+    S::load(chunk_src, src + i);
+    _simd_apply_bit_op<Op>(chunk_dst, chunk_src);
+    memcpy(dst + i, &chunk_dst, sizeof(chunk_dst));
+  }
+  for (; i < count; i++) {
+    _simd_apply_bit_op<Op>(dst[i], src[i]);
+  }
+}
+
+/// Stamp out a set of kernels that are compiled for a specific instruction
+/// set, so that they can be selected at run-time.
+#define ZEN_SIMD_DEFINE_TARGET(suffix, attributes, width) \
+  template<bool IsEqual, typename T> \
+  inline attributes size_t _simd_find_##suffix(const T* ptr, size_t count, T value) { \
+    return _simd_find_kernel<width, IsEqual>(ptr, count, value); \
+  } \
+  template<typename T> \
+  inline attributes size_t _simd_count_##suffix(const T* ptr, size_t count, T value) { \
+    return _simd_count_kernel<width>(ptr, count, value); \
+  } \
+  template<typename T> \
+  inline attributes T _simd_sum_##suffix(const T* ptr, size_t count) { \
+    return _simd_sum_kernel<width>(ptr, count); \
+  } \
+  template<bool IsMax, typename T> \
+  inline attributes T _simd_extreme_##suffix(const T* ptr, size_t count) { \
+    return _simd_extreme_kernel<width, IsMax>(ptr, count); \
+  } \
+  template<typename T> \
+  inline attributes bool _simd_equal_##suffix(const T* a, const T* b, size_t count) { \
+    return _simd_equal_kernel<width>(a, b, count); \
+  } \
+  inline attributes size_t _simd_popcount_##suffix(const uint64_t* ptr, size_t count) { \
+    return _simd_popcount_kernel(ptr, count); \
+  } \
+  template<_BitOp Op> \
+  inline attributes void _simd_bit_op_##suffix(uint64_t* dst, const uint64_t* src, size_t count) { \
+    _simd_bit_op_kernel<width, Op>(dst, src, count); \
+  }
+
+#if ZEN_SIMD_X86
+
+inline bool _simd_has_avx2() {
+  static const bool result = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return result;
+}
+
+ZEN_SIMD_DEFINE_TARGET(sse2, __attribute__((target("sse2"))), 16)
+ZEN_SIMD_DEFINE_TARGET(avx2, __attribute__((target("avx2,popcnt"))), 32)
+
+#define ZEN_SIMD_DISPATCH(name, ...) \
+  (_simd_has_avx2() ? _simd_##name##_avx2 __VA_ARGS__ : _simd_##name##_sse2 __VA_ARGS__)
+
+#else
+
+ZEN_SIMD_DEFINE_TARGET(generic, , 16)
+
+#define ZEN_SIMD_DISPATCH(name, ...) _simd_##name##_generic __VA_ARGS__
+
+#endif // of #if ZEN_SIMD_X86
+
+#undef ZEN_SIMD_DEFINE_TARGET
+#undef ZEN_SIMD_INLINE
+
+#endif // of #if ZEN_SIMD_VECTOR_EXTENSIONS
+
+/// \brief Get the index of the first element in `ptr[0..count)` that is
+/// equal to `value`, or `count` if there is none.
+template<typename T>
+inline size_t simd_find(const T* ptr, size_t count, T value) {
+#if ZEN_SIMD_VECTOR_EXTENSIONS
+  return ZEN_SIMD_DISPATCH(find, <true>(ptr, count, value));
+#else
+  for (size_t i = 0; i < count; i++) {
+    if (ptr[i] == value) {
+      return i;
+    }
+  }
+  return count;
+#endif
+}
+
+/// \brief Get the index of the first element in `ptr[0..count)` that is
+/// different from `value`, or `count` if there is none.
+template<typename T>
+inline size_t simd_find_not(const T* ptr, size_t count, T value) {
+#if ZEN_SIMD_VECTOR_EXTENSIONS
+  return ZEN_SIMD_DISPATCH(find, <false>(ptr, count, value));
+#else
+  for (size_t i = 0; i < count; i++) {
+    if (ptr[i] != value) {
+      return i;
+    }
+  }
+  return count;
+#endif
+}
+
+/// \brief Count the elements in `ptr[0..count)` that are equal to `value`.
+template<typename T>
+inline size_t simd_count(const T* ptr, size_t count, T value) {
+#if ZEN_SIMD_VECTOR_EXTENSIONS
+  return ZEN_SIMD_DISPATCH(count, (ptr, count, value));
+#else
+  size_t result = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (ptr[i] == value) {
+      result++;
+    }
+  }
+  return result;
+#endif
+}
+
+/// \brief Add up all elements in `ptr[0..count)`.
+template<typename T>
+inline T simd_sum(const T* ptr, size_t count) {
+#if ZEN_SIMD_VECTOR_EXTENSIONS
+  return ZEN_SIMD_DISPATCH(sum, (ptr, count));
+#else
+  T result = 0;
+  for (size_t i = 0; i < count; i++) {
+    result += ptr[i];
+  }
+  return result;
+#endif
+}
+
+/// \brief Get the smallest element in `ptr[0..count)`.
+///
+/// `count` must be greater than zero. NaN elements are skipped, unless the
+/// first element is NaN, in which case the result is NaN.
+template<typename T>
+inline T simd_min(const T* ptr, size_t count) {
+  ZEN_ASSERT(count > 0);
+#if ZEN_SIMD_VECTOR_EXTENSIONS
+  return ZEN_SIMD_DISPATCH(extreme, <false>(ptr, count));
+#else
+  T result = ptr[0];
+  for (size_t i = 1; i < count; i++) {
+    if (ptr[i] < result) {
+      result = ptr[i];
+    }
+  }
+  return result;
+#endif
+}
+
+/// \brief Get the largest element in `ptr[0..count)`.
+///
+/// `count` must be greater than zero. NaN elements are skipped, unless the
+/// first element is NaN, in which case the result is NaN.
+template<typename T>
+inline T simd_max(const T* ptr, size_t count) {
+  ZEN_ASSERT(count > 0);
+#if ZEN_SIMD_VECTOR_EXTENSIONS
+  return ZEN_SIMD_DISPATCH(extreme, <true>(ptr, count));
+#else
+  T result = ptr[0];
+  for (size_t i = 1; i < count; i++) {
+    if (result < ptr[i]) {
+      result = ptr[i];
+    }
+  }
+  return result;
+#endif
+}
+
+/// \brief Check whether `a[0..count)` and `b[0..count)` hold the same values.
+template<typename T>
+inline bool simd_equal(const T* a, const T* b, size_t count) {
+#if ZEN_SIMD_VECTOR_EXTENSIONS
+  return ZEN_SIMD_DISPATCH(equal, (a, b, count));
+#else
+  for (size_t i = 0; i < count; i++) {
+    if (a[i] != b[i]) {
+      return false;
+    }
+  }
+  return true;
+#endif
+}
+
+/// \brief Count the bits that are set in `ptr[0..count)`.
+///
+/// On x86, this uses the POPCNT instruction when the CPU supports AVX2.
+inline size_t simd_popcount(const uint64_t* ptr, size_t count) {
+#if ZEN_SIMD_VECTOR_EXTENSIONS
+  return ZEN_SIMD_DISPATCH(popcount, (ptr, count));
+#else
+  size_t result = 0;
+  for (size_t i = 0; i < count; i++) {
+    for (auto word = ptr[i]; word != 0; word &= word - 1) {
+      result++;
+    }
+  }
+  return result;
+#endif
+}
+
+#if ZEN_SIMD_VECTOR_EXTENSIONS
+#define ZEN_SIMD_DEFINE_BIT_OP(name, op, expr) \
+  inline void name(uint64_t* dst, const uint64_t* src, size_t count) { \
+    ZEN_SIMD_DISPATCH(bit_op, <_BitOp::op>(dst, src, count)); \
+  }
+#else
+#define ZEN_SIMD_DEFINE_BIT_OP(name, op, expr) \
+  inline void name(uint64_t* dst, const uint64_t* src, size_t count) { \
+    for (size_t i = 0; i < count; i++) { \
+      dst[i] = expr; \
+    } \
+  }
+#endif
+
+/// \brief Combine the words in `dst[0..count)` with the words in
+/// `src[0..count)` and store the result in `dst`.
+///
+/// simd_and_not() clears every bit in `dst` that is set in `src`.
+ZEN_SIMD_DEFINE_BIT_OP(simd_and, And, dst[i] & src[i])
+ZEN_SIMD_DEFINE_BIT_OP(simd_or, Or, dst[i] | src[i])
+ZEN_SIMD_DEFINE_BIT_OP(simd_xor, Xor, dst[i] ^ src[i])
+ZEN_SIMD_DEFINE_BIT_OP(simd_and_not, AndNot, dst[i] & ~src[i])
+
+#undef ZEN_SIMD_DEFINE_BIT_OP
+#undef ZEN_SIMD_DISPATCH
+
+template<typename RangeT>
+using _RangeIter = decltype(declval<RangeT&>().begin());
+
+template<typename RangeT>
+using _RangeElement = std::remove_cv_t<std::remove_reference_t<decltype(*declval<_RangeIter<RangeT>&>())>>;
+
+/// Whether a range is backed by a plain array that the SIMD kernels can scan.
+template<typename RangeT>
+struct IsSimdRange : Bool<
+  std::is_pointer_v<_RangeIter<RangeT>>
+  && IsSimdElement<_RangeElement<RangeT>>::value
+> {};
+
+/// Convert `value` to the element type `E`, so that the SIMD kernels can
+/// search for it.
+///
+/// Returns `false` if comparing elements with the converted value could give
+/// a different answer than `element == value`, for instance because `value`
+/// does not fit in `E`. The caller must then fall back to a scalar loop.
+template<typename E, typename T>
+inline bool _simd_needle(const T& value, E& needle) {
+  if constexpr (std::is_same_v<E, T>) {
+    needle = value;
+    return true;
+  } else if constexpr (!std::is_arithmetic_v<T>) {
+    return false;
+  } else if constexpr (std::is_floating_point_v<E> && std::is_integral_v<T>) {
+    // The comparison converts `value` to `E` as well.
+    needle = E(value);
+    return true;
+  } else if constexpr (std::is_floating_point_v<E>) {
+    needle = E(value);
+    return sizeof(T) <= sizeof(E) || T(needle) == value;
+  } else if constexpr (std::is_integral_v<T>) {
+    needle = E(value);
+    return T(needle) == value && (needle < E(0)) == (value < T(0));
+  } else {
+    // The comparison converts the elements to a floating-point type, which
+    // may map several integers to the same number.
+    return false;
+  }
+}
+
+/// \brief Get an iterator to the first element that is equal to `value`, or
+/// the end of the range if no element matched.
+template<typename RangeT, typename T>
+inline _RangeIter<RangeT> find(RangeT&& range, const T& value) {
+  if constexpr (IsSimdRange<RangeT>::value) {
+    _RangeElement<RangeT> needle;
+    if (_simd_needle(value, needle)) {
+      auto first = range.begin();
+      return first + simd_find(first, range.end() - first, needle);
+    }
+  }
+  auto end = range.end();
+  for (auto it = range.begin(); it != end; ++it) {
+    if (*it == value) {
+      return it;
+    }
+  }
+  return end;
+}
+
+/// \brief Count the elements that are equal to `value`.
+template<typename RangeT, typename T>
+inline size_t count(RangeT&& range, const T& value) {
+  if constexpr (IsSimdRange<RangeT>::value) {
+    _RangeElement<RangeT> needle;
+    if (_simd_needle(value, needle)) {
+      auto first = range.begin();
+      return simd_count(first, range.end() - first, needle);
+    }
+  }
+  size_t result = 0;
+  for (auto&& element: range) {
+    if (element == value) {
+      result++;
+    }
+  }
+  return result;
+}
+
+/// \brief Add up all elements, starting from zero.
+template<typename RangeT>
+inline _RangeElement<RangeT> sum(RangeT&& range) {
+  if constexpr (IsSimdRange<RangeT>::value) {
+    auto first = range.begin();
+    return simd_sum(first, range.end() - first);
+  } else {
+    _RangeElement<RangeT> result {};
+    for (auto&& element: range) {
+      result += element;
+    }
+    return result;
+  }
+}
+
+/// \brief Get the smallest element, if the range is not empty.
+template<typename RangeT>
+inline Maybe<_RangeElement<RangeT>> min(RangeT&& range) {
+  using T = _RangeElement<RangeT>;
+  auto first = range.begin();
+  auto end = range.end();
+  if (first == end) {
+    return {};
+  }
+  if constexpr (IsSimdRange<RangeT>::value) {
+    return Maybe<T>(simd_min(first, end - first));
+  } else {
+    T result = *first;
+    for (++first; first != end; ++first) {
+      if (*first < result) {
+        result = *first;
+      }
+    }
+    return Maybe<T>(std::move(result));
+  }
+}
+
+/// \brief Get the largest element, if the range is not empty.
+template<typename RangeT>
+inline Maybe<_RangeElement<RangeT>> max(RangeT&& range) {
+  using T = _RangeElement<RangeT>;
+  auto first = range.begin();
+  auto end = range.end();
+  if (first == end) {
+    return {};
+  }
+  if constexpr (IsSimdRange<RangeT>::value) {
+    return Maybe<T>(simd_max(first, end - first));
+  } else {
+    T result = *first;
+    for (++first; first != end; ++first) {
+      if (result < *first) {
+        result = *first;
+      }
+    }
+    return Maybe<T>(std::move(result));
+  }
+}
+
+/// \brief Check whether two ranges contain the same elements in the same
+/// order.
+template<typename RangeT1, typename RangeT2>
+inline bool equal(RangeT1&& a, RangeT2&& b) {
+  if constexpr (
+       IsSimdRange<RangeT1>::value
+    && IsSimdRange<RangeT2>::value
+    && std::is_same_v<_RangeElement<RangeT1>, _RangeElement<RangeT2>>
+  ) {
+    auto first_a = a.begin();
+    auto first_b = b.begin();
+    size_t count = a.end() - first_a;
+    if (count != size_t(b.end() - first_b)) {
+      return false;
+    }
+    return simd_equal(first_a, first_b, count);
+  } else {
+    auto it_a = a.begin();
+    auto end_a = a.end();
+    auto it_b = b.begin();
+    auto end_b = b.end();
+    for (; it_a != end_a && it_b != end_b; ++it_a, ++it_b) {
+      if (!(*it_a == *it_b)) {
+        return false;
+      }
+    }
+    return it_a == end_a && it_b == end_b;
+  }
+}
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_SIMD_HPP
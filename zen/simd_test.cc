@@ -0,0 +1,124 @@
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "zen/dllist.hpp"
+#include "zen/simd.hpp"
+#include "zen/vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+template<typename T>
+Vector<T> make_sequence(size_t count) {
+  Vector<T> result;
+  for (size_t i = 0; i < count; i++) {
+    result.append(T(i % 100));
+  }
+  return result;
+}
+
+template<typename T>
+class SimdTest : public ::testing::Test {};
+
+using SimdElementTypes = ::testing::Types<int8_t, uint8_t, int16_t, int32_t, uint32_t, int64_t, float, double>;
+
+TYPED_TEST_SUITE(SimdTest, SimdElementTypes);
+
+TYPED_TEST(SimdTest, FindsFirstMatch) {
+  for (size_t n: { 0, 1, 7, 33, 100, 1000 }) {
+    auto v = make_sequence<TypeParam>(n);
+    auto it = find(v, 42);
+    if (n > 42) {
+      ASSERT_EQ(it, v.begin() + 42);
+    } else {
+      ASSERT_EQ(it, v.end());
+    }
+    ASSERT_EQ(find(v, 101), v.end());
+  }
+}
+
+TYPED_TEST(SimdTest, CountsMatches) {
+  auto v = make_sequence<TypeParam>(100000);
+  ASSERT_EQ(count(v, 7), 1000);
+  ASSERT_EQ(count(v, 100), 0);
+}
+
+TYPED_TEST(SimdTest, ComputesMinMaxAndSum) {
+  auto v = make_sequence<TypeParam>(1003);
+  v[500] = TypeParam(-3);
+  v[501] = TypeParam(120);
+  TypeParam expected_sum = 0;
+  TypeParam expected_min = v[0];
+  TypeParam expected_max = v[0];
+  for (auto x: v) {
+    expected_sum += x;
+    expected_min = x < expected_min ? x : expected_min;
+    expected_max = expected_max < x ? x : expected_max;
+  }
+  ASSERT_EQ(*min(v), expected_min);
+  ASSERT_EQ(*max(v), expected_max);
+  if constexpr (std::is_integral_v<TypeParam>) {
+    ASSERT_EQ(sum(v), expected_sum);
+  } else {
+    ASSERT_NEAR(sum(v), expected_sum, 1e-3);
+  }
+  Vector<TypeParam> empty;
+  ASSERT_TRUE(min(empty).is_empty());
+}
+
+TYPED_TEST(SimdTest, ComparesRanges) {
+  auto a = make_sequence<TypeParam>(1000);
+  auto b = make_sequence<TypeParam>(1000);
+  ASSERT_TRUE(equal(a, b));
+  b[999] = TypeParam(1);
+  ASSERT_FALSE(equal(a, b));
+  ASSERT_FALSE(equal(a, make_iter_range(a.begin(), a.end() - 1)));
+}
+
+TEST(SimdTest, SkipsNaNInMinMax) {
+  constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+  Vector<double> v1 { 1, nan, 3, 4, 0, 100, 5, 6, 7, -50, 8, 9, 10, 11, 12, 13, 14 };
+  ASSERT_EQ(*max(v1), 100);
+  ASSERT_EQ(*min(v1), -50);
+  Vector<float> v2;
+  for (int i = 0; i < 100; i++) {
+    v2.append(i % 3 == 1 ? std::numeric_limits<float>::quiet_NaN() : float(i));
+  }
+  ASSERT_EQ(*max(v2), 99);
+  ASSERT_EQ(*min(v2), 0);
+  v2[0] = std::numeric_limits<float>::quiet_NaN();
+  ASSERT_TRUE(std::isnan(*max(v2)));
+  ASSERT_TRUE(std::isnan(*min(v2)));
+}
+
+TEST(SimdTest, ComparesValuesOfOtherTypesLikeScalarLoop) {
+  Vector<int> v1 { 1, 2, 3 };
+  ASSERT_EQ(find(v1, 3.5), v1.end());
+  ASSERT_EQ(find(v1, 3.0), v1.begin() + 2);
+  ASSERT_EQ(find(v1, int64_t(3) + (int64_t(1) << 32)), v1.end());
+  ASSERT_EQ(count(v1, 2L), 1);
+  Vector<uint8_t> v2 { 0, 0, 1, 255 };
+  ASSERT_EQ(count(v2, 256), 0);
+  ASSERT_EQ(count(v2, -1), 0);
+  ASSERT_EQ(count(v2, 0), 2);
+  ASSERT_EQ(find(v2, 255), v2.begin() + 3);
+  Vector<int8_t> v3 { -1, 1 };
+  ASSERT_EQ(count(v3, 255), 0);
+  ASSERT_EQ(count(v3, -1L), 1);
+  Vector<float> v4 { 0.1f, 0.5f };
+  ASSERT_EQ(find(v4, 0.1), v4.end());
+  ASSERT_EQ(find(v4, 0.5), v4.begin() + 1);
+  ASSERT_EQ(count(v4, 0), 0);
+}
+
+TEST(SimdTest, FallsBackForOtherRanges) {
+  DLList<std::string> l1;
+  l1.append("a");
+  l1.append("b");
+  l1.append("c");
+  ASSERT_EQ(count(l1, "a"), 1);
+  ASSERT_EQ(*find(l1, "b"), "b");
+}
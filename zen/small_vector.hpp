@@ -0,0 +1,357 @@
+/// \file small_vector.hpp
+/// \brief A vector that stores its first few elements inside the object itself.
+
+#ifndef ZEN_SMALL_VECTOR_HPP
+#define ZEN_SMALL_VECTOR_HPP
+
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+#include "zen/macros.h"
+#include "zen/vector.hpp"
+
+ZEN_NAMESPACE_START
+
+/// \brief A Vector that keeps up to `N` elements inline.
+///
+/// As long as no more than `N` elements are stored, no memory is requested
+/// from the allocator. When the inline buffer overflows, the elements are
+/// relocated to the heap and the container behaves like a regular Vector from
+/// then on.
+///
+/// Apart from constructing it with an initial capacity, SmallVector offers
+/// the same methods as Vector, so it can replace a Vector that usually holds
+/// a short sequence, such as an argument list or a list of child nodes.
+template<
+  typename T,
+  size_t N,
+  typename SizeT = size_t,
+  typename AllocatorT = DefaultAllocator<T>,
+  typename GrowthT = DefaultGrowth
+>
+class SmallVector {
+public:
+
+  using Value = T;
+  using Size = SizeT;
+  using Iter = T*;
+
+  using value_type = T;
+  using size_type = SizeT;
+
+private:
+
+  static_assert(N > 0, "a SmallVector must have room for at least one inline element");
+
+  template<typename VectorT, typename RangeT>
+  friend typename VectorT::Iter _insert_range(VectorT& vector, typename VectorT::Size index, RangeT& range);
+
+  AllocatorT _allocator;
+  SizeT _capacity;
+  SizeT _sz;
+  T* _ptr;
+  alignas(T) unsigned char _inline[N * sizeof(T)];
+
+  inline T* inline_ptr() {
+    return reinterpret_cast<T*>(_inline);
+  }
+
+  inline void destroy_all() {
+    for (SizeT i = 0; i < _sz; i++) {
+      _ptr[i].~T();
+    }
+    if (!is_inline()) {
+      _allocator.free(_ptr, _capacity);
+    }
+  }
+
+  /// Resize the heap buffer in place with the allocator's reallocate(), if
+  /// it has one. Returns `false` if the elements still need to be relocated.
+  inline bool try_reallocate(SizeT new_capacity) {
+    if constexpr (CanReallocate<AllocatorT, T>::value) {
+      if (!is_inline()) {
+        auto new_ptr = _allocator.reallocate(_ptr, _capacity, new_capacity);
+        if (new_ptr != nullptr) {
+          _ptr = new_ptr;
+          _capacity = new_capacity;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /// Move all elements to a new heap buffer of exactly `new_capacity`
+  /// elements.
+  inline void relocate(SizeT new_capacity) {
+    open_gap(_sz, 0, new_capacity);
+  }
+
+  /// Make room for `count` elements at `index`, moving the elements after it
+  /// to the back. If the elements do not fit, they are moved to a heap
+  /// buffer of `new_capacity` elements. The returned slots are uninitialized
+  /// and must be filled before `_sz` is increased.
+  inline T* open_gap(SizeT index, SizeT count, SizeT new_capacity) {
+    ZEN_ASSERT(index <= _sz);
+    if (_capacity < new_capacity && !try_reallocate(new_capacity)) {
+      auto new_ptr = _allocator.allocate(new_capacity);
+      ZEN_ASSERT(new_ptr != nullptr);
+      relocate_n(_ptr, index, new_ptr);
+      relocate_n(_ptr + index, _sz - index, new_ptr + index + count);
+      if (!is_inline()) {
+        _allocator.free(_ptr, _capacity);
+      }
+      _ptr = new_ptr;
+      _capacity = new_capacity;
+      return _ptr + index;
+    }
+    shift_back_n(_ptr + index, _sz - index, count);
+    return _ptr + index;
+  }
+
+  inline T* open_gap(SizeT index, SizeT count) {
+    auto new_capacity = _capacity < _sz + count ? GrowthT::next_capacity(_capacity, _sz + count) : _capacity;
+    return open_gap(index, count, new_capacity);
+  }
+
+  /// Take over the elements of `other`, which must be empty afterwards.
+  inline void steal(SmallVector& other) {
+    if (other.is_inline()) {
+      relocate_n(other._ptr, other._sz, _ptr);
+    } else {
+      _ptr = other._ptr;
+      _capacity = other._capacity;
+      other._ptr = other.inline_ptr();
+      other._capacity = N;
+    }
+    _sz = other._sz;
+    other._sz = 0;
+  }
+
+public:
+
+  template<
+    typename RangeT,
+    typename = std::enable_if_t<IsRange<std::decay_t<RangeT>>::value && !std::is_same_v<std::decay_t<RangeT>, SmallVector>>
+  >
+  SmallVector(RangeT&& range, AllocatorT allocator = AllocatorT()):
+    SmallVector(allocator) {
+      append_range(range);
+    }
+
+  inline SmallVector(AllocatorT allocator = AllocatorT()):
+    _allocator(allocator),
+    _capacity(N),
+    _sz(0),
+    _ptr(inline_ptr()) {}
+
+  inline SmallVector(std::initializer_list<T> elements, AllocatorT allocator = AllocatorT()):
+    SmallVector(allocator) {
+      ensure_capacity(elements.size());
+      for (auto& element: elements) {
+        new (_ptr + _sz++) T(element);
+      }
+    }
+
+  inline SmallVector(const SmallVector& other):
+    SmallVector(other._allocator) {
+      ensure_capacity(other._sz);
+      for (SizeT i = 0; i < other._sz; i++) {
+        new (_ptr + i) T(other._ptr[i]);
+      }
+      _sz = other._sz;
+    }
+
+  inline SmallVector(SmallVector&& other):
+    SmallVector(std::move(other._allocator)) {
+      steal(other);
+    }
+
+  inline SmallVector& operator=(const SmallVector& other) {
+    if (this != &other) {
+      SmallVector copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  inline SmallVector& operator=(SmallVector&& other) {
+    if (this != &other) {
+      destroy_all();
+      _allocator = std::move(other._allocator);
+      _ptr = inline_ptr();
+      _capacity = N;
+      steal(other);
+    }
+    return *this;
+  }
+
+  inline ~SmallVector() {
+    destroy_all();
+  }
+
+  inline void swap(SmallVector& other) {
+    SmallVector keep(std::move(other));
+    other = std::move(*this);
+    *this = std::move(keep);
+  }
+
+  /// \brief Check whether the elements are still stored inside this object.
+  inline bool is_inline() const {
+    return _ptr == reinterpret_cast<const T*>(_inline);
+  }
+
+  /// \brief Make sure at least `new_capacity` elements fit in this vector
+  /// without reallocating, growing the buffer according to `GrowthT`.
+  inline void ensure_capacity(SizeT new_capacity) {
+    if (_capacity < new_capacity) {
+      relocate(GrowthT::next_capacity(_capacity, new_capacity));
+    }
+  }
+
+  /// \brief Make sure exactly `new_capacity` elements fit in this vector
+  /// without reallocating.
+  inline void reserve(SizeT new_capacity) {
+    if (_capacity < new_capacity) {
+      relocate(new_capacity);
+    }
+  }
+
+  /// \brief Change the amount of elements in this vector.
+  ///
+  /// New elements are value-initialized. Excess elements are destroyed, but
+  /// the capacity of the vector is left untouched.
+  inline void resize(SizeT new_sz) {
+    if (new_sz < _sz) {
+      for (SizeT i = new_sz; i < _sz; i++) {
+        _ptr[i].~T();
+      }
+    } else {
+      ensure_capacity(new_sz);
+      for (SizeT i = _sz; i < new_sz; i++) {
+        new (_ptr + i) T();
+      }
+    }
+    _sz = new_sz;
+  }
+
+  /// \brief Change the amount of elements in this vector, copying `value`
+  /// into each new slot.
+  inline void resize(SizeT new_sz, const T& value) {
+    if (new_sz < _sz) {
+      for (SizeT i = new_sz; i < _sz; i++) {
+        _ptr[i].~T();
+      }
+    } else {
+      // `value` might live inside this vector
+      T keep = value;
+      ensure_capacity(new_sz);
+      for (SizeT i = _sz; i < new_sz; i++) {
+        new (_ptr + i) T(keep);
+      }
+    }
+    _sz = new_sz;
+  }
+
+  /// \brief Change the amount of elements in this vector without
+  /// initializing the new ones.
+  inline void resize_uninitialized(SizeT new_sz) {
+    static_assert(std::is_trivial_v<T>, "resize_uninitialized() requires a trivial element type");
+    ensure_capacity(new_sz);
+    _sz = new_sz;
+  }
+
+  inline T& operator[](SizeT index) {
+    ZEN_ASSERT(index >= 0 && index < _sz);
+    return _ptr[index];
+  }
+
+  /// \brief Construct a new element at the end of this vector, forwarding
+  /// `args` to its constructor.
+  template<typename ...ForwardArgs>
+  inline T& emplace_back(ForwardArgs&& ...args) {
+    if (_capacity < _sz + 1) {
+      // Construct the new element before relocating, because the arguments
+      // might refer to elements in the old buffer.
+      T element(std::forward<ForwardArgs>(args)...);
+      ensure_capacity(_sz + 1);
+      new (_ptr + _sz) T(std::move(element));
+    } else {
+      new (_ptr + _sz) T(std::forward<ForwardArgs>(args)...);
+    }
+    return _ptr[_sz++];
+  }
+
+  inline void append(const T& element) {
+    emplace_back(element);
+  }
+
+  inline void append(T&& element) {
+    emplace_back(std::move(element));
+  }
+
+  /// \brief Copy all elements of `range` to the end of this vector.
+  ///
+  /// The vector is reallocated at most once.
+  template<typename RangeT>
+  inline void append_range(RangeT&& range) {
+    insert(end(), range);
+  }
+
+  /// \brief Copy all elements of `range` into this vector, right before `pos`.
+  ///
+  /// The vector is reallocated at most once. Returns an iterator to the
+  /// first inserted element. `range` may refer to elements of this vector.
+  template<typename RangeT>
+  inline Iter insert(Iter pos, RangeT&& range) {
+    static_assert(IsRange<std::decay_t<RangeT>>::value, "insert() expects a range of elements");
+    ZEN_ASSERT(pos >= begin() && pos <= end());
+    return _insert_range(*this, SizeT(pos - _ptr), range);
+  }
+
+  inline void prepend(T element) {
+    new (open_gap(0, 1)) T(std::move(element));
+    _sz++;
+  }
+
+  inline SizeT capacity() const {
+    return _capacity;
+  }
+
+  inline T* data() {
+    return _ptr;
+  }
+
+  inline const T* data() const {
+    return _ptr;
+  }
+
+  inline Iter begin() {
+    return _ptr;
+  }
+
+  inline const T* begin() const {
+    return _ptr;
+  }
+
+  inline Iter end() {
+    return _ptr + _sz;
+  }
+
+  inline const T* end() const {
+    return _ptr + _sz;
+  }
+
+  inline SizeT size() const {
+    return _sz;
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_SMALL_VECTOR_HPP
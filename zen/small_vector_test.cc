@@ -0,0 +1,134 @@
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "zen/small_vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+namespace {
+
+std::size_t allocation_count = 0;
+
+template<typename T>
+class CountingAllocator {
+public:
+
+  inline T* allocate(size_t sz) {
+    allocation_count++;
+    return static_cast<T*>(malloc(sz * sizeof(T)));
+  }
+
+  inline void free(T* ptr, size_t sz) {
+    ::free(ptr);
+  }
+
+};
+
+} // of anonymous namespace
+
+TEST(SmallVectorTest, DoesNotAllocateWhenInline) {
+  allocation_count = 0;
+  SmallVector<int, 4, size_t, CountingAllocator<int>> v1;
+  v1.append(2);
+  v1.append(3);
+  v1.prepend(1);
+  v1.append(4);
+  ASSERT_TRUE(v1.is_inline());
+  ASSERT_EQ(allocation_count, 0);
+  ASSERT_EQ(v1.size(), 4);
+  ASSERT_EQ(v1[0], 1);
+  ASSERT_EQ(v1[1], 2);
+  ASSERT_EQ(v1[2], 3);
+  ASSERT_EQ(v1[3], 4);
+}
+
+TEST(SmallVectorTest, MovesToHeapOnOverflow) {
+  allocation_count = 0;
+  SmallVector<int, 2, size_t, CountingAllocator<int>> v1;
+  for (int i = 0; i < 100; i++) {
+    v1.append(i);
+  }
+  ASSERT_FALSE(v1.is_inline());
+  ASSERT_LE(allocation_count, 10);
+  int k = 0;
+  for (auto i: v1) {
+    ASSERT_EQ(i, k++);
+  }
+  ASSERT_EQ(k, 100);
+}
+
+TEST(SmallVectorTest, CanCopyAndMove) {
+  SmallVector<std::string, 2> v1 { "foo", "bar" };
+  SmallVector<std::string, 2> v2(v1);
+  SmallVector<std::string, 2> v3(std::move(v1));
+  ASSERT_EQ(v1.size(), 0);
+  ASSERT_EQ(v2.size(), 2);
+  ASSERT_EQ(v3[0], "foo");
+  ASSERT_EQ(v3[1], "bar");
+  v3.append("baz");
+  v2 = std::move(v3);
+  ASSERT_FALSE(v2.is_inline());
+  ASSERT_EQ(v2.size(), 3);
+  ASSERT_EQ(v2[2], "baz");
+  ASSERT_TRUE(v3.is_inline());
+  ASSERT_EQ(v3.size(), 0);
+}
+
+TEST(SmallVectorTest, CanEmplaceAndInsertRanges) {
+  std::string input[] = { "b", "c", "d" };
+  SmallVector<std::string, 4> v1;
+  v1.emplace_back(3, 'a');
+  v1.emplace_back("e");
+  auto pos = v1.insert(v1.begin() + 1, make_iter_range(input, input + 2));
+  ASSERT_EQ(*pos, "b");
+  ASSERT_TRUE(v1.is_inline());
+  v1.insert(v1.begin() + 3, make_iter_range(input + 2, input + 3));
+  ASSERT_FALSE(v1.is_inline());
+  ASSERT_EQ(v1.size(), 5);
+  ASSERT_EQ(v1[0], "aaa");
+  ASSERT_EQ(v1[1], "b");
+  ASSERT_EQ(v1[2], "c");
+  ASSERT_EQ(v1[3], "d");
+  ASSERT_EQ(v1[4], "e");
+  for (int i = 0; i < 10; i++) {
+    v1.emplace_back(v1[0]);
+  }
+  ASSERT_EQ(v1[14], "aaa");
+  SmallVector<std::string, 2> v2(make_iter_range(input, input + 3));
+  ASSERT_EQ(v2.size(), 3);
+  ASSERT_EQ(v2[2], "d");
+}
+
+TEST(SmallVectorTest, CanReserveAndResize) {
+  allocation_count = 0;
+  SmallVector<int, 4, size_t, CountingAllocator<int>> v1;
+  v1.resize(3, 7);
+  ASSERT_TRUE(v1.is_inline());
+  ASSERT_EQ(v1[2], 7);
+  v1.resize(1);
+  ASSERT_EQ(v1.size(), 1);
+  v1.reserve(20);
+  ASSERT_EQ(allocation_count, 1);
+  ASSERT_EQ(v1.capacity(), 20);
+  ASSERT_EQ(v1[0], 7);
+  v1.resize(20);
+  ASSERT_EQ(allocation_count, 1);
+  ASSERT_EQ(v1[19], 0);
+  v1.resize_uninitialized(30);
+  ASSERT_EQ(v1.size(), 30);
+  ASSERT_EQ(allocation_count, 2);
+}
+
+TEST(SmallVectorTest, CanInsertRangeOfItself) {
+  SmallVector<std::string, 4> v1 { "a", "b" };
+  v1.insert(v1.begin(), make_iter_range(v1.begin(), v1.end()));
+  ASSERT_TRUE(v1.is_inline());
+  v1.append_range(v1);
+  ASSERT_FALSE(v1.is_inline());
+  ASSERT_EQ(v1.size(), 8);
+  for (int i = 0; i < 8; i++) {
+    ASSERT_EQ(v1[i], i % 2 == 0 ? "a" : "b");
+  }
+}
@@ -0,0 +1,208 @@
+/// \file soa_vector.hpp
+/// \brief A vector of records that stores each field in its own array.
+
+#ifndef ZEN_SOA_VECTOR_HPP
+#define ZEN_SOA_VECTOR_HPP
+
+#include <utility>
+
+#include "zen/config.h"
+#include "zen/meta.hpp"
+#include "zen/range.hpp"
+#include "zen/tuple.hpp"
+#include "zen/vector.hpp"
+
+ZEN_NAMESPACE_START
+
+template<typename ...Ts>
+class SoAVector;
+
+template<typename ...Ts>
+class SoAIter {
+
+  SoAVector<Ts...>* soa;
+  size_t index;
+
+public:
+
+  using Value = Tuple<Ts...>;
+  using Ref = Tuple<Ts&...>;
+  using Size = size_t;
+  using Diff = ptrdiff_t;
+
+  using value_type = Value;
+
+  inline SoAIter(SoAVector<Ts...>* soa, size_t index):
+    soa(soa), index(index) {}
+
+  bool operator==(const SoAIter& other) const {
+    return other.soa == soa && other.index == index;
+  }
+
+  bool operator!=(const SoAIter& other) const {
+    return !(*this == other);
+  }
+
+  Ref operator*() {
+    return (*soa)[index];
+  }
+
+  SoAIter& operator++() {
+    index++;
+    return *this;
+  }
+
+  SoAIter operator+(Diff offset) const {
+    return SoAIter(soa, index + offset);
+  }
+
+  Diff operator-(const SoAIter& other) const {
+    return Diff(index) - Diff(other.index);
+  }
+
+};
+
+/// \brief A sequence of records where every field lives in a separate,
+/// contiguous array.
+///
+/// Scans that only touch a few fields of a wide record only have to load
+/// those fields into the cache, and loops over a single column work on a
+/// plain array that the compiler can vectorize. Use column() to get such an
+/// array.
+///
+/// Indexing the vector returns a `Tuple` of references into each column, so
+/// that a single record can still be read and updated as a whole:
+///
+/// ```
+/// SoAVector<int, double> points;
+/// points.append(1, 2.5);
+/// get<1>(points[0]) *= 2;
+/// ```
+template<typename ...Ts>
+class SoAVector {
+public:
+
+  using Value = Tuple<Ts...>;
+  using Ref = Tuple<Ts&...>;
+  using Size = size_t;
+  using Iter = SoAIter<Ts...>;
+  using Range = IterRange<Iter>;
+
+  using value_type = Value;
+  using size_type = Size;
+
+  /// The type of the field at position `I`.
+  template<size_t I>
+  using Field = typename TypePackElement<I, Ts...>::Type;
+
+private:
+
+  static_assert(sizeof...(Ts) > 0, "a SoAVector needs at least one field");
+
+  using Indices = Ascending<size_t, sizeof...(Ts)>;
+
+  Tuple<Vector<Ts>...> _columns;
+  size_t _sz;
+
+  template<size_t ...Is, typename ...ForwardArgs>
+  inline void append_impl(Seq<size_t, Is...>, ForwardArgs&& ...args) {
+    (get<Is>(_columns).emplace_back(std::forward<ForwardArgs>(args)), ...);
+  }
+
+  template<size_t ...Is>
+  inline void append_impl(Seq<size_t, Is...>, const Value& record) {
+    (get<Is>(_columns).emplace_back(get<Is>(record)), ...);
+  }
+
+  template<size_t ...Is>
+  inline Ref at_impl(Seq<size_t, Is...>, size_t index) {
+    return Ref(get<Is>(_columns)[index]...);
+  }
+
+  template<size_t ...Is>
+  inline void reserve_impl(Seq<size_t, Is...>, size_t capacity) {
+    (get<Is>(_columns).reserve(capacity), ...);
+  }
+
+  template<size_t ...Is>
+  inline void resize_impl(Seq<size_t, Is...>, size_t new_sz) {
+    (get<Is>(_columns).resize(new_sz), ...);
+  }
+
+public:
+
+  inline SoAVector():
+    _sz(0) {}
+
+  /// \brief Add a new record to the end of this vector.
+  ///
+  /// Every argument is forwarded to the constructor of the corresponding
+  /// field.
+  template<
+    typename ...ForwardArgs,
+    typename = EnableIfT<
+      sizeof...(ForwardArgs) == sizeof...(Ts)
+      && !_IsTupleSelf<Value, ForwardArgs...>::value
+    >
+  >
+  inline void append(ForwardArgs&& ...args) {
+    append_impl(Indices(), std::forward<ForwardArgs>(args)...);
+    _sz++;
+  }
+
+  inline void append(const Value& record) {
+    append_impl(Indices(), record);
+    _sz++;
+  }
+
+  /// \brief Get references to all fields of the record at `index`.
+  inline Ref operator[](size_t index) {
+    ZEN_ASSERT(index < _sz);
+    return at_impl(Indices(), index);
+  }
+
+  /// \brief Get a pointer to the contiguous array holding field `I`.
+  template<size_t I>
+  inline Field<I>* data() {
+    return get<I>(_columns).data();
+  }
+
+  /// \brief Get the values of field `I` for all records.
+  template<size_t I>
+  inline IterRange<Field<I>*> column() {
+    auto& column = get<I>(_columns);
+    return make_iter_range(column.begin(), column.end());
+  }
+
+  inline void reserve(size_t capacity) {
+    reserve_impl(Indices(), capacity);
+  }
+
+  /// \brief Change the amount of records, value-initializing every field of
+  /// the new ones.
+  inline void resize(size_t new_sz) {
+    resize_impl(Indices(), new_sz);
+    _sz = new_sz;
+  }
+
+  inline size_t size() const {
+    return _sz;
+  }
+
+  inline Range range() {
+    return make_iter_range(begin(), end());
+  }
+
+  inline Iter begin() {
+    return Iter(this, 0);
+  }
+
+  inline Iter end() {
+    return Iter(this, _sz);
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_SOA_VECTOR_HPP
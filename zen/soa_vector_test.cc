@@ -0,0 +1,39 @@
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "zen/soa_vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(SoAVectorTest, StoresFieldsInSeparateArrays) {
+  SoAVector<int, double, std::string> v1;
+  v1.append(1, 1.5, "one");
+  v1.append(2, 2.5, "two");
+  v1.append(Tuple<int, double, std::string>(3, 3.5, "three"));
+  ASSERT_EQ(v1.size(), 3);
+  ASSERT_EQ(v1.data<0>()[2], 3);
+  ASSERT_EQ(v1.data<1>() + 1, &get<1>(v1[1]));
+  int sum = 0;
+  for (auto i: v1.column<0>()) {
+    sum += i;
+  }
+  ASSERT_EQ(sum, 6);
+}
+
+TEST(SoAVectorTest, CanUpdateThroughProxy) {
+  SoAVector<int, std::string> v1;
+  for (int i = 0; i < 100; i++) {
+    v1.append(i, std::to_string(i));
+  }
+  get<0>(v1[42]) = -1;
+  auto [n, s] = v1[42];
+  ASSERT_EQ(n, -1);
+  ASSERT_EQ(s, "42");
+  int k = 0;
+  for (auto record: v1) {
+    ASSERT_EQ(get<1>(record), std::to_string(k++));
+  }
+  ASSERT_EQ(k, 100);
+}
@@ -1,8 +1,7 @@
 #ifndef ZEN_STREAM_HPP
 #define ZEN_STREAM_HPP
 
-#include <deque>
-
+#include "zen/deque.hpp"
 #include "zen/meta.hpp"
 #include "zen/maybe.hpp"
 
@@ -38,32 +37,30 @@ public:
 template<typename T, typename SizeT = std::size_t>
 class BufferedStream : public PeekStream<T, SizeT> {
 
-  std::deque<T> buffer;
+  Deque<T, SizeT> buffer;
 
 public:
 
   /// @brief Get the next token in the underlying stream
   ///
   /// This method should be implemented by users deriving from this class.
-  virtual Maybe<T> read();
+  virtual Maybe<T> read() = 0;
 
   inline Maybe<T> get() override {
-    if (buffer.empty()) {
+    if (buffer.is_empty()) {
       return read();
     } else {
-      auto token = buffer.front();
-      buffer.pop_front();
-      return some(token);
+      return some(buffer.pop_first());
     }
   }
 
   inline Maybe<T> peek(SizeT offset) override {
     while (buffer.size() < offset) {
       auto token = read();
-      if (is_empty(token)) {
+      if (token.is_empty()) {
         return {};
       }
-      buffer.push_back(token);
+      buffer.append(*token);
     }
     return some(buffer[offset-1]);
   }
@@ -0,0 +1,359 @@
+/// \file thread_caching_allocator.hpp
+/// \brief A general-purpose allocator that scales with the number of threads.
+///
+/// The design follows tcmalloc:
+///
+///  - **Size classes.** Requests are rounded up to one of a fixed set of
+///    sizes: multiples of 16 bytes up to 1 KiB, and then four classes per
+///    power of two up to 256 KiB. Larger requests are mapped directly from
+///    the kernel.
+///  - **Thread caches.** Every thread keeps a free list per size class, so
+///    most allocations and frees touch no shared state at all.
+///  - **A central heap.** When a thread cache runs empty, it takes a batch of
+///    objects from the central free list of that class, which is protected
+///    by a spinlock. When it holds too many, it gives a batch back. The
+///    central heap carves new objects from spans that it maps from the
+///    kernel.
+///
+/// Since callers pass the size of a block to free(), blocks carry no header
+/// and the size class is computed again on free.
+///
+/// The allocator only needs `mmap` from the system. It does not call
+/// `malloc` and needs no runtime support for thread-local destructors or
+/// static initialization guards, so it can serve as the DefaultAllocator of
+/// builds with `-nostdlib`. Choose it with the `allocator` build option.
+
+#ifndef ZEN_THREAD_CACHING_ALLOCATOR_HPP
+#define ZEN_THREAD_CACHING_ALLOCATOR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include <atomic>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+#include "zen/macros.h"
+
+ZEN_NAMESPACE_START
+
+inline constexpr size_t _tc_page_size = 4096;
+inline constexpr size_t _tc_max_small_size = 256 * 1024;
+inline constexpr size_t _tc_class_count = 97;
+
+/// Size of the regions that spans are cut from.
+inline constexpr size_t _tc_region_size = 4 * 1024 * 1024;
+
+/// Get the size class of a request of `bytes` bytes, where
+/// `0 < bytes <= _tc_max_small_size`.
+inline size_t _tc_size_class(size_t bytes) {
+  if (bytes <= 1024) {
+    return (bytes + 15) / 16;
+  }
+  size_t k = 63 - __builtin_clzll(bytes - 1);
+  size_t sub = (bytes - 1 - (size_t(1) << k)) >> (k - 2);
+  return 65 + (k - 10) * 4 + sub;
+}
+
+/// Get the size of the objects of the size class `c`.
+inline constexpr size_t _tc_class_size(size_t c) {
+  if (c <= 64) {
+    return c * 16;
+  }
+  size_t k = 10 + (c - 65) / 4;
+  size_t sub = (c - 65) % 4;
+  return (size_t(1) << k) + (sub + 1) * (size_t(1) << (k - 2));
+}
+
+/// Get the amount of objects that move between a thread cache and the
+/// central heap at once.
+inline constexpr size_t _tc_batch_size(size_t c) {
+  size_t count = 64 * 1024 / _tc_class_size(c);
+  return count < 2 ? 2 : (count > 32 ? 32 : count);
+}
+
+inline void* _tc_map(size_t size) {
+  auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+struct _TCObject {
+  _TCObject* next;
+};
+
+class _TCSpinLock {
+
+  std::atomic_flag _flag = ATOMIC_FLAG_INIT;
+
+public:
+
+  inline void lock() {
+    while (_flag.test_and_set(std::memory_order_acquire)) {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+  }
+
+  inline void unlock() {
+    _flag.clear(std::memory_order_release);
+  }
+
+};
+
+/// The shared free list of one size class.
+struct _TCCentralList {
+  _TCSpinLock lock;
+  _TCObject* head = nullptr;
+  char* bump = nullptr;
+  char* bump_end = nullptr;
+};
+
+/// Everything that is shared between threads. It is constant-initialized and
+/// never destroyed, so it can be used from any static constructor or
+/// destructor.
+struct _TCCentralHeap {
+
+  _TCCentralList lists[_tc_class_count];
+
+  _TCSpinLock region_lock;
+  char* region = nullptr;
+  char* region_end = nullptr;
+
+  /// Get a new span of `size` bytes, a multiple of the page size.
+  inline char* new_span(size_t size) {
+    if (size >= _tc_region_size) {
+      return static_cast<char*>(_tc_map(size));
+    }
+    region_lock.lock();
+    if (region == nullptr || size_t(region_end - region) < size) {
+      region = static_cast<char*>(_tc_map(_tc_region_size));
+      region_end = region == nullptr ? nullptr : region + _tc_region_size;
+    }
+    char* span = nullptr;
+    if (region != nullptr) {
+      span = region;
+      region += size;
+    }
+    region_lock.unlock();
+    return span;
+  }
+
+  /// Take up to `count` objects of class `c` and return how many were
+  /// taken. They are linked from `head` to `tail`.
+  inline size_t take(size_t c, size_t count, _TCObject*& head, _TCObject*& tail) {
+    auto& list = lists[c];
+    auto object_size = _tc_class_size(c);
+    size_t taken = 0;
+    head = tail = nullptr;
+    list.lock.lock();
+    while (taken < count && list.head != nullptr) {
+      auto object = list.head;
+      list.head = object->next;
+      object->next = head;
+      head = object;
+      if (tail == nullptr) {
+        tail = object;
+      }
+      taken++;
+    }
+    if (taken < count && list.bump == list.bump_end) {
+      auto span_size = object_size * 8 > 64 * 1024 ? object_size * 8 : 64 * 1024;
+      span_size = (span_size + _tc_page_size - 1) & ~(_tc_page_size - 1);
+      auto span = new_span(span_size);
+      if (span != nullptr) {
+        list.bump = span;
+        list.bump_end = span + span_size / object_size * object_size;
+      }
+    }
+    while (taken < count && list.bump != list.bump_end) {
+      auto object = reinterpret_cast<_TCObject*>(list.bump);
+      list.bump += object_size;
+      object->next = head;
+      head = object;
+      if (tail == nullptr) {
+        tail = object;
+      }
+      taken++;
+    }
+    list.lock.unlock();
+    return taken;
+  }
+
+  inline void give(size_t c, _TCObject* head, _TCObject* tail) {
+    auto& list = lists[c];
+    list.lock.lock();
+    tail->next = list.head;
+    list.head = head;
+    list.lock.unlock();
+  }
+
+};
+
+inline _TCCentralHeap _tc_central_heap;
+
+struct _TCFreeList {
+  _TCObject* head;
+  size_t count;
+};
+
+/// The per-thread part of the allocator. It is trivially destructible, so
+/// that it does not depend on the C++ runtime to run destructors of
+/// thread-local variables.
+struct _TCThreadCache {
+  _TCFreeList lists[_tc_class_count];
+  bool reaper_registered;
+};
+
+inline thread_local _TCThreadCache _tc_thread_cache;
+
+/// Return all objects of the thread cache of the calling thread to the
+/// central heap.
+inline void _tc_flush_thread_cache() {
+  auto& cache = _tc_thread_cache;
+  for (size_t c = 1; c < _tc_class_count; c++) {
+    auto& list = cache.lists[c];
+    if (list.head == nullptr) {
+      continue;
+    }
+    auto tail = list.head;
+    while (tail->next != nullptr) {
+      tail = tail->next;
+    }
+    _tc_central_heap.give(c, list.head, tail);
+    list.head = nullptr;
+    list.count = 0;
+  }
+}
+
+#if ZEN_STL
+
+/// Flushes the thread cache when its thread exits. Without the standard
+/// library, the objects in the cache of an exited thread stay there, which
+/// is bounded by two batches per size class.
+struct _TCThreadReaper {
+  inline ~_TCThreadReaper() {
+    _tc_flush_thread_cache();
+  }
+};
+
+#endif
+
+inline void _tc_register_thread() {
+#if ZEN_STL
+  static thread_local _TCThreadReaper reaper;
+  (void)reaper;
+#endif
+  _tc_thread_cache.reaper_registered = true;
+}
+
+inline void* _tc_allocate(size_t bytes) {
+  if (bytes > _tc_max_small_size) {
+    return _tc_map((bytes + _tc_page_size - 1) & ~(_tc_page_size - 1));
+  }
+  auto c = _tc_size_class(bytes);
+  auto& cache = _tc_thread_cache;
+  auto& list = cache.lists[c];
+  if (list.head == nullptr) {
+    if (!cache.reaper_registered) {
+      _tc_register_thread();
+    }
+    _TCObject* tail;
+    list.count = _tc_central_heap.take(c, _tc_batch_size(c), list.head, tail);
+    if (list.head == nullptr) {
+      return nullptr;
+    }
+  }
+  auto object = list.head;
+  list.head = object->next;
+  list.count--;
+  return object;
+}
+
+inline void _tc_free(void* ptr, size_t bytes) {
+  if (bytes > _tc_max_small_size) {
+    munmap(ptr, (bytes + _tc_page_size - 1) & ~(_tc_page_size - 1));
+    return;
+  }
+  auto c = _tc_size_class(bytes);
+  auto& cache = _tc_thread_cache;
+  if (!cache.reaper_registered) {
+    _tc_register_thread();
+  }
+  auto& list = cache.lists[c];
+  auto object = static_cast<_TCObject*>(ptr);
+  object->next = list.head;
+  list.head = object;
+  auto batch = _tc_batch_size(c);
+  if (++list.count > 2 * batch) {
+    auto tail = list.head;
+    for (size_t i = 1; i < batch; i++) {
+      tail = tail->next;
+    }
+    auto head = list.head;
+    list.head = tail->next;
+    list.count -= batch;
+    _tc_central_heap.give(c, head, tail);
+  }
+}
+
+/// \brief A fast allocator for objects of any size that scales to many
+/// threads.
+///
+/// \see thread_caching_allocator.hpp for how it works.
+template<typename T>
+class ThreadCachingAllocator {
+
+  static inline size_t block_size(size_t sz) {
+    static_assert(alignof(T) <= _tc_page_size, "over-aligned types are not supported");
+    return (sz * sizeof(T) + alignof(T) - 1) & ~(alignof(T) - 1);
+  }
+
+public:
+
+  inline T* allocate(size_t sz) {
+    if (sz == 0) {
+      return nullptr;
+    }
+    return static_cast<T*>(_tc_allocate(block_size(sz)));
+  }
+
+  inline void free(T* ptr, size_t sz) {
+    if (ptr != nullptr) {
+      _tc_free(ptr, block_size(sz));
+    }
+  }
+
+  /// Succeeds without moving the block if it stays in the same size class,
+  /// and lets the kernel move the pages of blocks that are mapped on their
+  /// own.
+  inline T* reallocate(T* ptr, size_t old_sz, size_t new_sz) {
+    static_assert(IsTriviallyRelocatable<T>::value, "reallocate() can only move trivially relocatable elements");
+    auto old_size = block_size(old_sz);
+    auto new_size = block_size(new_sz);
+    if (old_size <= _tc_max_small_size || new_size <= _tc_max_small_size) {
+      if (old_size <= _tc_max_small_size && new_size <= _tc_max_small_size
+          && new_size > 0 && _tc_size_class(old_size) == _tc_size_class(new_size)) {
+        return ptr;
+      }
+      return nullptr;
+    }
+    old_size = (old_size + _tc_page_size - 1) & ~(_tc_page_size - 1);
+    new_size = (new_size + _tc_page_size - 1) & ~(_tc_page_size - 1);
+    if (old_size == new_size) {
+      return ptr;
+    }
+#ifdef MREMAP_MAYMOVE
+    auto new_ptr = mremap(ptr, old_size, new_size, MREMAP_MAYMOVE);
+    return new_ptr == MAP_FAILED ? nullptr : static_cast<T*>(new_ptr);
+#else
+    return nullptr;
+#endif
+  }
+
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_THREAD_CACHING_ALLOCATOR_HPP
@@ -0,0 +1,111 @@
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "zen/dllist.hpp"
+#include "zen/thread_caching_allocator.hpp"
+#include "zen/vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+TEST(ThreadCachingAllocatorTest, SizeClassesCoverEveryRequest) {
+  size_t last_class = 0;
+  for (size_t bytes = 1; bytes <= _tc_max_small_size; bytes++) {
+    auto c = _tc_size_class(bytes);
+    ASSERT_LT(c, _tc_class_count);
+    ASSERT_GE(c, last_class);
+    ASSERT_GE(_tc_class_size(c), bytes);
+    if (c > 1) {
+      ASSERT_LT(_tc_class_size(c - 1), bytes);
+    }
+    last_class = c;
+  }
+  ASSERT_EQ(_tc_class_size(_tc_class_count - 1), _tc_max_small_size);
+}
+
+TEST(ThreadCachingAllocatorTest, AllocatesSmallAndLargeBlocks) {
+  ThreadCachingAllocator<char> allocator;
+  for (size_t size: { 1, 7, 16, 100, 1000, 5000, 100000, 300000, 5000000 }) {
+    auto ptr = allocator.allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % 16, 0);
+    memset(ptr, 0xab, size);
+    allocator.free(ptr, size);
+  }
+  auto ptr = allocator.allocate(100);
+  ASSERT_EQ(allocator.reallocate(ptr, 100, 110), ptr);
+  ASSERT_EQ(allocator.reallocate(ptr, 110, 2000), nullptr);
+  allocator.free(ptr, 110);
+}
+
+TEST(ThreadCachingAllocatorTest, BacksContainers) {
+  Vector<uint64_t, size_t, ThreadCachingAllocator<uint64_t>> v1;
+  DLList<int, size_t, ThreadCachingAllocator<int>> l1;
+  for (uint64_t i = 0; i < 100000; i++) {
+    v1.append(i);
+    l1.append(int(i));
+  }
+  for (uint64_t i = 0; i < 100000; i++) {
+    ASSERT_EQ(v1[i], i);
+  }
+  ASSERT_EQ(l1.size(), 100000);
+  ASSERT_EQ(l1.last(), 99999);
+}
+
+TEST(ThreadCachingAllocatorTest, HandlesBlocksThatMoveBetweenThreads) {
+  ThreadCachingAllocator<uint64_t> allocator;
+  std::vector<std::thread> threads;
+  std::vector<std::vector<uint64_t*>> handoff(4);
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = 0; i < 10000; i++) {
+        auto sz = 2 + i % 64;
+        auto ptr = allocator.allocate(sz);
+        ptr[0] = t;
+        ptr[sz - 1] = sz;
+        if (i % 2 == 0) {
+          handoff[t].push_back(ptr);
+        } else {
+          ASSERT_EQ(ptr[0], t);
+          ASSERT_EQ(ptr[sz - 1], sz);
+          allocator.free(ptr, sz);
+        }
+      }
+    });
+  }
+  for (auto& thread: threads) {
+    thread.join();
+  }
+  threads.clear();
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      auto& ptrs = handoff[(t + 1) % 4];
+      for (size_t i = 0; i < ptrs.size(); i++) {
+        auto sz = 2 + (2 * i) % 64;
+        ASSERT_EQ(ptrs[i][0], (t + 1) % 4);
+        ASSERT_EQ(ptrs[i][sz - 1], sz);
+        allocator.free(ptrs[i], sz);
+      }
+    });
+  }
+  for (auto& thread: threads) {
+    thread.join();
+  }
+}
+
+TEST(ThreadCachingAllocatorTest, FlushesCacheOfThreadThatOnlyFrees) {
+  ThreadCachingAllocator<char> allocator;
+  size_t size = 200000;
+  auto c = _tc_size_class(size);
+  char* ptr = nullptr;
+  std::thread producer([&]() { ptr = allocator.allocate(size); });
+  producer.join();
+  ASSERT_NE(ptr, nullptr);
+  std::thread consumer([&]() { allocator.free(ptr, size); });
+  consumer.join();
+  ASSERT_EQ(reinterpret_cast<char*>(_tc_central_heap.lists[c].head), ptr);
+}
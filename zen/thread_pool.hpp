@@ -0,0 +1,296 @@
+/// \file thread_pool.hpp
+/// \brief A work-stealing pool of threads for running fine-grained tasks.
+
+#ifndef ZEN_THREAD_POOL_HPP
+#define ZEN_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "zen/config.h"
+#include "zen/deque.hpp"
+#include "zen/vector.hpp"
+
+ZEN_NAMESPACE_START
+
+/// \brief A fixed set of threads that execute submitted tasks.
+///
+/// Every worker owns a queue of tasks. A worker takes new tasks from the back
+/// of its own queue, so that recently spawned (and therefore cache-hot) work
+/// is handled first. When its queue runs dry, it steals the oldest task from
+/// the front of another worker's queue.
+///
+/// Threads that are waiting for tasks to finish should do so with
+/// run_until(), which runs queued tasks while waiting, so that nested
+/// parallelism cannot deadlock the pool. TaskGroup does this automatically.
+class ThreadPool {
+public:
+
+  using Task = std::function<void()>;
+
+private:
+
+  struct Worker {
+    std::mutex mutex;
+    Deque<Task> tasks;
+  };
+
+  Vector<std::unique_ptr<Worker>> workers;
+  Vector<std::thread> threads;
+
+  std::mutex sleep_mutex;
+  std::condition_variable sleep_cond;
+  std::atomic<size_t> queued { 0 };
+  std::atomic<size_t> next_worker { 0 };
+  bool stopping = false;
+
+  static inline ThreadPool*& current_pool() {
+    static thread_local ThreadPool* pool = nullptr;
+    return pool;
+  }
+
+  static inline size_t& current_index() {
+    static thread_local size_t index = 0;
+    return index;
+  }
+
+  inline bool pop_from(size_t index, bool from_back, Task& task) {
+    auto& worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.is_empty()) {
+      return false;
+    }
+    task = from_back ? worker.tasks.pop_last() : worker.tasks.pop_first();
+    queued--;
+    return true;
+  }
+
+  inline bool find_task(Task& task) {
+    auto count = workers.size();
+    size_t start;
+    if (current_pool() == this) {
+      start = current_index();
+      if (pop_from(start, true, task)) {
+        return true;
+      }
+    } else {
+      start = next_worker++ % count;
+    }
+    for (size_t i = 1; i <= count; i++) {
+      if (pop_from((start + i) % count, false, task)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  inline void work(size_t index) {
+    current_pool() = this;
+    current_index() = index;
+    Task task;
+    for (;;) {
+      if (find_task(task)) {
+        task();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex);
+      sleep_cond.wait(lock, [this] { return stopping || queued > 0; });
+      if (stopping && queued == 0) {
+        break;
+      }
+    }
+  }
+
+public:
+
+  /// \brief Start a pool with `thread_count` workers.
+  ///
+  /// Passing zero uses one worker per hardware thread.
+  inline ThreadPool(size_t thread_count = 0) {
+    if (thread_count == 0) {
+      thread_count = std::thread::hardware_concurrency();
+      if (thread_count == 0) {
+        thread_count = 1;
+      }
+    }
+    workers.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; i++) {
+      workers.append(std::make_unique<Worker>());
+    }
+    threads.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; i++) {
+      threads.emplace_back([this, i] { work(i); });
+    }
+  }
+
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  /// Runs all tasks that are still queued and then joins the workers.
+  inline ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex);
+      stopping = true;
+    }
+    sleep_cond.notify_all();
+    for (auto& thread: threads) {
+      thread.join();
+    }
+  }
+
+  inline size_t size() const {
+    return workers.size();
+  }
+
+  /// \brief Schedule `task` to be run on one of the workers.
+  inline void submit(Task task) {
+    auto index = current_pool() == this
+      ? current_index()
+      : next_worker++ % workers.size();
+    auto& worker = *workers[index];
+    {
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      worker.tasks.append(std::move(task));
+      queued++;
+    }
+    {
+      // Taking the lock makes sure a worker that is about to sleep sees the
+      // new task.
+      std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    sleep_cond.notify_one();
+  }
+
+  /// \brief Run a single queued task on the calling thread, if there is one.
+  ///
+  /// Returns `false` if no task was found.
+  inline bool try_run_one() {
+    Task task;
+    if (!find_task(task)) {
+      return false;
+    }
+    task();
+    return true;
+  }
+
+  /// \brief Run queued tasks on the calling thread until `done()` returns
+  /// `true`.
+  ///
+  /// When there is nothing to run, the thread sleeps until a task is
+  /// submitted or until wake_all() is called, after which `done()` is checked
+  /// again.
+  template<typename Fn>
+  inline void run_until(Fn done) {
+    Task task;
+    while (!done()) {
+      if (find_task(task)) {
+        task();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex);
+      sleep_cond.wait(lock, [&] { return done() || queued > 0; });
+    }
+  }
+
+  /// \brief Wake up all threads that are sleeping in run_until(), so that
+  /// they check their condition again.
+  inline void wake_all() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    sleep_cond.notify_all();
+  }
+
+};
+
+/// \brief Get the pool that is shared by the parallel algorithms.
+///
+/// The pool is created on first use and has one worker per hardware thread.
+inline ThreadPool& default_thread_pool() {
+  static ThreadPool pool;
+  return pool;
+}
+
+/// \brief A set of tasks that can be waited on together.
+///
+/// ```
+/// TaskGroup group;
+/// group.run([&] { left_result = solve(left); });
+/// group.run([&] { right_result = solve(right); });
+/// group.wait();
+/// ```
+class TaskGroup {
+
+  ThreadPool& pool;
+  std::atomic<size_t> pending { 0 };
+
+public:
+
+  inline TaskGroup(ThreadPool& pool = default_thread_pool()):
+    pool(pool) {}
+
+  TaskGroup(const TaskGroup& other) = delete;
+  TaskGroup& operator=(const TaskGroup& other) = delete;
+
+  inline ~TaskGroup() {
+    wait();
+  }
+
+  template<typename Fn>
+  inline void run(Fn fn) {
+    pending++;
+    // The group may be destroyed as soon as `pending` drops to zero, so the
+    // pool is captured separately.
+    pool.submit([this, &pool = pool, fn = std::move(fn)]() mutable {
+      fn();
+      if (--pending == 0) {
+        pool.wake_all();
+      }
+    });
+  }
+
+  /// \brief Block until all tasks in this group have finished.
+  ///
+  /// While waiting, the calling thread helps out by running queued tasks,
+  /// and sleeps when there are none.
+  inline void wait() {
+    pool.run_until([this] { return pending == 0; });
+  }
+
+};
+
+/// \brief Call `fn(begin, end)` in parallel for consecutive chunks of the
+/// index range `[0, count)`.
+///
+/// Chunks contain at least `grain` indices. If the range is too small to be
+/// split, `fn` is called once on the calling thread.
+template<typename Fn>
+inline void parallel_chunks(size_t count, size_t grain, Fn fn, ThreadPool& pool = default_thread_pool()) {
+  auto workers = pool.size();
+  auto chunk = count / (workers * 4);
+  if (chunk < grain) {
+    chunk = grain;
+  }
+  if (workers <= 1 || count <= chunk) {
+    if (count > 0) {
+      fn(size_t(0), count);
+    }
+    return;
+  }
+  TaskGroup group(pool);
+  size_t begin = chunk;
+  for (; begin < count; begin += chunk) {
+    auto end = begin + chunk < count ? begin + chunk : count;
+    group.run([&fn, begin, end] { fn(begin, end); });
+  }
+  fn(size_t(0), chunk);
+  group.wait();
+}
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_THREAD_POOL_HPP
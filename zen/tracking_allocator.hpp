@@ -0,0 +1,307 @@
+/// \file tracking_allocator.hpp
+/// \brief Attribute heap memory to the parts of a program that use it.
+///
+/// Wrap the allocator of a container in a TrackingAllocator with a tag that
+/// names the subsystem it belongs to:
+///
+/// ```
+/// struct TokenMemory {
+///   static constexpr const char* name = "tokens";
+/// };
+///
+/// Vector<Token, size_t, TrackingAllocator<DefaultAllocator<Token>, TokenMemory>> tokens;
+/// ```
+///
+/// Every tag gets one AllocationStats object that is shared by all
+/// allocators with that tag, regardless of the type they allocate. The
+/// statistics of all tags that were used so far can be read with
+/// allocation_stats_snapshot() or dumped as JSON with
+/// allocation_stats_to_json().
+
+#ifndef ZEN_TRACKING_ALLOCATOR_HPP
+#define ZEN_TRACKING_ALLOCATOR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <type_traits>
+
+#include "zen/config.h"
+#include "zen/allocator.hpp"
+#include "zen/meta.hpp"
+#include "zen/vector.hpp"
+
+ZEN_NAMESPACE_START
+
+/// \brief A copy of the statistics of one tag at some point in time.
+struct AllocationSnapshot {
+
+  /// The amount of size classes. Class `0` counts empty blocks and class
+  /// `i` counts blocks of `2^(i-1)` up to `2^i - 1` bytes. The last class
+  /// also counts everything bigger.
+  static constexpr size_t size_class_count = 48;
+
+  const char* tag;
+  uint64_t allocations;
+  uint64_t reallocations;
+  uint64_t frees;
+  uint64_t total_bytes;
+  uint64_t live_bytes;
+  uint64_t peak_bytes;
+  uint64_t size_classes[size_class_count];
+
+};
+
+/// \brief Get the size class that a block of `bytes` bytes is counted in.
+inline size_t allocation_size_class(size_t bytes) {
+  if (bytes == 0) {
+    return 0;
+  }
+  size_t size_class = 64 - __builtin_clzll(bytes);
+  return size_class < AllocationSnapshot::size_class_count ? size_class : AllocationSnapshot::size_class_count - 1;
+}
+
+/// \brief Counters for all allocations that were made under one tag.
+///
+/// The counters are relaxed atomics, so recording an allocation costs a few
+/// uncontended atomic additions.
+class AllocationStats {
+
+  const char* _tag;
+  AllocationStats* _next;
+
+  alignas(64) std::atomic<uint64_t> _allocations { 0 };
+  std::atomic<uint64_t> _reallocations { 0 };
+  std::atomic<uint64_t> _frees { 0 };
+  std::atomic<uint64_t> _total_bytes { 0 };
+  std::atomic<uint64_t> _live_bytes { 0 };
+  std::atomic<uint64_t> _peak_bytes { 0 };
+  std::atomic<uint64_t> _size_classes[AllocationSnapshot::size_class_count] = {};
+
+  static inline std::atomic<AllocationStats*>& registry() {
+    static std::atomic<AllocationStats*> head { nullptr };
+    return head;
+  }
+
+  inline void grow(size_t bytes) {
+    auto live = _live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    auto peak = _peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !_peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) ;
+  }
+
+public:
+
+  /// \brief Create the counters of a tag and make them visible to
+  /// allocation_stats_snapshot().
+  inline AllocationStats(const char* tag):
+    _tag(tag) {
+      auto& head = registry();
+      _next = head.load(std::memory_order_relaxed);
+      while (!head.compare_exchange_weak(_next, this, std::memory_order_release, std::memory_order_relaxed)) ;
+    }
+
+  AllocationStats(const AllocationStats& other) = delete;
+  AllocationStats& operator=(const AllocationStats& other) = delete;
+
+  /// \brief Get the counters of the first registered tag.
+  static inline AllocationStats* first() {
+    return registry().load(std::memory_order_acquire);
+  }
+
+  inline AllocationStats* next() const {
+    return _next;
+  }
+
+  inline const char* tag() const {
+    return _tag;
+  }
+
+  inline void record_allocation(size_t bytes) {
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    _total_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    _size_classes[allocation_size_class(bytes)].fetch_add(1, std::memory_order_relaxed);
+    grow(bytes);
+  }
+
+  inline void record_reallocation(size_t old_bytes, size_t new_bytes) {
+    _reallocations.fetch_add(1, std::memory_order_relaxed);
+    _size_classes[allocation_size_class(new_bytes)].fetch_add(1, std::memory_order_relaxed);
+    if (new_bytes > old_bytes) {
+      _total_bytes.fetch_add(new_bytes - old_bytes, std::memory_order_relaxed);
+      grow(new_bytes - old_bytes);
+    } else {
+      _live_bytes.fetch_sub(old_bytes - new_bytes, std::memory_order_relaxed);
+    }
+  }
+
+  inline void record_free(size_t bytes) {
+    _frees.fetch_add(1, std::memory_order_relaxed);
+    _live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  /// \brief Copy the counters.
+  ///
+  /// The counters are read one by one while other threads may be
+  /// allocating, so they are only guaranteed to be consistent with each other
+  /// when no allocations happen at the same time.
+  inline AllocationSnapshot snapshot() const {
+    AllocationSnapshot result;
+    result.tag = _tag;
+    result.allocations = _allocations.load(std::memory_order_relaxed);
+    result.reallocations = _reallocations.load(std::memory_order_relaxed);
+    result.frees = _frees.load(std::memory_order_relaxed);
+    result.total_bytes = _total_bytes.load(std::memory_order_relaxed);
+    result.live_bytes = _live_bytes.load(std::memory_order_relaxed);
+    result.peak_bytes = _peak_bytes.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < AllocationSnapshot::size_class_count; i++) {
+      result.size_classes[i] = _size_classes[i].load(std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+};
+
+/// \brief Get the counters of the tag `TagT`.
+template<typename TagT>
+inline AllocationStats& allocation_stats() {
+  static AllocationStats stats(TagT::name);
+  return stats;
+}
+
+/// \brief Take a snapshot of every tag that has been used so far.
+inline Vector<AllocationSnapshot> allocation_stats_snapshot() {
+  Vector<AllocationSnapshot> result;
+  for (auto stats = AllocationStats::first(); stats != nullptr; stats = stats->next()) {
+    result.append(stats->snapshot());
+  }
+  return result;
+}
+
+inline void _append_json_string(std::string& out, const char* str) {
+  out += '"';
+  for (; *str != '\0'; str++) {
+    auto ch = static_cast<unsigned char>(*str);
+    if (ch == '"' || ch == '\\') {
+      out += '\\';
+      out += *str;
+    } else if (ch < 0x20) {
+      const char* digits = "0123456789abcdef";
+      out += "\\u00";
+      out += digits[ch >> 4];
+      out += digits[ch & 15];
+    } else {
+      out += *str;
+    }
+  }
+  out += '"';
+}
+
+/// \brief Write a list of snapshots as a JSON object that maps each tag to
+/// its counters.
+///
+/// Size classes are written as an object that maps the lower bound of each
+/// non-empty class in bytes to its count.
+inline std::string allocation_stats_to_json(Vector<AllocationSnapshot>& snapshots) {
+  std::string out = "{";
+  bool first = true;
+  for (auto& snapshot: snapshots) {
+    if (!first) {
+      out += ',';
+    }
+    first = false;
+    _append_json_string(out, snapshot.tag);
+    out += ":{\"allocations\":" + std::to_string(snapshot.allocations);
+    out += ",\"reallocations\":" + std::to_string(snapshot.reallocations);
+    out += ",\"frees\":" + std::to_string(snapshot.frees);
+    out += ",\"total_bytes\":" + std::to_string(snapshot.total_bytes);
+    out += ",\"live_bytes\":" + std::to_string(snapshot.live_bytes);
+    out += ",\"peak_bytes\":" + std::to_string(snapshot.peak_bytes);
+    out += ",\"size_classes\":{";
+    bool first_class = true;
+    for (size_t i = 0; i < AllocationSnapshot::size_class_count; i++) {
+      if (snapshot.size_classes[i] == 0) {
+        continue;
+      }
+      if (!first_class) {
+        out += ',';
+      }
+      first_class = false;
+      uint64_t lower = i == 0 ? 0 : uint64_t(1) << (i - 1);
+      out += '"' + std::to_string(lower) + "\":" + std::to_string(snapshot.size_classes[i]);
+    }
+    out += "}}";
+  }
+  out += '}';
+  return out;
+}
+
+/// \brief Write the statistics of every tag that has been used so far as
+/// JSON.
+inline std::string allocation_stats_to_json() {
+  auto snapshots = allocation_stats_snapshot();
+  return allocation_stats_to_json(snapshots);
+}
+
+/// \brief An allocator that forwards to `InnerT` and counts every
+/// allocation under the tag `TagT`.
+///
+/// `TagT` must have a member `static constexpr const char* name`. The
+/// wrapper provides reallocate() if `InnerT` does.
+template<typename InnerT, typename TagT>
+class TrackingAllocator {
+
+  template<typename InnerT2, typename TagT2>
+  friend class TrackingAllocator;
+
+  InnerT _inner;
+
+public:
+
+  using Value = std::remove_pointer_t<decltype(declval<InnerT&>().allocate(size_t(0)))>;
+
+  inline TrackingAllocator(InnerT inner = InnerT()):
+    _inner(inner) {}
+
+  inline Value* allocate(size_t sz) {
+    auto ptr = _inner.allocate(sz);
+    if (ptr != nullptr) {
+      allocation_stats<TagT>().record_allocation(sz * sizeof(Value));
+    }
+    return ptr;
+  }
+
+  inline void free(Value* ptr, size_t sz) {
+    if (ptr != nullptr) {
+      allocation_stats<TagT>().record_free(sz * sizeof(Value));
+    }
+    _inner.free(ptr, sz);
+  }
+
+  template<
+    typename I = InnerT,
+    typename = std::enable_if_t<HasReallocate<I>::value>
+  >
+  inline Value* reallocate(Value* ptr, size_t old_sz, size_t new_sz) {
+    auto new_ptr = _inner.reallocate(ptr, old_sz, new_sz);
+    if (new_ptr != nullptr) {
+      allocation_stats<TagT>().record_reallocation(old_sz * sizeof(Value), new_sz * sizeof(Value));
+    }
+    return new_ptr;
+  }
+
+  inline InnerT& inner() {
+    return _inner;
+  }
+
+};
+
+template<typename InnerT, typename TagT, typename U>
+struct RebindAllocator<TrackingAllocator<InnerT, TagT>, U> {
+  using Type = TrackingAllocator<RebindAllocatorT<InnerT, U>, TagT>;
+};
+
+ZEN_NAMESPACE_END
+
+#endif // of #ifndef ZEN_TRACKING_ALLOCATOR_HPP
@@ -0,0 +1,77 @@
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "zen/dllist.hpp"
+#include "zen/tracking_allocator.hpp"
+#include "zen/vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+struct VectorMemory {
+  static constexpr const char* name = "test.vector";
+};
+
+struct ListMemory {
+  static constexpr const char* name = "test.list";
+};
+
+struct QuotedMemory {
+  static constexpr const char* name = "test.\"quoted\"";
+};
+
+static AllocationSnapshot find_snapshot(const char* tag) {
+  for (auto& snapshot: allocation_stats_snapshot()) {
+    if (strcmp(snapshot.tag, tag) == 0) {
+      return snapshot;
+    }
+  }
+  ADD_FAILURE() << "no statistics for " << tag;
+  return AllocationSnapshot {};
+}
+
+TEST(TrackingAllocatorTest, CountsLiveAndPeakBytes) {
+  {
+    Vector<uint64_t, size_t, TrackingAllocator<DefaultAllocator<uint64_t>, VectorMemory>> v1;
+    for (uint64_t i = 0; i < 1000; i++) {
+      v1.append(i);
+    }
+    auto snapshot = find_snapshot("test.vector");
+    ASSERT_GT(snapshot.allocations + snapshot.reallocations, 1);
+    ASSERT_GE(snapshot.live_bytes, 1000 * sizeof(uint64_t));
+    ASSERT_GE(snapshot.peak_bytes, snapshot.live_bytes);
+  }
+  auto snapshot = find_snapshot("test.vector");
+  ASSERT_EQ(snapshot.live_bytes, 0);
+  ASSERT_EQ(snapshot.allocations, snapshot.frees);
+  ASSERT_GE(snapshot.peak_bytes, 1000 * sizeof(uint64_t));
+}
+
+TEST(TrackingAllocatorTest, TracksNodesOfRebindingContainers) {
+  DLList<int, size_t, TrackingAllocator<DefaultAllocator<int>, ListMemory>> l1;
+  for (int i = 0; i < 10; i++) {
+    l1.append(i);
+  }
+  auto snapshot = find_snapshot("test.list");
+  ASSERT_EQ(snapshot.allocations, 10);
+  ASSERT_EQ(snapshot.frees, 0);
+  auto node_size = snapshot.live_bytes / 10;
+  ASSERT_GE(node_size, sizeof(int) + 2 * sizeof(void*));
+  ASSERT_EQ(snapshot.size_classes[allocation_size_class(node_size)], 10);
+  l1.clear();
+  ASSERT_EQ(find_snapshot("test.list").live_bytes, 0);
+}
+
+TEST(TrackingAllocatorTest, CanReportAsJson) {
+  TrackingAllocator<DefaultAllocator<char>, QuotedMemory> allocator;
+  auto ptr = allocator.allocate(3);
+  auto json = allocation_stats_to_json();
+  allocator.free(ptr, 3);
+  ASSERT_EQ(json.front(), '{');
+  ASSERT_EQ(json.back(), '}');
+  ASSERT_NE(json.find("\"test.\\\"quoted\\\"\":{\"allocations\":1,"), std::string::npos);
+  ASSERT_NE(json.find("\"live_bytes\":3,"), std::string::npos);
+  ASSERT_NE(json.find("\"size_classes\":{\"2\":1}"), std::string::npos);
+}
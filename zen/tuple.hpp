@@ -1,31 +1,67 @@
 #ifndef ZEN_TUPLE_HPP
 #define ZEN_TUPLE_HPP
 
+#include <type_traits>
+#include <utility>
+
 #include "zen/config.h"
 #include "zen/meta.hpp"
 
 ZEN_NAMESPACE_START
 
-template<typename T>
-struct IsEmpty;
+template<size_t I, typename ValueT>
+struct _TupleLeaf {
 
-template<size_t I, typename ValueT, bool IsEmpty = IsEmpty<ValueT>::value>
-class _TupleLeaf {
     ValueT value;
+
+    constexpr _TupleLeaf() = default;
+
+    template<typename T>
+    constexpr _TupleLeaf(T&& value):
+      value(std::forward<T>(value)) {}
+
 };
 
 template<size_t ...I>
 struct _TupleIndices {};
 
+template<typename T, size_t ...I>
+_TupleIndices<I...> _make_tuple_indices(Seq<T, I...>);
+
+template<size_t N>
+using _TupleIndicesFor = decltype(_make_tuple_indices(Ascending<size_t, N>()));
+
+struct _TupleInit {};
+
+template<typename TupleT, typename ...Ts>
+struct _IsTupleSelf : False {};
+
+template<typename TupleT, typename T>
+struct _IsTupleSelf<TupleT, T> : Bool<same_as<TupleT, std::decay_t<T>>> {};
+
 template<typename Indices, typename ...Ts>
 struct _TupleImpl;
 
 template<size_t ...Indices, typename ...Ts>
 struct _TupleImpl<_TupleIndices<Indices...>, Ts...> 
-    : public _TupleLeaf<Indices, Ts>... {};
+    : public _TupleLeaf<Indices, Ts>... {
+
+    constexpr _TupleImpl() = default;
+
+    template<typename ...ForwardArgs>
+    constexpr _TupleImpl(_TupleInit, ForwardArgs&& ...args):
+      _TupleLeaf<Indices, Ts>(std::forward<ForwardArgs>(args))... {}
+
+};
 
-template<size_t N, typename T>
-auto get(T value);
+template<typename ...Ts>
+class Tuple;
+
+template<size_t N, typename ...Ts>
+constexpr typename TypePackElement<N, Ts...>::Type& get(Tuple<Ts...>& tuple);
+
+template<size_t N, typename ...Ts>
+constexpr const typename TypePackElement<N, Ts...>::Type& get(const Tuple<Ts...>& tuple);
 
 /**
  * @brief An indexed list of types that can be populated at run-time.
@@ -38,15 +74,31 @@ auto get(T value);
 template<typename ...Ts>
 class Tuple {
 
-    template<size_t N, typename T>
-    friend auto get(T value);
+    template<size_t N, typename ...Us>
+    friend constexpr typename TypePackElement<N, Us...>::Type& get(Tuple<Us...>& tuple);
+
+    template<size_t N, typename ...Us>
+    friend constexpr const typename TypePackElement<N, Us...>::Type& get(const Tuple<Us...>& tuple);
 
-    using Impl = _TupleImpl<Ascending<size_t, sizeof...(Ts)>, Ts...>;
+    using Impl = _TupleImpl<_TupleIndicesFor<sizeof...(Ts)>, Ts...>;
 
     Impl _elements;
 
 public:
 
+    constexpr Tuple() = default;
+
+    template<
+      typename ...ForwardArgs,
+      typename = EnableIfT<
+        sizeof...(ForwardArgs) == sizeof...(Ts)
+        && (sizeof...(Ts) > 0)
+        && !_IsTupleSelf<Tuple, ForwardArgs...>::value
+      >
+    >
+    constexpr Tuple(ForwardArgs&& ...args):
+      _elements(_TupleInit(), std::forward<ForwardArgs>(args)...) {}
+
     template<typename T>
     constexpr auto append(T element) {
       return Tuple<Ts..., T>(get<Ascending<size_t, sizeof...(Ts)>>(), element);
@@ -55,8 +107,15 @@ public:
 };
 
 template<size_t N, typename ...Ts>
-auto get(Tuple<Ts...> tuple) {
-    return static_cast<_TupleLeaf<N, TypePackElement<N, Ts...>>&>(tuple._elements).value;
+constexpr typename TypePackElement<N, Ts...>::Type& get(Tuple<Ts...>& tuple) {
+    using T = typename TypePackElement<N, Ts...>::Type;
+    return static_cast<_TupleLeaf<N, T>&>(tuple._elements).value;
+}
+
+template<size_t N, typename ...Ts>
+constexpr const typename TypePackElement<N, Ts...>::Type& get(const Tuple<Ts...>& tuple) {
+    using T = typename TypePackElement<N, Ts...>::Type;
+    return static_cast<const _TupleLeaf<N, T>&>(tuple._elements).value;
 }
 
 ZEN_NAMESPACE_END
@@ -94,6 +153,11 @@ namespace std {
         static const size_t value = sizeof...(Ts);
     };
 
+    template <size_t N, typename ...Ts>
+    struct tuple_element<N, ::zen::Tuple<Ts...> > {
+        using type = typename ::zen::TypePackElement<N, Ts...>::Type;
+    };
+
 }
 #endif // of #if ZEN_STL
 
@@ -6,7 +6,10 @@
 #include "zen/macros.h"
 #include "zen/range.hpp"
 
+#include <functional>
 #include <initializer_list>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 ZEN_NAMESPACE_START
@@ -32,10 +35,56 @@ void copy(RangeT range, OutIter out) {
   }
 }
 
+/// \brief Grow a container's capacity by a factor of `Num / Den`.
+///
+/// Multiplying the capacity on every reallocation makes appending run in
+/// amortized constant time. A factor of 2 minimizes the amount of
+/// reallocations, while a factor below the golden ratio (such as 3/2) allows
+/// the allocator to reuse previously freed blocks.
+template<size_t Num, size_t Den = 1>
+struct GeometricGrowth {
+
+  static_assert(Num > Den, "the growth factor must be greater than 1");
+
+  /// The capacity that is used when growing an empty container.
+  static constexpr size_t min_capacity = 4;
+
+  /// \brief Calculate the capacity to allocate when `required` elements must
+  /// fit in a buffer that currently holds `capacity` elements.
+  template<typename SizeT>
+  static constexpr SizeT next_capacity(SizeT capacity, SizeT required) {
+    SizeT grown = capacity / Den * Num + capacity % Den * Num / Den;
+    if (grown < min_capacity) {
+      grown = min_capacity;
+    }
+    return grown < required ? required : grown;
+  }
+
+};
+
+using DefaultGrowth = GeometricGrowth<2>;
+
+/// Check whether `range` is a slice of a plain array that overlaps the
+/// elements in `[first, last)`.
+template<typename RangeT, typename T>
+inline bool _range_overlaps(RangeT& range, const T* first, const T* last) {
+  using IterT = std::decay_t<decltype(range.begin())>;
+  if constexpr (std::is_pointer_v<IterT> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<IterT>>, T>) {
+    std::less<const T*> less;
+    return less(range.begin(), last) && less(first, range.end());
+  } else {
+    return false;
+  }
+}
+
+template<typename VectorT, typename RangeT>
+inline typename VectorT::Iter _insert_range(VectorT& vector, typename VectorT::Size index, RangeT& range);
+
 template<
   typename T,
   typename SizeT = size_t,
-  typename AllocatorT = DefaultAllocator<T>
+  typename AllocatorT = DefaultAllocator<T>,
+  typename GrowthT = DefaultGrowth
 >
 class Vector {
 public:
@@ -49,77 +98,308 @@ public:
 
 private:
 
+  template<typename VectorT, typename RangeT>
+  friend typename VectorT::Iter _insert_range(VectorT& vector, typename VectorT::Size index, RangeT& range);
+
   AllocatorT _allocator;
   SizeT _capacity;
   SizeT _sz;
   T* _ptr;
 
+  inline T* allocate(SizeT capacity) {
+    if (capacity == 0) {
+      return nullptr;
+    }
+    auto ptr = _allocator.allocate(capacity);
+    ZEN_ASSERT(ptr != nullptr);
+    return ptr;
+  }
+
+  inline void destroy_all() {
+    for (SizeT i = 0; i < _sz; i++) {
+      _ptr[i].~T();
+    }
+    if (_ptr != nullptr) {
+      _allocator.free(_ptr, _capacity);
+    }
+  }
+
+  /// Resize the buffer in place with the allocator's reallocate(), if it has
+  /// one. Returns `false` if the elements still need to be relocated.
+  inline bool try_reallocate(SizeT new_capacity) {
+    if constexpr (CanReallocate<AllocatorT, T>::value) {
+      if (_ptr != nullptr && new_capacity > 0) {
+        auto new_ptr = _allocator.reallocate(_ptr, _capacity, new_capacity);
+        if (new_ptr != nullptr) {
+          _ptr = new_ptr;
+          _capacity = new_capacity;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /// Move all elements to a new buffer of exactly `new_capacity` elements.
+  inline void relocate(SizeT new_capacity) {
+    if (try_reallocate(new_capacity)) {
+      return;
+    }
+    auto new_ptr = allocate(new_capacity);
+    relocate_n(_ptr, _sz, new_ptr);
+    if (_ptr != nullptr) {
+      _allocator.free(_ptr, _capacity);
+    }
+    _ptr = new_ptr;
+    _capacity = new_capacity;
+  }
+
+  /// Make room for `count` elements at `index`, moving the elements after it
+  /// to the back. The returned slots are uninitialized and must be filled
+  /// before `_sz` is increased.
+  inline T* open_gap(SizeT index, SizeT count) {
+    ZEN_ASSERT(index <= _sz);
+    if (_capacity < _sz + count) {
+      auto new_capacity = GrowthT::next_capacity(_capacity, _sz + count);
+      if (!try_reallocate(new_capacity)) {
+        auto new_ptr = allocate(new_capacity);
+        relocate_n(_ptr, index, new_ptr);
+        relocate_n(_ptr + index, _sz - index, new_ptr + index + count);
+        if (_ptr != nullptr) {
+          _allocator.free(_ptr, _capacity);
+        }
+        _ptr = new_ptr;
+        _capacity = new_capacity;
+        return _ptr + index;
+      }
+    }
+    shift_back_n(_ptr + index, _sz - index, count);
+    return _ptr + index;
+  }
+
 public:
 
-  template<typename RangeT>
-  Vector(std::enable_if_t<IsRange<RangeT>::value, RangeT> range, AllocatorT allocator = AllocatorT()):
+  template<
+    typename RangeT,
+    typename = std::enable_if_t<IsRange<std::decay_t<RangeT>>::value && !std::is_same_v<std::decay_t<RangeT>, Vector>>
+  >
+  Vector(RangeT&& range, AllocatorT allocator = AllocatorT()):
     _allocator(allocator),
-    _capacity(range.size()),
-    _sz(range.size()),
-    _ptr(allocator.allocate(range.size())) {
-      ZEN_ASSERT(_ptr != nullptr);
-      SizeT k = 0;
-      for (auto element: range) {
-        _ptr[k++] = element;
-      }
+    _capacity(0),
+    _sz(0),
+    _ptr(nullptr) {
+      append_range(range);
     }
 
-  inline Vector<SizeT>(SizeT init_capacity = 256, AllocatorT allocator = AllocatorT()):
+  inline Vector(SizeT init_capacity = 0, AllocatorT allocator = AllocatorT()):
     _allocator(allocator),
     _capacity(init_capacity),
     _sz(0),
-    _ptr(allocator.allocate(_capacity)) {
-      ZEN_ASSERT(_ptr != nullptr);
-    }
+    _ptr(allocate(init_capacity)) {}
 
   inline Vector(const Vector& other):
     _allocator(other._allocator),
     _capacity(other._sz),
     _sz(other._sz),
-    _ptr(_allocator.allocate(other._sz)) {
-      ZEN_ASSERT(_ptr != nullptr);
+    _ptr(allocate(other._sz)) {
+      for (SizeT i = 0; i < _sz; i++) {
+        new (_ptr + i) T(other._ptr[i]);
+      }
+    }
+
+  inline Vector(Vector&& other):
+    _allocator(std::move(other._allocator)),
+    _capacity(other._capacity),
+    _sz(other._sz),
+    _ptr(other._ptr) {
+      other._capacity = 0;
+      other._sz = 0;
+      other._ptr = nullptr;
     }
 
   inline Vector(std::initializer_list<T> elements, AllocatorT allocator = AllocatorT()):
     Vector(elements.size(), allocator) {
-      SizeT k = 0;
-      for (auto element: elements) {
-        _ptr[k++] = element;
+      for (auto& element: elements) {
+        new (_ptr + _sz++) T(element);
       }
     }
 
+  inline Vector& operator=(const Vector& other) {
+    if (this != &other) {
+      Vector copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  inline Vector& operator=(Vector&& other) {
+    if (this != &other) {
+      destroy_all();
+      _allocator = std::move(other._allocator);
+      _capacity = other._capacity;
+      _sz = other._sz;
+      _ptr = other._ptr;
+      other._capacity = 0;
+      other._sz = 0;
+      other._ptr = nullptr;
+    }
+    return *this;
+  }
+
+  inline ~Vector() {
+    destroy_all();
+  }
+
+  inline void swap(Vector& other) {
+    ZEN_NAMESPACE::swap(_allocator, other._allocator);
+    ZEN_NAMESPACE::swap(_capacity, other._capacity);
+    ZEN_NAMESPACE::swap(_sz, other._sz);
+    ZEN_NAMESPACE::swap(_ptr, other._ptr);
+  }
+
+  /// \brief Make sure at least `new_capacity` elements fit in this vector
+  /// without reallocating.
+  ///
+  /// When the buffer has to grow, the new capacity is determined by
+  /// `GrowthT`, so that calling this method before every insertion does not
+  /// result in a reallocation each time.
   inline void ensure_capacity(SizeT new_capacity) {
     if (_capacity < new_capacity) {
-      auto new_ptr = _allocator.allocate(new_capacity);
-      copy(make_iter_range(_ptr, _ptr + _sz), new_ptr);
-      _ptr = new_ptr;
+      relocate(GrowthT::next_capacity(_capacity, new_capacity));
     }
   }
 
+  /// \brief Make sure exactly `new_capacity` elements fit in this vector
+  /// without reallocating.
+  ///
+  /// Unlike ensure_capacity(), this method does not apply the growth policy,
+  /// so it is best used when the final size is known up front.
+  inline void reserve(SizeT new_capacity) {
+    if (_capacity < new_capacity) {
+      relocate(new_capacity);
+    }
+  }
+
+  /// \brief Change the amount of elements in this vector.
+  ///
+  /// New elements are value-initialized. Excess elements are destroyed, but
+  /// the capacity of the vector is left untouched.
+  inline void resize(SizeT new_sz) {
+    if (new_sz < _sz) {
+      for (SizeT i = new_sz; i < _sz; i++) {
+        _ptr[i].~T();
+      }
+    } else {
+      ensure_capacity(new_sz);
+      for (SizeT i = _sz; i < new_sz; i++) {
+        new (_ptr + i) T();
+      }
+    }
+    _sz = new_sz;
+  }
+
+  /// \brief Change the amount of elements in this vector, copying `value`
+  /// into each new slot.
+  inline void resize(SizeT new_sz, const T& value) {
+    if (new_sz < _sz) {
+      for (SizeT i = new_sz; i < _sz; i++) {
+        _ptr[i].~T();
+      }
+    } else {
+      if (_capacity < new_sz) {
+        // `value` might live inside this vector
+        T keep = value;
+        ensure_capacity(new_sz);
+        for (SizeT i = _sz; i < new_sz; i++) {
+          new (_ptr + i) T(keep);
+        }
+      } else {
+        for (SizeT i = _sz; i < new_sz; i++) {
+          new (_ptr + i) T(value);
+        }
+      }
+    }
+    _sz = new_sz;
+  }
+
+  /// \brief Change the amount of elements in this vector without
+  /// initializing the new ones.
+  ///
+  /// This is useful when the new elements are about to be overwritten
+  /// anyway, for example by `read()` or `fread()` writing directly into
+  /// data().
+  inline void resize_uninitialized(SizeT new_sz) {
+    static_assert(std::is_trivial_v<T>, "resize_uninitialized() requires a trivial element type");
+    ensure_capacity(new_sz);
+    _sz = new_sz;
+  }
+
   inline T& operator[](SizeT index) {
     ZEN_ASSERT(index >= 0 && index < _sz);
     return _ptr[index];
   }
 
-  inline void append(T element) {
-    ensure_capacity(_sz+1);
-    _ptr[_sz] = element;
-    _sz++;
+  /// \brief Construct a new element at the end of this vector, forwarding
+  /// `args` to its constructor.
+  template<typename ...ForwardArgs>
+  inline T& emplace_back(ForwardArgs&& ...args) {
+    if constexpr (CanReallocate<AllocatorT, T>::value) {
+      if (_capacity < _sz + 1 && _ptr != nullptr) {
+        // The arguments might refer to elements in the old buffer, which
+        // reallocate() invalidates.
+        T element(std::forward<ForwardArgs>(args)...);
+        ensure_capacity(_sz + 1);
+        new (_ptr + _sz) T(std::move(element));
+        return _ptr[_sz++];
+      }
+    }
+    if (_capacity < _sz + 1) {
+      // Construct the new element before relocating, because the arguments
+      // might refer to elements in the old buffer.
+      auto new_capacity = GrowthT::next_capacity(_capacity, _sz + 1);
+      auto new_ptr = allocate(new_capacity);
+      new (new_ptr + _sz) T(std::forward<ForwardArgs>(args)...);
+      relocate_n(_ptr, _sz, new_ptr);
+      if (_ptr != nullptr) {
+        _allocator.free(_ptr, _capacity);
+      }
+      _ptr = new_ptr;
+      _capacity = new_capacity;
+    } else {
+      new (_ptr + _sz) T(std::forward<ForwardArgs>(args)...);
+    }
+    return _ptr[_sz++];
+  }
+
+  inline void append(const T& element) {
+    emplace_back(element);
+  }
+
+  inline void append(T&& element) {
+    emplace_back(std::move(element));
+  }
+
+  /// \brief Copy all elements of `range` to the end of this vector.
+  ///
+  /// The vector is reallocated at most once.
+  template<typename RangeT>
+  inline void append_range(RangeT&& range) {
+    insert(end(), range);
+  }
+
+  /// \brief Copy all elements of `range` into this vector, right before `pos`.
+  ///
+  /// The vector is reallocated at most once. Returns an iterator to the
+  /// first inserted element. `range` may refer to elements of this vector.
+  template<typename RangeT>
+  inline Iter insert(Iter pos, RangeT&& range) {
+    static_assert(IsRange<std::decay_t<RangeT>>::value, "insert() expects a range of elements");
+    ZEN_ASSERT(pos >= begin() && pos <= end());
+    return _insert_range(*this, SizeT(pos - _ptr), range);
   }
 
   inline void prepend(T element) {
-    auto new_capacity = _capacity + 1;
-    if (_capacity < new_capacity) {
-      auto new_ptr = _allocator.allocate(new_capacity);
-      copy(make_iter_range(_ptr, _ptr + _sz), new_ptr+1);
-      _ptr = new_ptr;
-    }
-    _ptr[0] = element;
+    new (open_gap(0, 1)) T(std::move(element));
     _sz++;
   }
 
@@ -127,20 +407,64 @@ public:
     return _capacity;
   }
 
+  inline AllocatorT allocator() const {
+    return _allocator;
+  }
+
+  inline T* data() {
+    return _ptr;
+  }
+
+  inline const T* data() const {
+    return _ptr;
+  }
+
   inline Iter begin() {
     return _ptr;
   }
 
+  inline const T* begin() const {
+    return _ptr;
+  }
+
   inline Iter end() {
     return _ptr + _sz;
   }
 
+  inline const T* end() const {
+    return _ptr + _sz;
+  }
+
   inline SizeT size() const {
     return _sz;
   }
 
 };
 
+/// Copy `range` into `vector`, right before `index`. Shared by the vectors
+/// that provide open_gap().
+template<typename VectorT, typename RangeT>
+inline typename VectorT::Iter _insert_range(VectorT& vector, typename VectorT::Size index, RangeT& range) {
+  using T = typename VectorT::Value;
+  typename VectorT::Size count = range_size(range);
+  if (count == 0) {
+    return vector._ptr + index;
+  }
+  if (_range_overlaps(range, vector._ptr, vector._ptr + vector._sz)) {
+    // Opening the gap moves or frees the elements of the range, so they are
+    // copied out first.
+    Vector<T, typename VectorT::Size, decltype(vector._allocator)> copy(count, vector._allocator);
+    copy.append_range(range);
+    return _insert_range(vector, index, copy);
+  }
+  auto gap = vector.open_gap(index, count);
+  for (auto&& element: range) {
+    new (gap++) T(element);
+  }
+  vector._sz += count;
+  return vector._ptr + index;
+}
+
 ZEN_NAMESPACE_END
 
 #endif // ZEN_VECTOR_HPP
@@ -0,0 +1,56 @@
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "zen/vector.hpp"
+
+using namespace ZEN_NAMESPACE;
+
+using Clock = std::chrono::steady_clock;
+
+static const std::size_t element_count = 10'000'000;
+static const int repetitions = 5;
+
+template<typename Fn>
+double measure(Fn fn) {
+  double best = 0;
+  for (int i = 0; i < repetitions; i++) {
+    auto start = Clock::now();
+    auto checksum = fn();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    if (checksum != element_count) {
+      std::fprintf(stderr, "unexpected number of elements: %zu\n", checksum);
+    }
+    double throughput = element_count / elapsed.count();
+    if (throughput > best) {
+      best = throughput;
+    }
+  }
+  return best;
+}
+
+int main() {
+
+  auto zen_vector = measure([] {
+    Vector<int> v(0);
+    for (std::size_t i = 0; i < element_count; i++) {
+      v.append(i);
+    }
+    return v.size();
+  });
+
+  auto std_vector = measure([] {
+    std::vector<int> v;
+    for (std::size_t i = 0; i < element_count; i++) {
+      v.push_back(i);
+    }
+    return v.size();
+  });
+
+  std::printf("append throughput (%zu elements, best of %d)\n", element_count, repetitions);
+  std::printf("  zen::Vector  %8.1f M/s\n", zen_vector / 1e6);
+  std::printf("  std::vector  %8.1f M/s\n", std_vector / 1e6);
+
+  return 0;
+}
@@ -1,10 +1,25 @@
 
 #include "gtest/gtest.h"
 
+#include <string>
+
 #include "zen/vector.hpp"
 
 using namespace ZEN_NAMESPACE;
 
+static std::size_t reallocation_count = 0;
+
+template<typename T>
+class ReallocatingAllocator : public SystemAllocator<T> {
+public:
+
+  inline T* reallocate(T* ptr, size_t old_sz, size_t new_sz) {
+    reallocation_count++;
+    return SystemAllocator<T>::reallocate(ptr, old_sz, new_sz);
+  }
+
+};
+
 TEST(VectorTest, GrowsWhenInsertingElements) {
   Vector<int> v1(4);
   ASSERT_EQ(v1.capacity(), 4);
@@ -22,3 +37,186 @@ TEST(VectorTest, GrowsWhenInsertingElements) {
   ASSERT_EQ(v1[5], 6);
 }
 
+TEST(VectorTest, GrowsGeometrically) {
+  Vector<int> v1(0);
+  ASSERT_EQ(v1.capacity(), 0);
+  std::size_t reallocations = 0;
+  std::size_t last_capacity = v1.capacity();
+  for (int i = 0; i < 10000; i++) {
+    v1.append(i);
+    if (v1.capacity() != last_capacity) {
+      reallocations++;
+      last_capacity = v1.capacity();
+    }
+  }
+  ASSERT_EQ(v1.size(), 10000);
+  ASSERT_LE(reallocations, 20);
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(v1[i], i);
+  }
+}
+
+TEST(VectorTest, CanUseCustomGrowthFactor) {
+  Vector<int, size_t, DefaultAllocator<int>, GeometricGrowth<3, 2>> v1(8);
+  for (int i = 0; i < 9; i++) {
+    v1.append(i);
+  }
+  ASSERT_EQ(v1.capacity(), 12);
+}
+
+TEST(VectorTest, RelocatesNonTrivialElements) {
+  Vector<std::string> v1(1);
+  v1.append("a fairly long string that does not fit in SSO");
+  v1.append("b");
+  v1.prepend("c");
+  v1.append("d");
+  ASSERT_EQ(v1.size(), 4);
+  ASSERT_EQ(v1[0], "c");
+  ASSERT_EQ(v1[1], "a fairly long string that does not fit in SSO");
+  ASSERT_EQ(v1[2], "b");
+  ASSERT_EQ(v1[3], "d");
+}
+
+TEST(VectorTest, PrependsWithinCapacity) {
+  Vector<int> v1(8);
+  v1.append(2);
+  v1.append(3);
+  v1.prepend(1);
+  ASSERT_EQ(v1.capacity(), 8);
+  ASSERT_EQ(v1[0], 1);
+  ASSERT_EQ(v1[1], 2);
+  ASSERT_EQ(v1[2], 3);
+}
+
+TEST(VectorTest, CopiesElements) {
+  Vector<std::string> v1 { "foo", "bar" };
+  Vector<std::string> v2(v1);
+  v1[0] = "baz";
+  ASSERT_EQ(v2.size(), 2);
+  ASSERT_EQ(v2[0], "foo");
+  ASSERT_EQ(v2[1], "bar");
+  v2 = v1;
+  ASSERT_EQ(v2[0], "baz");
+}
+
+TEST(VectorTest, CanEmplaceElements) {
+  Vector<std::string> v1;
+  v1.emplace_back(3, 'a');
+  v1.emplace_back("bc");
+  for (int i = 0; i < 10; i++) {
+    v1.emplace_back(v1[0]);
+  }
+  ASSERT_EQ(v1.size(), 12);
+  ASSERT_EQ(v1[0], "aaa");
+  ASSERT_EQ(v1[1], "bc");
+  ASSERT_EQ(v1[11], "aaa");
+}
+
+TEST(VectorTest, AppendsRangeWithSingleReallocation) {
+  int input[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+  Vector<int> v1(2);
+  v1.append(0);
+  v1.append_range(make_iter_range(input, input + 10));
+  ASSERT_EQ(v1.size(), 11);
+  ASSERT_EQ(v1.capacity(), 11);
+  for (int i = 0; i < 11; i++) {
+    ASSERT_EQ(v1[i], i);
+  }
+  Vector<int> v2(v1);
+  ASSERT_EQ(v2.size(), 11);
+  Vector<int> v3(make_iter_range(input, input + 3));
+  ASSERT_EQ(v3.size(), 3);
+  ASSERT_EQ(v3[2], 3);
+}
+
+TEST(VectorTest, CanInsertRangeInMiddle) {
+  std::string input[] = { "b", "c" };
+  Vector<std::string> v1 { "a", "d" };
+  auto pos = v1.insert(v1.begin() + 1, make_iter_range(input, input + 2));
+  ASSERT_EQ(*pos, "b");
+  ASSERT_EQ(v1.size(), 4);
+  v1.insert(v1.begin() + 1, make_iter_range(input, input + 2));
+  ASSERT_EQ(v1.size(), 6);
+  ASSERT_EQ(v1[0], "a");
+  ASSERT_EQ(v1[1], "b");
+  ASSERT_EQ(v1[2], "c");
+  ASSERT_EQ(v1[3], "b");
+  ASSERT_EQ(v1[4], "c");
+  ASSERT_EQ(v1[5], "d");
+}
+
+TEST(VectorTest, CanInsertRangeOfItself) {
+  Vector<int> v1 { 1, 2, 3, 4 };
+  v1.append_range(make_iter_range(v1.begin(), v1.end()));
+  ASSERT_EQ(v1.size(), 8);
+  for (int i = 0; i < 8; i++) {
+    ASSERT_EQ(v1[i], i % 4 + 1);
+  }
+  v1.append_range(v1);
+  ASSERT_EQ(v1.size(), 16);
+  ASSERT_EQ(v1[15], 4);
+  Vector<std::string> v2 { "a", "b", "c" };
+  v2.reserve(10);
+  v2.insert(v2.begin(), make_iter_range(v2.begin() + 1, v2.end()));
+  ASSERT_EQ(v2.size(), 5);
+  ASSERT_EQ(v2[0], "b");
+  ASSERT_EQ(v2[1], "c");
+  ASSERT_EQ(v2[2], "a");
+  ASSERT_EQ(v2[3], "b");
+  ASSERT_EQ(v2[4], "c");
+}
+
+TEST(VectorTest, CanReserveAndResize) {
+  Vector<int> v1;
+  v1.reserve(100);
+  ASSERT_EQ(v1.capacity(), 100);
+  ASSERT_EQ(v1.size(), 0);
+  v1.resize(10);
+  ASSERT_EQ(v1.size(), 10);
+  ASSERT_EQ(v1[9], 0);
+  v1.resize(20, 7);
+  ASSERT_EQ(v1[9], 0);
+  ASSERT_EQ(v1[10], 7);
+  v1.resize(5);
+  ASSERT_EQ(v1.size(), 5);
+  ASSERT_EQ(v1.capacity(), 100);
+}
+
+TEST(VectorTest, CanResizeUninitialized) {
+  const char input[] = "hello";
+  Vector<char> v1;
+  v1.resize_uninitialized(5);
+  memcpy(v1.data(), input, 5);
+  ASSERT_EQ(v1.size(), 5);
+  ASSERT_EQ(v1[0], 'h');
+  ASSERT_EQ(v1[4], 'o');
+}
+
+TEST(VectorTest, GrowsWithReallocateForTrivialElements) {
+  reallocation_count = 0;
+  Vector<int, size_t, ReallocatingAllocator<int>> v1;
+  for (int i = 0; i < 100; i++) {
+    v1.append(i);
+  }
+  v1.prepend(-1);
+  v1.append(v1[0]);
+  ASSERT_GT(reallocation_count, 0);
+  ASSERT_EQ(v1.size(), 102);
+  ASSERT_EQ(v1[0], -1);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(v1[i+1], i);
+  }
+  ASSERT_EQ(v1[101], -1);
+}
+
+TEST(VectorTest, DoesNotReallocateNonTrivialElements) {
+  static_assert(!CanReallocate<ReallocatingAllocator<std::string>, std::string>::value);
+  static_assert(CanReallocate<SystemAllocator<int>, int>::value);
+  reallocation_count = 0;
+  Vector<std::string, size_t, ReallocatingAllocator<std::string>> v1;
+  for (int i = 0; i < 100; i++) {
+    v1.append(std::to_string(i));
+  }
+  ASSERT_EQ(reallocation_count, 0);
+  ASSERT_EQ(v1[99], "99");
+}